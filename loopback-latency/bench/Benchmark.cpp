@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "Benchmark.h"
+#include "Console.h"
+#include "DurationList.h"
+
+namespace Benchmark
+{
+
+static double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+Runner::Runner(const Options& options)
+    : m_options(options)
+{
+}
+
+void Runner::Run(const std::string& name, const Body& body)
+{
+    Run(name, Body(), body);
+}
+
+std::chrono::nanoseconds Runner::Sample(const Body& setup, const Body& body, size_t iterations) const
+{
+    if (setup)
+        setup(iterations);
+    auto start = Clock::now();
+    body(iterations);
+    return Clock::now() - start;
+}
+
+void Runner::Run(const std::string& name, const Body& setup, const Body& body, size_t maxIterations)
+{
+    if (name.find(m_options.filter) == std::string::npos)
+        return;
+
+    // Double the iterations until a sample takes the minimum sample time,
+    // which also warms up the caches and the allocator.
+    size_t iterations = 1;
+    while (Sample(setup, body, iterations) < m_options.minSampleTime && iterations < maxIterations)
+        iterations *= 2;
+
+    std::vector<double> times;
+    for (size_t i = 0; i < m_options.samples; i++)
+        times.push_back((double)Sample(setup, body, iterations).count() / iterations);
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = times.size();
+    result.median = Median(times);
+    std::vector<double> deviations;
+    for (double t : times)
+        deviations.push_back(std::fabs(t - result.median));
+    result.mad = Median(deviations);
+    std::sort(times.begin(), times.end());
+    result.min = times.front();
+    result.p90 = times[std::min(times.size() - 1, times.size() * 9 / 10)];
+    result.max = times.back();
+    m_results.push_back(result);
+
+    Log(std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+        << "median = " << std::setw(10) << result.median << " ns, "
+        << "mad = " << std::setw(8) << result.mad << ", "
+        << "min = " << std::setw(10) << result.min << ", "
+        << "max = " << std::setw(10) << result.max << std::defaultfloat);
+}
+
+void Runner::WriteCSV(std::ostream& o) const
+{
+    o << "Benchmark,Iterations,Samples,Median (ns),MAD (ns),Min (ns),P90 (ns),Max (ns)" << std::endl
+      << std::fixed << std::setprecision(1);
+    for (const auto& r : m_results)
+    {
+        o << r.name << "," << r.iterations << "," << r.samples << "," << r.median << ","
+          << r.mad << "," << r.min << "," << r.p90 << "," << r.max << std::endl;
+    }
+}
+
+} // namespace Benchmark
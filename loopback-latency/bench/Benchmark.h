@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times the tool's own measurement path. Each benchmark is a function that
+// performs a given number of iterations of an operation; the number of
+// iterations per sample is calibrated so that each sample runs for at least
+// the minimum sample time, and the time per iteration is reported as the
+// median and median absolute deviation of the samples so that a few samples
+// that are preempted do not skew the results.
+namespace Benchmark
+{
+
+struct Options
+{
+    Options()
+        : samples(31)
+        , minSampleTime(std::chrono::milliseconds(10))
+    {}
+
+    size_t samples;
+    std::chrono::nanoseconds minSampleTime;
+
+    // Only the benchmarks whose names contain this string are run.
+    std::string filter;
+};
+
+// The times per iteration of a benchmark, in nanoseconds.
+struct Result
+{
+    std::string name;
+    size_t iterations;
+    size_t samples;
+    double median;
+    double mad;
+    double min;
+    double p90;
+    double max;
+};
+
+class Runner
+{
+public:
+
+    using Body = std::function<void(size_t iterations)>;
+
+    Runner(const Options& options);
+
+    // The largest number of iterations that a sample is calibrated to.
+    static constexpr size_t MAX_ITERATIONS = 1 << 24;
+
+    // Runs a benchmark. The setup function, if any, is called before each
+    // sample (outside of the timed region) with the number of iterations that
+    // the body will perform. Benchmarks whose iterations accumulate memory
+    // can limit the iterations of each sample.
+    void Run(const std::string& name, const Body& body);
+    void Run(const std::string& name, const Body& setup, const Body& body,
+             size_t maxIterations = MAX_ITERATIONS);
+
+    const std::vector<Result>& Results() const { return m_results; }
+
+    // Writes the results as a CSV file with a row per benchmark.
+    void WriteCSV(std::ostream& o) const;
+
+private:
+
+    std::chrono::nanoseconds Sample(const Body& setup, const Body& body, size_t iterations) const;
+
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+// Keeps the compiler from optimizing away a value that is otherwise unused.
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Benchmark
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+
+#include "AsyncLog.h"
+#include "Benchmark.h"
+#include "Console.h"
+#include "CudaUtils.h"
+#include "ExternalSource.h"
+#include "Producer.h"
+#include "StageExport.h"
+
+using namespace Benchmark;
+
+namespace
+{
+
+// The backlogs (frames in flight) that frames are looked up from.
+constexpr size_t BACKLOGS[] = { 1, 4, 16, 64, 256 };
+
+// The largest number of frames started by each sample of the start frame
+// benchmark, which are all kept in flight until the sample ends.
+constexpr size_t MAX_STARTED_FRAMES = 4096;
+
+// The number of frames in the DurationList summaries (10 minutes at 60Hz)
+// and in the written trace.
+constexpr size_t SUMMARY_FRAMES = 36000;
+constexpr size_t TRACE_FRAMES = 1000;
+
+// A producer without a device that exposes the frame bookkeeping and host
+// rendering used by the real producers.
+class BenchProducer : public Producer
+{
+public:
+
+    BenchProducer(const TestFormat& format)
+        : Producer(format, 0)
+    {}
+
+    bool Initialize() override { return true; }
+    void Close() override {}
+
+    using Producer::StartFrame;
+    using Producer::InitializeContent;
+    using Producer::RenderFrameHost;
+
+protected:
+
+    void StreamThread() override {}
+
+    std::ostream& Dump(std::ostream& o) const override
+    {
+        o << "Benchmark" << std::endl;
+        return o;
+    }
+};
+
+// Returns a frame with every core marker recorded a microsecond apart.
+std::shared_ptr<Frame> RecordedFrame(uint32_t number)
+{
+    auto frame(std::make_shared<Frame>(number));
+    Timestamp t = Timestamp::Now();
+    for (int m = MARKER_PROCESSING_START; m < MARKER_CORE_COUNT; m++)
+    {
+        frame->Record((MarkerId)m, t);
+        t.time += Microseconds(1);
+    }
+    return frame;
+}
+
+struct BenchmarkOptions
+{
+    BenchmarkOptions()
+        : format(FORMAT_1080_RGBA_60)
+        , gpu(true)
+    {}
+
+    Options runner;
+    TestFormat format;
+    bool gpu;
+    std::string outputFilename;
+};
+
+#define USAGE_ERROR(x) \
+{ \
+    Error(x); \
+    exit(1); \
+}
+
+void PrintUsage()
+{
+    Log("Usage: loopback-latency-bench [options]" << std::endl <<
+        "  -f {pixfmt}      The pixel format of the frames: rgba, uyvy, yuyv, nv12," << std::endl <<
+        "                   rgb10a2, v210 or p010 (default: rgba)" << std::endl <<
+        "  --size {w}x{h}   The size of the frames (default: 1920x1080)" << std::endl <<
+        "  --samples {n}    The number of samples of each benchmark (default: 31)" << std::endl <<
+        "  --min-time {us}  The minimum time of each sample (default: 10000)" << std::endl <<
+        "  --filter {x}     Only run the benchmarks whose names contain the given string" << std::endl <<
+        "  --gpu {x}        Whether to run the benchmarks that use the GPU (default: 1)" << std::endl <<
+        "  -o {filename}    The path to write the results as a CSV file.");
+}
+
+void ParseArguments(int argc, char* argv[], BenchmarkOptions* opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+        {
+            PrintUsage();
+            exit(0);
+        }
+        else if (!strcmp(argv[i], "-f"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -f (pixel format) option.")
+            PixelFormat pixelFormat = ParsePixelFormat(argv[i]);
+            if (pixelFormat == PIXEL_FORMAT_UNKNOWN)
+                USAGE_ERROR("Invalid value for -f (pixel format) option: " << argv[i])
+            opts->format = opts->format.WithPixelFormat(pixelFormat);
+        }
+        else if (!strcmp(argv[i], "--size"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --size (frame size) option.")
+            unsigned long width, height;
+            int length = 0;
+            if (sscanf(argv[i], "%lux%lu%n", &width, &height, &length) != 2 ||
+                length != (int)strlen(argv[i]) || !width || !height)
+                USAGE_ERROR("Invalid value for --size (frame size) option: " << argv[i])
+            opts->format = TestFormat(width, height, opts->format.pixelFormat, opts->format.frameRate);
+        }
+        else if (!strcmp(argv[i], "--samples"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --samples (sample count) option.")
+            opts->runner.samples = strtoul(argv[i], nullptr, 10);
+            if (!opts->runner.samples)
+                USAGE_ERROR("Invalid value for --samples (sample count) option: " << argv[i])
+        }
+        else if (!strcmp(argv[i], "--min-time"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --min-time (minimum sample time) option.")
+            opts->runner.minSampleTime = Microseconds(strtoul(argv[i], nullptr, 10));
+        }
+        else if (!strcmp(argv[i], "--filter"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --filter (benchmark filter) option.")
+            opts->runner.filter = argv[i];
+        }
+        else if (!strcmp(argv[i], "--gpu"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --gpu (GPU benchmarks) option.")
+            opts->gpu = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "-o"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -o (output CSV file) option.")
+            opts->outputFilename = argv[i];
+        }
+        else
+        {
+            PrintUsage();
+            USAGE_ERROR("Unknown option: " << argv[i])
+        }
+    }
+}
+
+void RunProducerBenchmarks(Runner& runner, const TestFormat& format)
+{
+    // Starting a frame allocates it and adds it to the frames in flight. A new
+    // producer is used for each sample so that the list does not keep growing.
+    std::unique_ptr<BenchProducer> producer;
+    runner.Run("producer/start-frame",
+        [&](size_t) { producer.reset(new BenchProducer(format)); },
+        [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                DoNotOptimize(producer->StartFrame());
+        },
+        MAX_STARTED_FRAMES);
+
+    // Looking up a frame decodes its ID and searches the frames in flight. The
+    // oldest frame is found first, while a buffer that does not identify any
+    // frame (a glitch) searches the whole backlog. Neither changes the list.
+    std::vector<uint8_t> buffer(format.totalBytes);
+    std::vector<uint8_t> unknown(format.totalBytes, 0);
+    for (size_t backlog : BACKLOGS)
+    {
+        BenchProducer p(format);
+        std::shared_ptr<Frame> oldest;
+        for (size_t i = 0; i < backlog; i++)
+        {
+            auto frame = p.StartFrame();
+            if (!oldest)
+                oldest = frame;
+        }
+        WritePattern(buffer.data(), p.Pattern(*oldest));
+
+        runner.Run("producer/get-frame/oldest/" + std::to_string(backlog), [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                DoNotOptimize(p.GetFrame(buffer.data()));
+        });
+        runner.Run("producer/get-frame/miss/" + std::to_string(backlog), [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                DoNotOptimize(p.GetFrame(unknown.data()));
+        });
+    }
+
+    // An external source numbers each capture by its driver sequence number
+    // instead, and optionally decodes the embedded frame ID. Each capture is
+    // kept, so the captures are reset for each sample.
+    for (bool decodeIds : { false, true })
+    {
+        ExternalSource source(format, decodeIds);
+        DriverCapture driver;
+        driver.hasSequence = true;
+        runner.Run(std::string("producer/identify-capture/external") + (decodeIds ? "/decode-id" : ""),
+            [&](size_t) { source.ResetCaptures(); },
+            [&](size_t iterations)
+            {
+                for (size_t i = 0; i < iterations; i++)
+                {
+                    driver.sequence++;
+                    DoNotOptimize(source.IdentifyCapture(buffer.data(), driver));
+                }
+            },
+            MAX_STARTED_FRAMES);
+    }
+}
+
+void RunFrameBenchmarks(Runner& runner)
+{
+    Frame frame(0);
+    runner.Run("frame/record", [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            frame.Record(MARKER_RENDER_START);
+        DoNotOptimize(frame);
+    });
+
+    // Thread sampling adds the thread CPU time and context switches to each
+    // timestamp (see --cpu-stats).
+    ThreadSample::Enable(true);
+    runner.Run("frame/record/cpu-stats", [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            frame.Record(MARKER_RENDER_START);
+        DoNotOptimize(frame);
+    });
+    ThreadSample::Enable(false);
+
+    auto recorded = RecordedFrame(0);
+    runner.Run("frame/stage-markers", [&](size_t iterations)
+    {
+        size_t stages = StageRegistry::Markers().size();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            MarkerId start, end;
+            DoNotOptimize(recorded->StageMarkers(1 + i % (stages - 1), &start, &end));
+        }
+    });
+}
+
+void RunDurationListBenchmarks(Runner& runner)
+{
+    std::unique_ptr<DurationList> list;
+    runner.Run("duration-list/append",
+        [&](size_t) { list.reset(new DurationList()); },
+        [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                list->Append(Microseconds(i));
+        });
+
+    DurationList summary;
+    for (size_t i = 0; i < SUMMARY_FRAMES; i++)
+        summary.Append(Microseconds(16000 + (i * 7919) % 2000));
+    runner.Run("duration-list/summary/" + std::to_string(SUMMARY_FRAMES), [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            DoNotOptimize(summary.Summary());
+    });
+}
+
+void RunExportBenchmarks(Runner& runner)
+{
+    auto frame = RecordedFrame(0);
+    std::ostringstream csv;
+    runner.Run("export/csv-stage-times",
+        [&](size_t) { csv.str(""); },
+        [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                StageExport::WriteStageTimes(csv, *frame);
+        });
+
+    std::vector<std::shared_ptr<Frame>> frames;
+    for (size_t i = 0; i < TRACE_FRAMES; i++)
+        frames.push_back(RecordedFrame(i));
+    runner.Run("export/trace/" + std::to_string(TRACE_FRAMES), [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            StageExport::WriteTrace("/dev/null", frames);
+    });
+}
+
+void RunHostContentBenchmarks(Runner& runner, const TestFormat& format)
+{
+    std::vector<uint8_t> buffer(format.totalBytes);
+    for (int c = CONTENT_SOLID; c < CONTENT_TYPE_COUNT; c++)
+    {
+        // The tile content needs an image file, so it is not measured.
+        ContentType type = (ContentType)c;
+        if (type == CONTENT_TILE)
+            continue;
+
+        BenchProducer producer(format);
+        producer.SetContent(type, 0, "");
+        if (!producer.InitializeContent(true))
+            continue;
+        Frame frame(0);
+        runner.Run(std::string("host/fill/") + ContentTypeName(type), [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                producer.RenderFrameHost(frame, buffer.data());
+        });
+    }
+}
+
+void RunGPUBenchmarks(Runner& runner, const TestFormat& format)
+{
+    void* cudaBuffer = CudaAlloc(format.totalBytes);
+    void* cudaExpected = CudaAlloc(format.totalBytes);
+    uint8_t* cudaLineFlags = (uint8_t*)CudaAlloc(format.height);
+    if (!cudaBuffer || !cudaExpected || !cudaLineFlags)
+    {
+        Error("Failed to allocate the GPU benchmark buffers.");
+        return;
+    }
+    std::vector<uint8_t> lineFlags(format.height);
+
+    BenchProducer producer(format);
+    Frame frame(0);
+    FramePattern pattern(producer.Pattern(frame));
+    runner.Run("gpu/fill/solid", [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            CudaWritePattern(cudaBuffer, pattern);
+    });
+    runner.Run("gpu/verify/solid", [&](size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+            CudaVerifyPattern(cudaBuffer, pattern, format.stride, format.ActiveLineBytes(), format.height,
+                              cudaLineFlags, lineFlags.data());
+    });
+
+    // Frames with content are compared with a copy that is rendered again.
+    BenchProducer gradient(format);
+    gradient.SetContent(CONTENT_GRADIENT, 0, "");
+    if (gradient.InitializeContent(false))
+    {
+        runner.Run("gpu/fill/gradient", [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+                gradient.RenderFrame(frame, cudaBuffer);
+        });
+        gradient.RenderFrame(frame, cudaExpected);
+        runner.Run("gpu/verify/gradient", [&](size_t iterations)
+        {
+            for (size_t i = 0; i < iterations; i++)
+            {
+                CudaVerifyFrame(cudaBuffer, cudaExpected, pattern, format.stride, format.ActiveLineBytes(),
+                                format.height, cudaLineFlags, lineFlags.data());
+            }
+        });
+    }
+
+    CudaFree(cudaLineFlags);
+    CudaFree(cudaExpected);
+    CudaFree(cudaBuffer);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions opts;
+    ParseArguments(argc, argv, &opts);
+
+    AsyncLog::Start();
+    Log("Format: " << opts.format << std::endl <<
+        "Instrumentation: " << InstrumentationName(INSTRUMENTATION) << std::endl);
+
+    Runner runner(opts.runner);
+    RunProducerBenchmarks(runner, opts.format);
+    RunFrameBenchmarks(runner);
+    RunDurationListBenchmarks(runner);
+    RunExportBenchmarks(runner);
+    RunHostContentBenchmarks(runner, opts.format);
+    if (opts.gpu)
+    {
+        CudaInitialize();
+        RunGPUBenchmarks(runner, opts.format);
+    }
+    AsyncLog::Stop();
+
+    if (opts.outputFilename.size() > 0)
+    {
+        std::ofstream file(opts.outputFilename);
+        if (!file.is_open())
+        {
+            Error("Could not open file for output: " << opts.outputFilename);
+            return 1;
+        }
+        file << "# format=" << opts.format << std::endl
+             << "# instrumentation=" << InstrumentationName(INSTRUMENTATION) << std::endl;
+        runner.WriteCSV(file);
+        Log(std::endl << "Results written to '" << opts.outputFilename << "'");
+    }
+
+    return 0;
+}
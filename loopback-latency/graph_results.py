@@ -46,11 +46,18 @@ parser.add_argument('--title', metavar='text', type=str,
                     help='text to use for the graph title')
 args = parser.parse_args()
 
-# Read the input CSV file.
+# Read the input CSV file, skipping the comment lines that tag the results
+# other than the one that gives the side of each stage column.
 rows = []
+sides = None
 with open(args.file) as csvfile:
-    reader = csv.reader(csvfile)
-    for row in reader:
+    lines = []
+    for line in csvfile:
+        if line.startswith('# stages='):
+            sides = [stage.split(':')[1] for stage in line.strip()[len('# stages='):].split(',')]
+        if not line.startswith('#'):
+            lines.append(line)
+    for row in csv.reader(lines):
         rows.append(row)
 
 # Extract the labels from the first row.
@@ -59,7 +66,11 @@ labels = rows[0][4:]
 # Extract the frame numbers and times for the requested frames.
 data = np.transpose(rows[args.first:args.frames + args.first])
 frame_numbers = data[0]
-times = np.array(data[4:], dtype=int)
+times = np.array([[int(t) if t else 0 for t in stage] for stage in data[4:]])
+
+# Results written before the stages were tagged always have the same stages.
+if sides is None:
+    sides = ['producer'] * 4 + ['output', 'transfer'] + ['consumer'] * 2
 
 # Determine the frame interval.
 interval = 0
@@ -77,12 +88,20 @@ colors = [[0.00, 0.27, 0.51, 0.8],
           [0.35, 0.14, 0.09, 0.8],
           [0.69, 0.27, 0.56, 0.8],
           [0.30, 0.30, 0.30, 0.8]]
+colors = [colors[i % len(colors)] for i in range(max(len(colors), len(labels) + 2))]
 
 # If requested, manipulate the data to provide an estimated read + process + write latency.
+# The consumer stages are followed by the producer stages, then the vsync and
+# wire times are derived from the frame interval.
 if args.estimate:
-    labels = [labels[6], labels[7], labels[0], labels[1], labels[2], labels[3], labels[4], labels[5]]
-    colors = [colors[6], colors[7], colors[0], colors[1], colors[2], colors[3], colors[4], colors[5]]
-    times = np.array([times[6], times[7], times[0], times[1], times[2], times[3]])
+    consumer = [i for i, side in enumerate(sides) if side == 'consumer']
+    producer = [i for i, side in enumerate(sides) if side == 'producer']
+    output = [i for i, side in enumerate(sides) if side == 'output']
+    transfer = [i for i, side in enumerate(sides) if side == 'transfer']
+    order = consumer + producer
+    labels = [labels[i] for i in order + output[:1] + transfer[:1]]
+    colors = [colors[i] for i in order + output[:1] + transfer[:1]]
+    times = np.array([times[i] for i in order])
     vsync_times = []
     for process_time in times.sum(axis=0):
         intervals = math.ceil(process_time / interval)
@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+// An example plugin with a producer and consumer that are connected by an
+// in-memory link rather than a physical loopback. The producer renders each
+// frame on the host and "scans it out" at the frame rate of the format, and
+// the consumer receives it after the wire time of the link. This measures the
+// tool itself without any video hardware, and shows how a backend is written
+// as a plugin. With the external source (-p none), the consumer drives its own
+// simulated producer so that the consumer-only mode can be measured too.
+
+#include <condition_variable>
+#include <deque>
+#include <stdlib.h>
+
+#include "AsyncLog.h"
+#include "Console.h"
+#include "ExternalSource.h"
+#include "PluginRegistry.h"
+
+namespace
+{
+
+// Parses the value of an integer option of a backend, logging an error if it
+// is not a non-negative integer.
+bool ParseOption(const PluginParams& params, const char* backend, const char* name, size_t* value)
+{
+    const std::string& str = params.options.at(name);
+    char* end = nullptr;
+    unsigned long parsed = strtoul(str.c_str(), &end, 10);
+    if (str.empty() || *end || str[0] == '-')
+    {
+        Error("Invalid value for the " << name << " option of the " << backend << ": " << str);
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+// A frame that has been scanned out and is in transit to the consumer.
+struct LinkFrame
+{
+    std::vector<uint8_t> data;
+    uint64_t sequence;
+    TimePoint arrival;
+};
+
+// The in-memory link, which holds the frames that have been scanned out but
+// not yet captured. Like the buffers of a capture device, the oldest frame is
+// overwritten if the consumer falls too far behind. Each frame is numbered in
+// the order sent, like the sequence numbers of a capture driver. The frame
+// buffers are allocated once and recycled, so that rendering a frame does not
+// allocate one.
+class Link
+{
+public:
+
+    Link()
+        : m_frameBytes(0)
+        , m_sequence(0)
+    {}
+
+    // The number of frames that the link holds.
+    static constexpr size_t MAX_FRAMES = 4;
+
+    // Allocates the frame buffers: one for the frame being rendered, those
+    // held by the link and one for the frame being captured.
+    void Allocate(size_t frameBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frames.clear();
+        m_frameBytes = frameBytes;
+        m_free.assign(MAX_FRAMES + 2, std::vector<uint8_t>(frameBytes));
+    }
+
+    // Returns a free frame buffer, which is only allocated if all of them are
+    // in use.
+    std::vector<uint8_t> Acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty())
+            return std::vector<uint8_t>(m_frameBytes);
+        std::vector<uint8_t> data(std::move(m_free.back()));
+        m_free.pop_back();
+        return data;
+    }
+
+    void Send(std::vector<uint8_t>&& data, const TimePoint& arrival)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_frames.size() == MAX_FRAMES)
+        {
+            m_free.push_back(std::move(m_frames.front().data));
+            m_frames.pop_front();
+        }
+        m_frames.push_back({ std::move(data), m_sequence++, arrival });
+        m_condition.notify_one();
+    }
+
+    // Waits for the next frame to arrive, or returns false on a timeout. The
+    // buffer of the frame that was received before is freed.
+    bool Receive(LinkFrame* frame, const Microseconds& timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_condition.wait_for(lock, timeout, [this]() { return !m_frames.empty(); }))
+            return false;
+        if (!frame->data.empty())
+            m_free.push_back(std::move(frame->data));
+        *frame = std::move(m_frames.front());
+        m_frames.pop_front();
+        lock.unlock();
+
+        std::this_thread::sleep_until(frame->arrival);
+        return true;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& frame : m_frames)
+            m_free.push_back(std::move(frame.data));
+        m_frames.clear();
+    }
+
+private:
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<LinkFrame> m_frames;
+    std::vector<std::vector<uint8_t>> m_free;
+    size_t m_frameBytes;
+    uint64_t m_sequence;
+};
+
+class SimulatedProducer : public Producer
+{
+public:
+
+    SimulatedProducer(const PluginParams& params, size_t wireTime)
+        : Producer(params.format, params.simulatedProcessing)
+        , m_wireTime(wireTime)
+        , m_cudaBuffer(nullptr)
+    {
+    }
+
+    virtual ~SimulatedProducer()
+    {
+        Close();
+    }
+
+    virtual bool Initialize() override
+    {
+        m_startupPhases.Resume();
+
+        m_cudaBuffer = CudaAlloc(m_format.totalBytes);
+        if (!m_cudaBuffer)
+        {
+            Error("Failed to allocate the simulated processing buffer.");
+            return false;
+        }
+        m_link.Allocate(m_format.totalBytes);
+        m_startupPhases.Record("Allocate buffers");
+
+        if (!InitializeContent(true))
+        {
+            Error("Failed to initialize the frame content.");
+            return false;
+        }
+        m_startupPhases.Record("Initialize content");
+
+        return true;
+    }
+
+    virtual void Close() override
+    {
+        if (IsStreaming())
+            StopStreaming();
+
+        if (m_cudaBuffer)
+            CudaFree(m_cudaBuffer);
+        m_cudaBuffer = nullptr;
+    }
+
+    virtual bool StartStreaming() override
+    {
+        m_link.Clear();
+        return Producer::StartStreaming();
+    }
+
+    // The emulated vsync can be disabled to produce frames as fast as possible.
+    virtual bool CanDisableVsync() const override
+    {
+        return true;
+    }
+
+    Link& GetLink() { return m_link; }
+
+protected:
+
+    virtual void StreamThread() override
+    {
+        const auto interval = m_format.frameRate.Interval();
+        TimePoint vsync = Clock::now();
+        while (IsStreaming())
+        {
+            auto frame = StartFrame();
+
+            frame->Record(MARKER_PROCESSING_START);
+
+            // Simulate processing time.
+            size_t elementCount = m_format.totalBytes / sizeof(uint32_t);
+            CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, SimulatedProcessing(*frame));
+
+            frame->Record(MARKER_RENDER_START);
+
+            std::vector<uint8_t> data(m_link.Acquire());
+            RenderFrameHost(*frame, data.data());
+
+            frame->Record(MARKER_RENDER_END);
+            frame->Record(MARKER_COPIED_FROM_GPU);
+            frame->Record(MARKER_WRITE_END);
+
+            // Scan out at the next vsync, skipping any that were missed.
+            if (Vsync())
+            {
+                TimePoint now = Clock::now();
+                do
+                    vsync += std::chrono::duration_cast<Clock::duration>(interval);
+                while (vsync < now);
+                std::this_thread::sleep_until(vsync);
+            }
+
+            RecordScanout(*frame);
+            m_link.Send(std::move(data), frame->Time(MARKER_SCANOUT_START) + m_wireTime);
+        }
+    }
+
+    virtual std::ostream& Dump(std::ostream& o) const override
+    {
+        o << "Simulated (plugin)" << std::endl
+          << "    Wire time: " << m_wireTime.count() << " us" << std::endl
+          << "    RDMA: 0 (Not supported)" << std::endl;
+        return o;
+    }
+
+private:
+
+    Microseconds m_wireTime;
+    void* m_cudaBuffer;
+    Link m_link;
+};
+
+class SimulatedConsumer : public Consumer
+{
+public:
+
+    // The source is the producer, unless the producer is an external source
+    // in which case the source is owned and streamed by the consumer.
+    SimulatedConsumer(std::shared_ptr<Producer> producer, std::shared_ptr<SimulatedProducer> source,
+                      size_t dropEvery)
+        : Consumer(producer)
+        , m_source(source)
+        , m_ownsSource(source != producer)
+        , m_link(source->GetLink())
+        , m_dropEvery(dropEvery)
+        , m_cudaBuffer(nullptr)
+    {
+    }
+
+    virtual ~SimulatedConsumer()
+    {
+        Close();
+    }
+
+    virtual bool Initialize() override
+    {
+        m_startupPhases.Resume();
+
+        m_cudaBuffer = CudaAlloc(m_producer->Format().totalBytes);
+        if (!m_cudaBuffer || !AllocateBuffers())
+        {
+            Error("Failed to allocate the capture buffers.");
+            return false;
+        }
+        m_startupPhases.Record("Allocate buffers");
+
+        if (m_ownsSource && !m_source->Initialize())
+        {
+            Error("Failed to initialize the simulated source.");
+            return false;
+        }
+        m_startupPhases.Record("Initialize source");
+
+        return true;
+    }
+
+    virtual void Close() override
+    {
+        if (m_ownsSource)
+            m_source->Close();
+
+        if (m_cudaBuffer)
+            CudaFree(m_cudaBuffer);
+        m_cudaBuffer = nullptr;
+    }
+
+    virtual bool StartStreaming() override
+    {
+        return !m_ownsSource || m_source->StartStreaming();
+    }
+
+    virtual void StopStreaming() override
+    {
+        if (m_ownsSource)
+            m_source->StopStreaming();
+    }
+
+    virtual bool CaptureFrames(size_t numFrames, size_t warmupFrames) override
+    {
+        for (size_t frame = 0; frame < numFrames + warmupFrames; frame++)
+        {
+            // Frames that the emulated capture path drops are never captured.
+            LinkFrame& received = m_received;
+            do
+            {
+                while (!m_link.Receive(&received, RECEIVE_TIMEOUT))
+                {
+                    if (!Resilient())
+                    {
+                        Error("Timed out waiting for a frame from the simulated producer.");
+                        return false;
+                    }
+                    RecordGlitch(Clock::now(), nullptr);
+                    if (!SkipGlitch())
+                        return false;
+                }
+            }
+            while (Dropped(received));
+
+            Timestamp receiveTime = Timestamp::Now();
+            RecordCapture(receiveTime.time);
+            if (frame < warmupFrames)
+                continue;
+
+            Timestamp readEnd = Timestamp::Now(MARKER_READ_END);
+
+            CudaMemcpyHtoD(m_cudaBuffer, received.data.data(), received.data.size());
+
+            Timestamp copiedToGPU = Timestamp::Now(MARKER_COPIED_TO_GPU);
+
+            Timestamp converted = ConvertToRGBA(m_cudaBuffer);
+
+            DriverCapture driver;
+            driver.hasSequence = true;
+            driver.sequence = received.sequence;
+            driver.time = received.arrival;
+
+            auto f = IdentifyFrame(received.data.data(), m_cudaBuffer, receiveTime, driver);
+            // Skipped captures do not count towards the frames to measure.
+            if (f)
+            {
+                ReceiveFrame(f, m_cudaBuffer, receiveTime, readEnd, copiedToGPU, converted);
+            }
+            else if (SkipGlitch())
+            {
+                frame--;
+                continue;
+            }
+            else
+            {
+                return false;
+            }
+
+            if ((frame > warmupFrames) && (frame - warmupFrames) % 100 == 0)
+            {
+                LogAsync(frame - warmupFrames, " / ", numFrames);
+            }
+        }
+        LogAsync(numFrames, " / ", numFrames);
+
+        return true;
+    }
+
+    virtual std::ostream& Dump(std::ostream& o) const override
+    {
+        o << "Simulated (plugin)" << std::endl
+          << "    Drop every: " << m_dropEvery << std::endl
+          << "    RDMA: 0 (Not supported)" << std::endl;
+        if (m_ownsSource)
+            o << "    Source: " << *m_source;
+        return o;
+    }
+
+private:
+
+    // Whether the emulated capture path drops the frame, which leaves a gap
+    // in the sequence numbers.
+    bool Dropped(const LinkFrame& frame) const
+    {
+        return m_dropEvery && frame.sequence % m_dropEvery == m_dropEvery - 1;
+    }
+
+    static constexpr Microseconds RECEIVE_TIMEOUT = Microseconds(2000000);
+
+    std::shared_ptr<SimulatedProducer> m_source;
+    bool m_ownsSource;
+    Link& m_link;
+    LinkFrame m_received;
+    size_t m_dropEvery;
+    void* m_cudaBuffer;
+};
+
+void RegisterBackends()
+{
+    ProducerBackend producer;
+    producer.name = "sim";
+    producer.description = "Simulated display with an in-memory link (plugin)";
+    producer.options = {
+        { "wire-time", "The time (in microseconds) that frames take to reach the consumer", "0" }
+    };
+    producer.create = [](const PluginParams& params) -> Producer*
+    {
+        size_t wireTime;
+        if (!ParseOption(params, "sim producer", "wire-time", &wireTime))
+            return nullptr;
+        return new SimulatedProducer(params, wireTime);
+    };
+    PluginRegistry::RegisterProducer(producer);
+
+    ConsumerBackend consumer;
+    consumer.name = "sim";
+    consumer.description = "Capture from the in-memory link of the sim producer (plugin)";
+    consumer.options = {
+        { "drop-every", "Drop every nth frame sent over the link (0 to drop none, otherwise at least 2)", "0" }
+    };
+    consumer.create = [](std::shared_ptr<Producer> producer, const PluginParams& params) -> Consumer*
+    {
+        size_t dropEvery;
+        if (!ParseOption(params, "sim consumer", "drop-every", &dropEvery))
+            return nullptr;
+        if (dropEvery == 1)
+        {
+            // Dropping every frame would never deliver one to the capture.
+            Error("The drop-every option of the sim consumer must be 0 (none) or at least 2.");
+            return nullptr;
+        }
+
+        // An external source is emulated by a sim producer of the same format
+        // that is not visible to the tool, as if it were a separate machine.
+        if (dynamic_cast<ExternalSource*>(producer.get()))
+        {
+            PluginParams sourceParams(params);
+            sourceParams.simulatedProcessing = 0;
+            sourceParams.options.clear();
+            return new SimulatedConsumer(producer, std::make_shared<SimulatedProducer>(sourceParams, 0), dropEvery);
+        }
+
+        auto simulatedProducer = std::dynamic_pointer_cast<SimulatedProducer>(producer);
+        if (!simulatedProducer)
+        {
+            Error("The sim consumer can only be used with the sim producer or an external source.");
+            return nullptr;
+        }
+        return new SimulatedConsumer(producer, simulatedProducer, dropEvery);
+    };
+    PluginRegistry::RegisterConsumer(consumer);
+}
+
+}
+
+LOOPBACK_LATENCY_PLUGIN(RegisterBackends)
@@ -125,49 +125,95 @@ NTV2Channel AJABase::GetNTV2Channel(const std::string& channel)
     return static_cast<NTV2Channel>(NTV2_CHANNEL1 + (idx - 1));
 }
 
+namespace
+{
+
+struct VideoFormatMapping
+{
+    size_t width;
+    size_t height;
+    FrameRate frameRate;
+    NTV2VideoFormat format;
+
+    // The equivalent 4x quadrant format used with TSI, if any.
+    NTV2VideoFormat formatTSI;
+};
+
+const FrameRate RATE_2398(24000, 1001);
+const FrameRate RATE_2997(30000, 1001);
+const FrameRate RATE_5994(60000, 1001);
+
+const VideoFormatMapping VIDEO_FORMATS[] =
+{
+    { 1280,  720, 50,        NTV2_FORMAT_720p_5000,        NTV2_FORMAT_UNKNOWN },
+    { 1280,  720, RATE_5994, NTV2_FORMAT_720p_5994,        NTV2_FORMAT_UNKNOWN },
+    { 1280,  720, 60,        NTV2_FORMAT_720p_6000,        NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, RATE_2398, NTV2_FORMAT_1080p_2398,       NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, 24,        NTV2_FORMAT_1080p_2400,       NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, 25,        NTV2_FORMAT_1080p_2500,       NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, RATE_2997, NTV2_FORMAT_1080p_2997,       NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, 30,        NTV2_FORMAT_1080p_3000,       NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, 50,        NTV2_FORMAT_1080p_5000_A,     NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, RATE_5994, NTV2_FORMAT_1080p_5994_A,     NTV2_FORMAT_UNKNOWN },
+    { 1920, 1080, 60,        NTV2_FORMAT_1080p_6000_A,     NTV2_FORMAT_UNKNOWN },
+    { 3840, 2160, RATE_2398, NTV2_FORMAT_3840x2160p_2398,  NTV2_FORMAT_4x1920x1080p_2398 },
+    { 3840, 2160, 24,        NTV2_FORMAT_3840x2160p_2400,  NTV2_FORMAT_4x1920x1080p_2400 },
+    { 3840, 2160, 25,        NTV2_FORMAT_3840x2160p_2500,  NTV2_FORMAT_4x1920x1080p_2500 },
+    { 3840, 2160, RATE_2997, NTV2_FORMAT_3840x2160p_2997,  NTV2_FORMAT_4x1920x1080p_2997 },
+    { 3840, 2160, 30,        NTV2_FORMAT_3840x2160p_3000,  NTV2_FORMAT_4x1920x1080p_3000 },
+    { 3840, 2160, 50,        NTV2_FORMAT_3840x2160p_5000,  NTV2_FORMAT_4x1920x1080p_5000 },
+    { 3840, 2160, RATE_5994, NTV2_FORMAT_3840x2160p_5994,  NTV2_FORMAT_4x1920x1080p_5994 },
+    { 3840, 2160, 60,        NTV2_FORMAT_3840x2160p_6000,  NTV2_FORMAT_4x1920x1080p_6000 },
+    { 4096, 2160, RATE_2398, NTV2_FORMAT_4096x2160p_2398,  NTV2_FORMAT_4x2048x1080p_2398 },
+    { 4096, 2160, 24,        NTV2_FORMAT_4096x2160p_2400,  NTV2_FORMAT_4x2048x1080p_2400 },
+    { 4096, 2160, 25,        NTV2_FORMAT_4096x2160p_2500,  NTV2_FORMAT_4x2048x1080p_2500 },
+    { 4096, 2160, RATE_2997, NTV2_FORMAT_4096x2160p_2997,  NTV2_FORMAT_4x2048x1080p_2997 },
+    { 4096, 2160, 30,        NTV2_FORMAT_4096x2160p_3000,  NTV2_FORMAT_4x2048x1080p_3000 },
+    { 4096, 2160, 50,        NTV2_FORMAT_4096x2160p_5000,  NTV2_FORMAT_4x2048x1080p_5000 },
+    { 4096, 2160, RATE_5994, NTV2_FORMAT_4096x2160p_5994,  NTV2_FORMAT_4x2048x1080p_5994 },
+    { 4096, 2160, 60,        NTV2_FORMAT_4096x2160p_6000,  NTV2_FORMAT_4x2048x1080p_6000 },
+};
+
+} // anonymous namespace
+
 NTV2VideoFormat AJABase::GetNTV2VideoFormat(const TestFormat& format)
 {
-    if (format == FORMAT_720_RGBA_60)
-        return NTV2_FORMAT_720p_6000;
-    else if (format == FORMAT_1080_RGBA_60)
-        return NTV2_FORMAT_1080p_6000_A;
-    else if (format == FORMAT_UHD_RGBA_24)
-        return NTV2_FORMAT_3840x2160p_2400;
-    else if (format == FORMAT_UHD_RGBA_60)
-        return NTV2_FORMAT_3840x2160p_6000;
-    else if (format == FORMAT_4K_RGBA_24)
-        return NTV2_FORMAT_4096x2160p_2400;
-    else if (format == FORMAT_4K_RGBA_60)
-        return NTV2_FORMAT_4096x2160p_6000;
-    else
-        return NTV2_FORMAT_UNKNOWN;
+    for (const auto& mapping : VIDEO_FORMATS)
+    {
+        if (mapping.width == format.width &&
+            mapping.height == format.height &&
+            mapping.frameRate == format.frameRate)
+        {
+            return mapping.format;
+        }
+    }
+    return NTV2_FORMAT_UNKNOWN;
 }
 
 NTV2PixelFormat AJABase::GetNTV2PixelFormat(const TestFormat& format)
 {
-    if (format.pixelFormat == PIXEL_FORMAT_RGBA)
-        return NTV2_FBF_ABGR;
-    else
-        return NTV2_FBF_INVALID;
+    // Note that NV12 and P010 are not mapped since the AJA planar frame buffer
+    // layouts may not match the contiguous layout used by the tool.
+    switch (format.pixelFormat)
+    {
+        case PIXEL_FORMAT_RGBA:    return NTV2_FBF_ABGR;
+        case PIXEL_FORMAT_UYVY:    return NTV2_FBF_8BIT_YCBCR;
+        case PIXEL_FORMAT_YUYV:    return NTV2_FBF_8BIT_YCBCR_YUY2;
+        case PIXEL_FORMAT_RGB10A2: return NTV2_FBF_10BIT_RGB;
+        case PIXEL_FORMAT_V210:    return NTV2_FBF_10BIT_YCBCR;
+        default:                   return NTV2_FBF_INVALID;
+    }
 }
 
 bool AJABase::GetNTV2VideoFormatTSI(NTV2VideoFormat& format)
 {
-    switch (format)
+    for (const auto& mapping : VIDEO_FORMATS)
     {
-        case NTV2_FORMAT_3840x2160p_2400:
-            format = NTV2_FORMAT_4x1920x1080p_2400;
-            return true;
-        case NTV2_FORMAT_3840x2160p_6000:
-            format = NTV2_FORMAT_4x1920x1080p_6000;
-            return true;
-        case NTV2_FORMAT_4096x2160p_2400:
-            format = NTV2_FORMAT_4x2048x1080p_2400;
-            return true;
-        case NTV2_FORMAT_4096x2160p_6000:
-            format = NTV2_FORMAT_4x2048x1080p_6000;
+        if (mapping.format == format && mapping.formatTSI != NTV2_FORMAT_UNKNOWN)
+        {
+            format = mapping.formatTSI;
             return true;
-        default:
-            return false;
+        }
     }
+    return false;
 }
@@ -21,6 +21,7 @@
  */
 
 #include "AJAConsumer.h"
+#include "AsyncLog.h"
 #include "Console.h"
 #include "CudaUtils.h"
 
@@ -43,9 +44,10 @@ AJAStatus AJAConsumer::SetupVideo()
     NTV2InputSource inputSrc(NTV2ChannelToInputSource(m_channel, inputKind));
     NTV2Channel tsiChannel = (NTV2Channel)(m_channel + 1);
 
-    if (!IsRGBFormat(m_pixelFormat))
+    bool isFrameBufferRGB = IsRGBFormat(m_pixelFormat);
+    if (!isFrameBufferRGB && m_useTSI)
     {
-        Error("YUV formats not yet supported");
+        Error("YUV formats are not supported with TSI input.");
         return AJA_STATUS_UNSUPPORTED;
     }
 
@@ -115,14 +117,15 @@ AJAStatus AJAConsumer::SetupVideo()
             m_device.Connect(NTV2_Xpt425Mux2BInput, NTV2_XptHDMIIn1Q4RGB);
         }
     }
-    else if (!isInputRGB)
+    else if (isInputRGB != isFrameBufferRGB)
     {
+        // Convert between the input and frame buffer color spaces.
         if (NTV2DeviceGetNumCSCs(m_deviceID) <= (int)m_channel)
         {
             Error("No CSC available for NTV2_CHANNEL" << (m_channel + 1));
             return AJA_STATUS_UNSUPPORTED;
         }
-        m_device.Connect(fbInputXpt, GetCSCOutputXptFromChannel(m_channel, /*inIsKey*/ false, /*inIsRGB*/ true));
+        m_device.Connect(fbInputXpt, GetCSCOutputXptFromChannel(m_channel, /*inIsKey*/ false, /*inIsRGB*/ isFrameBufferRGB));
         m_device.Connect(GetCSCInputXptFromChannel(m_channel), inputOutputXpt);
     }
     else
@@ -135,12 +138,15 @@ AJAStatus AJAConsumer::SetupVideo()
 
 bool AJAConsumer::Initialize()
 {
+    m_startupPhases.Resume();
+
     AJAStatus status = OpenDevice();
     if (AJA_FAILURE(status))
     {
         Error("Failed to open AJA device '" << m_deviceSpecifier << "'.");
         return false;
     }
+    m_startupPhases.Record("Open device");
 
     if (!NTV2DeviceCanDoCapture(m_deviceID))
     {
@@ -154,6 +160,13 @@ bool AJAConsumer::Initialize()
         Error("Failed to setup AJA device '" << m_deviceSpecifier << "'.");
         return false;
     }
+    m_startupPhases.Record("Configure routing");
+
+    if (!AllocateBuffers())
+    {
+        Error("Failed to allocate the frame conversion and verification buffers.");
+        return false;
+    }
 
     return true;
 }
@@ -176,13 +189,16 @@ bool AJAConsumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
     // Set the initial frame and warmup the stream (wait for signal).
     uint32_t currentHwFrame = 2;
     m_device.SetInputFrame(m_channel, currentHwFrame);
-    m_device.WaitForInputVerticalInterrupt(m_channel, warmupFrames);
+    m_device.WaitForInputVerticalInterrupt(m_channel);
+    RecordCapture(Clock::now());
+    if (warmupFrames > 1)
+        m_device.WaitForInputVerticalInterrupt(m_channel, warmupFrames - 1);
 
     // If reading the frame exceeds a frame interval then we might encounter a
     // race between the update of the input frame and the interrupt. To avoid this
     // we will insert another interrupt wait if we approach the frame interval.
     const Microseconds frameHeadroom(2000);
-    const Microseconds frameInterval(1000000 / m_producer->Format().frameRate);
+    const Microseconds frameInterval(m_producer->Format().frameRate.IntervalMicroseconds());
     const Microseconds maxFrameTime(frameInterval.count() - frameHeadroom.count());
 
     for (int frameNumber = 0; frameNumber < numFrames; frameNumber++)
@@ -192,37 +208,60 @@ bool AJAConsumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
         m_device.SetInputFrame(m_channel, nextHwFrame);
         m_device.WaitForInputVerticalInterrupt(m_channel);
 
-        TimePoint receiveTime = Clock::now();
+        Timestamp receiveTime = Timestamp::Now();
+
+        // The input interrupt count advances with every input frame, so it
+        // skips the frames that were missed while the last one was read. It is
+        // read before the extra interrupt wait below, which would advance it.
+        DriverCapture driver;
+        ULWord interrupts = 0;
+        if (m_device.GetInputVerticalInterruptCount(interrupts, m_channel))
+        {
+            driver.hasSequence = true;
+            driver.sequence = interrupts;
+        }
 
         // Read the current frame from the device.
         ULWord* dstBuf = (ULWord*)(m_useRDMA ? m_cudaBuffer : m_buffer.data());
         m_device.DMAReadFrame(currentHwFrame, dstBuf, m_formatDesc.GetTotalBytes());
 
-        TimePoint readEnd = Clock::now();
+        Timestamp readEnd = Timestamp::Now(MARKER_READ_END);
 
         // If not using RDMA, copy the entire buffer to GPU.
         if (!m_useRDMA)
             CudaMemcpyHtoD(m_cudaBuffer, m_buffer.data(), m_formatDesc.GetTotalBytes());
 
-        TimePoint copiedToGPU = Clock::now();
+        Timestamp copiedToGPU = Timestamp::Now(MARKER_COPIED_TO_GPU);
+
+        Timestamp converted = ConvertToRGBA(m_cudaBuffer);
 
         // Wait for another frame interrupt if we're approaching an interval to avoid update race.
-        auto readTime = std::chrono::duration_cast<Microseconds>(copiedToGPU - receiveTime);
+        auto readTime = std::chrono::duration_cast<Microseconds>(copiedToGPU.time - receiveTime.time);
         if (readTime > maxFrameTime)
             m_device.WaitForInputVerticalInterrupt(m_channel);
 
-        // If using RDMA, copy the first pixel used for lookup purposes to host mem.
-        // Note that if the lookup method ever changes to use more data then this will
-        // also need to change accordingly, but we should minimize the size of the copy
-        // to avoid negatively impacting the overall load/latency.
+        // If using RDMA, copy the first pixel (or YUV macropixel) used for lookup
+        // purposes to host mem, along with the chroma values of semi-planar formats. Note that if the
+        // lookup method ever changes to use more data then this will also need to
+        // change accordingly, but we should minimize the size of the copy to avoid
+        // negatively impacting the overall load/latency.
         if (m_useRDMA)
-            CudaMemcpyDtoH(m_buffer.data(), m_cudaBuffer, m_producer->Format().bytesPerPixel);
+        {
+            const TestFormat& format = m_producer->Format();
+            CudaMemcpyDtoH(m_buffer.data(), m_cudaBuffer, 4);
+            if (format.chromaOffset)
+            {
+                CudaMemcpyDtoH((uint8_t*)m_buffer.data() + format.chromaOffset,
+                               (uint8_t*)m_cudaBuffer + format.chromaOffset, 4);
+            }
+        }
 
-        // Get the frame pointer from the producer.
-        auto frame = m_producer->GetFrame(m_buffer.data());
-        if (!frame)
+        // Get the frame pointer from the producer. Frames that cannot be
+        // identified are skipped in the resilient mode.
+        auto frame = IdentifyFrame(m_buffer.data(), m_cudaBuffer, receiveTime, driver);
+        if (!frame && !SkipGlitch())
         {
-            if (m_useRDMA)
+            if (m_useRDMA && !Resilient())
             {
                 Warning("This error may also occur if RDMA is enabled but the AJA" << std::endl <<
                         "device is not connected to a PCI port that supports RDMA." << std::endl <<
@@ -232,28 +271,20 @@ bool AJAConsumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
             return false;
         }
 
-        if (m_frames.size() && m_frames.back()->Number() == frame->Number())
-        {
-            // If this frame has already been received, increment the duplicate count.
-            frame->RecordDuplicateReceive();
-        }
+        // Skipped captures do not count towards the frames to measure.
+        if (frame)
+            ReceiveFrame(frame, m_cudaBuffer, receiveTime, readEnd, copiedToGPU, converted);
         else
-        {
-            // Otherwise, record the times and add it to the consumer list.
-            frame->RecordFrameReceived(receiveTime);
-            frame->RecordReadEnd(readEnd);
-            frame->RecordCopiedToGPU(copiedToGPU);
-            m_frames.push_back(frame);
-        }
+            frameNumber--;
 
         if (frameNumber > 0 && frameNumber % 100 == 0)
         {
-            Log(frameNumber << " / " << numFrames);
+            LogAsync(frameNumber, " / ", numFrames);
         }
 
         currentHwFrame = nextHwFrame;
     }
-    Log(numFrames << " / " << numFrames);
+    LogAsync(numFrames, " / ", numFrames);
 
     return true;
 }
@@ -78,12 +78,15 @@ AJAStatus AJAProducer::SetupVideo()
 
 bool AJAProducer::Initialize()
 {
+    m_startupPhases.Resume();
+
     AJAStatus status = OpenDevice();
     if (AJA_FAILURE(status))
     {
         Error("Failed to open AJA device '" << m_deviceSpecifier << "'.");
         return false;
     }
+    m_startupPhases.Record("Open device");
 
     if (!NTV2DeviceCanDoPlayback(m_deviceID))
     {
@@ -97,6 +100,14 @@ bool AJAProducer::Initialize()
         Error("Failed to setup AJA device '" << m_deviceSpecifier << "'.");
         return false;
     }
+    m_startupPhases.Record("Configure routing");
+
+    if (!InitializeContent(false))
+    {
+        Error("Failed to initialize the frame content.");
+        return false;
+    }
+    m_startupPhases.Record("Initialize content");
 
     return true;
 }
@@ -125,24 +136,24 @@ void AJAProducer::StreamThread()
     {
         auto frame = StartFrame();
 
-        frame->RecordProcessingStart();
+        frame->Record(MARKER_PROCESSING_START);
 
         // Simulate processing time.
-        size_t elementCount = m_format.width * m_format.height;
-        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, m_simulatedProcessing);
+        size_t elementCount = m_format.totalBytes / sizeof(uint32_t);
+        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, SimulatedProcessing(*frame));
 
-        frame->RecordRenderStart();
+        frame->Record(MARKER_RENDER_START);
 
         // Fill the CUDA buffer with the frame color.
-        CudaWriteRGBA((uint32_t*)m_cudaBuffer, elementCount, frame->R(), frame->G(), frame->B());
+        RenderFrame(*frame, m_cudaBuffer);
 
-        frame->RecordRenderEnd();
+        frame->Record(MARKER_RENDER_END);
 
         // If not using RDMA, copy to the host buffer.
         if (!m_useRDMA)
             CudaMemcpyDtoH(m_buffer.data(), m_cudaBuffer, m_formatDesc.GetTotalBytes());
 
-        frame->RecordCopiedFromGPU();
+        frame->Record(MARKER_COPIED_FROM_GPU);
 
         // Write the frame to the hardware.
         uint32_t nextHwFrame = currentHwFrame ^ 1;
@@ -150,12 +161,12 @@ void AJAProducer::StreamThread()
         m_device.DMAWriteFrame(nextHwFrame, srcBuf, m_formatDesc.GetTotalBytes());
         m_device.SetOutputFrame(m_channel, nextHwFrame);
 
-        frame->RecordWriteEnd();
+        frame->Record(MARKER_WRITE_END);
 
         // Wait for the next frame interrupt.
         m_device.WaitForOutputVerticalInterrupt(m_channel);
 
-        frame->RecordScanoutStart();
+        RecordScanout(*frame);
 
         currentHwFrame = nextHwFrame;
     }
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "AsyncLog.h"
+#include "Console.h"
+
+namespace
+{
+
+// How often the drain thread checks the ring when it is not woken explicitly.
+// The hot threads never wake the drain thread themselves since that may cost
+// a system call.
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(10);
+
+} // anonymous namespace
+
+struct AsyncLogState
+{
+    AsyncLogState()
+        : enqueuePosition(0)
+        , dequeuePosition(0)
+        , dropped(0)
+        , output(std::cout.rdbuf())
+        , flushRequested(false)
+        , stopping(false)
+    {
+        for (size_t i = 0; i < AsyncLog::RING_SIZE; i++)
+            ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~AsyncLogState()
+    {
+        AsyncLog::Stop();
+    }
+
+    // Writes the queued messages up to the first one that has not been
+    // published yet. Must be called with the mutex held.
+    void Drain()
+    {
+        bool wrote = false;
+        uint64_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& entry = ring[position % AsyncLog::RING_SIZE];
+            if (entry.sequence.load(std::memory_order_acquire) != position + 1)
+                break;
+
+            entry.write(output, entry.args);
+            entry.sequence.store(position + AsyncLog::RING_SIZE, std::memory_order_release);
+            dequeuePosition.store(++position, std::memory_order_release);
+            wrote = true;
+        }
+        if (wrote)
+            output.flush();
+    }
+
+    void DrainThread()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping)
+        {
+            Drain();
+            flushRequested = false;
+            condition.notify_all();
+            condition.wait_for(lock, DRAIN_INTERVAL, [this]{ return stopping || flushRequested; });
+        }
+    }
+
+    AsyncLog::Entry ring[AsyncLog::RING_SIZE];
+    std::atomic<uint64_t> enqueuePosition;
+    std::atomic<uint64_t> dequeuePosition;
+    std::atomic<uint64_t> dropped;
+
+    // The stream that messages are written to, which is guarded by the mutex.
+    std::ostream output;
+
+    bool flushRequested;
+    bool stopping;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+static AsyncLogState s_state;
+
+void AsyncLog::Start()
+{
+    std::lock_guard<std::mutex> lock(s_state.mutex);
+    if (s_state.thread.joinable())
+        return;
+
+    s_state.stopping = false;
+    s_state.thread = std::thread(&AsyncLogState::DrainThread, &s_state);
+}
+
+void AsyncLog::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_state.mutex);
+        s_state.stopping = true;
+    }
+    s_state.condition.notify_all();
+    if (s_state.thread.joinable())
+        s_state.thread.join();
+
+    std::lock_guard<std::mutex> lock(s_state.mutex);
+    s_state.Drain();
+
+    uint64_t dropped = s_state.dropped.exchange(0);
+    if (dropped > 0)
+    {
+        Warning(dropped << " log messages were dropped because the log ring was full.");
+    }
+}
+
+void AsyncLog::Flush()
+{
+    uint64_t target = s_state.enqueuePosition.load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> lock(s_state.mutex);
+    if (!s_state.thread.joinable())
+    {
+        // Without a drain thread the messages are written here instead.
+        s_state.Drain();
+        return;
+    }
+
+    while (s_state.dequeuePosition.load(std::memory_order_acquire) < target)
+    {
+        s_state.flushRequested = true;
+        s_state.condition.notify_all();
+        s_state.condition.wait_for(lock, DRAIN_INTERVAL);
+    }
+}
+
+uint64_t AsyncLog::Dropped()
+{
+    return s_state.dropped.load(std::memory_order_relaxed);
+}
+
+std::streambuf* AsyncLog::SetOutput(std::streambuf* output)
+{
+    std::lock_guard<std::mutex> lock(s_state.mutex);
+    return s_state.output.rdbuf(output);
+}
+
+AsyncLog::Entry* AsyncLog::Reserve(uint64_t* position)
+{
+    // Claims the next free entry of the ring, as in a bounded multi-producer
+    // queue: an entry is free for a position once its sequence equals it.
+    uint64_t pos = s_state.enqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Entry& entry = s_state.ring[pos % RING_SIZE];
+        uint64_t sequence = entry.sequence.load(std::memory_order_acquire);
+        int64_t difference = (int64_t)sequence - (int64_t)pos;
+        if (difference == 0)
+        {
+            if (s_state.enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                *position = pos;
+                return &entry;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The ring is full.
+            s_state.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            pos = s_state.enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLog::Publish(Entry* entry, uint64_t position)
+{
+    entry->sequence.store(position + 1, std::memory_order_release);
+}
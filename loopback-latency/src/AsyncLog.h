@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <tuple>
+#include <type_traits>
+
+// Writes log messages from the latency-critical threads (the producer stream
+// thread and the consumer capture thread) without blocking them on the
+// terminal. The arguments of each message are copied into a preallocated
+// lock-free ring and are only formatted and written to the output (that of
+// std::cout by default) by a background drain thread. If the ring is full the
+// message is dropped and counted rather than waiting for the drain thread to
+// catch up.
+//
+// Messages are written in the order they were queued, but are not ordered
+// with the synchronous Log/Warning/Error macros; call Flush() before writing
+// synchronously after logging from a hot thread.
+class AsyncLog
+{
+public:
+
+    // The number of messages that can be queued before messages are dropped.
+    static constexpr size_t RING_SIZE = 1024;
+
+    // The maximum size of the (copied) arguments of a single message.
+    static constexpr size_t MAX_ARGS_SIZE = 96;
+
+    // Starts the drain thread. Messages queued before this are kept.
+    static void Start();
+
+    // Writes all queued messages and stops the drain thread.
+    static void Stop();
+
+    // Waits until all messages queued so far have been written.
+    static void Flush();
+
+    // The number of messages dropped because the ring was full.
+    static uint64_t Dropped();
+
+    // Sets the stream buffer that messages are written to and returns the
+    // previous one. Unlike the buffer of std::cout, this can be changed while
+    // the drain thread is writing, which only uses it with its lock held.
+    static std::streambuf* SetOutput(std::streambuf* output);
+
+    // Queues a message that is written as if each argument was streamed to
+    // std::cout in order, followed by a newline. Arguments are copied by
+    // value, so string literals are cheap but std::string arguments allocate.
+    template <typename... Args>
+    static void Write(const Args&... args)
+    {
+        using Arguments = std::tuple<std::decay_t<const Args&>...>;
+        static_assert(sizeof(Arguments) <= MAX_ARGS_SIZE, "Too many log arguments");
+        static_assert(alignof(Arguments) <= alignof(std::max_align_t), "Unsupported log argument");
+
+        uint64_t position;
+        Entry* entry = Reserve(&position);
+        if (!entry)
+            return;
+
+        new (entry->args) Arguments(args...);
+        entry->write = [](std::ostream& o, void* p)
+        {
+            Arguments* arguments = static_cast<Arguments*>(p);
+            std::apply([&o](const auto&... a) { (o << ... << a); }, *arguments);
+            o << '\n';
+            arguments->~Arguments();
+        };
+        Publish(entry, position);
+    }
+
+private:
+
+    friend struct AsyncLogState;
+
+    struct Entry
+    {
+        // The ring position this entry is free for (== position) or holds a
+        // message for (== position + 1).
+        std::atomic<uint64_t> sequence;
+        void (*write)(std::ostream&, void*);
+        alignas(std::max_align_t) unsigned char args[MAX_ARGS_SIZE];
+    };
+
+    static Entry* Reserve(uint64_t* position);
+    static void Publish(Entry* entry, uint64_t position);
+};
+
+// Queues a log message from a latency-critical thread, e.g.
+//   LogAsync(frame, " / ", numFrames);
+#define LogAsync(...) AsyncLog::Write(__VA_ARGS__)
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <iomanip>
+
+#include "BandwidthModel.h"
+
+namespace
+{
+
+// The 97.5% quantiles of Student's t-distribution for 1 to 30 degrees of
+// freedom, which give the half-width of a two-sided 95% confidence interval.
+const double T_QUANTILES[] =
+{
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+double TQuantile(size_t dof)
+{
+    if (dof <= sizeof(T_QUANTILES) / sizeof(T_QUANTILES[0]))
+        return T_QUANTILES[dof - 1];
+
+    // The Cornish-Fisher expansion to the second order is accurate to within
+    // 0.0001 beyond 30 (the first order alone is off by 0.003 at 31).
+    const double z = 1.959964;
+    const double z3 = z * z * z;
+    const double z5 = z3 * z * z;
+    return z + (z3 + z) / (4.0 * dof) + (5 * z5 + 16 * z3 + 3 * z) / (96.0 * dof * dof);
+}
+
+}
+
+double StageFit::BandwidthLow() const
+{
+    double slowest = perByte + perByteError;
+    return slowest > 0 ? 1.0 / slowest : 0.0;
+}
+
+double StageFit::BandwidthHigh() const
+{
+    // The interval is unbounded if the time may not grow with the frame size.
+    double fastest = perByte - perByteError;
+    return fastest > 0 ? 1.0 / fastest : INFINITY;
+}
+
+double StageFit::PredictError(size_t bytes) const
+{
+    if (!HasErrors())
+        return 0;
+    double offset = bytes - meanBytes;
+    return tQuantile * std::sqrt(residualVariance * (1.0 / points + offset * offset / bytesSumSquares));
+}
+
+size_t BandwidthModel::MetricIndex(const std::string& metric, const std::string& label)
+{
+    for (size_t i = 0; i < m_metrics.size(); i++)
+    {
+        if (m_metrics[i] == metric)
+            return i;
+    }
+    m_metrics.push_back(metric);
+    m_labels.push_back(label);
+    for (auto& step : m_steps)
+    {
+        step.times.push_back(0);
+        step.measured.push_back(false);
+    }
+    return m_metrics.size() - 1;
+}
+
+void BandwidthModel::AddStep(const TestFormat& format, const std::vector<std::shared_ptr<Frame>>& frames)
+{
+    const auto& markers = StageRegistry::Markers();
+    std::vector<size_t> indices;
+    for (size_t i = 1; i < markers.size(); i++)
+        indices.push_back(MetricIndex(markers[i].metric, markers[i].label));
+    size_t totalIndex = MetricIndex("total", "Total");
+
+    Step step = { format, frames.size(), std::vector<double>(m_metrics.size()),
+                  std::vector<bool>(m_metrics.size()) };
+    std::vector<size_t> counts(m_metrics.size());
+    for (const auto& f : frames)
+    {
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (f->StageMarkers(i, &start, &end))
+            {
+                step.times[indices[i - 1]] += f->Elapsed(start, end).count();
+                counts[indices[i - 1]]++;
+            }
+        }
+        step.times[totalIndex] += f->Elapsed(MARKER_PROCESSING_START, MARKER_COPIED_TO_GPU).count();
+        counts[totalIndex]++;
+    }
+    for (size_t i = 0; i < m_metrics.size(); i++)
+    {
+        step.measured[i] = counts[i] > 0;
+        if (counts[i])
+            step.times[i] /= counts[i];
+    }
+    m_steps.push_back(step);
+}
+
+StageFit BandwidthModel::FitLine(const std::vector<double>& bytes, const std::vector<double>& times)
+{
+    StageFit fit = {};
+    fit.points = bytes.size();
+    if (fit.points < 2)
+        return fit;
+
+    double n = fit.points;
+    double meanX = 0, meanY = 0;
+    for (size_t i = 0; i < fit.points; i++)
+    {
+        meanX += bytes[i] / n;
+        meanY += times[i] / n;
+    }
+    double sxx = 0, sxy = 0, syy = 0;
+    for (size_t i = 0; i < fit.points; i++)
+    {
+        sxx += (bytes[i] - meanX) * (bytes[i] - meanX);
+        sxy += (bytes[i] - meanX) * (times[i] - meanY);
+        syy += (times[i] - meanY) * (times[i] - meanY);
+    }
+    if (sxx == 0)
+        return fit;
+
+    fit.perByte = sxy / sxx;
+    fit.fixed = meanY - fit.perByte * meanX;
+    fit.r2 = syy > 0 ? (sxy * sxy) / (sxx * syy) : 1.0;
+    fit.meanBytes = meanX;
+    fit.bytesSumSquares = sxx;
+
+    // The standard errors of the slope and intercept from the residuals.
+    if (fit.points > 2)
+    {
+        double residuals = 0;
+        for (size_t i = 0; i < fit.points; i++)
+        {
+            double r = times[i] - fit.Predict(bytes[i]);
+            residuals += r * r;
+        }
+        fit.residualVariance = residuals / (n - 2);
+        fit.tQuantile = TQuantile(fit.points - 2);
+        fit.perByteError = fit.tQuantile * std::sqrt(fit.residualVariance / sxx);
+        fit.fixedError = fit.PredictError(0);
+    }
+    return fit;
+}
+
+std::vector<StageFit> BandwidthModel::Fit() const
+{
+    std::vector<StageFit> fits;
+    for (size_t i = 0; i < m_metrics.size(); i++)
+    {
+        std::vector<double> bytes, times;
+        for (const auto& step : m_steps)
+        {
+            if (step.measured[i])
+            {
+                bytes.push_back(step.format.totalBytes);
+                times.push_back(step.times[i]);
+            }
+        }
+
+        // The frame sizes must differ for the time per byte to be known.
+        bool sizesDiffer = false;
+        for (double b : bytes)
+            sizesDiffer |= b != bytes[0];
+        if (!sizesDiffer)
+            continue;
+
+        StageFit fit = FitLine(bytes, times);
+        fit.metric = m_metrics[i];
+        fit.label = m_labels[i];
+        fits.push_back(fit);
+    }
+    return fits;
+}
+
+void BandwidthModel::Write(std::ostream& o) const
+{
+    o << "format,bytes,frames";
+    for (const auto& metric : m_metrics)
+        o << "," << metric;
+    o << std::endl;
+    for (const auto& step : m_steps)
+    {
+        o << "\"" << step.format << "\"," << step.format.totalBytes << "," << step.frames;
+        for (size_t i = 0; i < m_metrics.size(); i++)
+        {
+            o << ",";
+            if (step.measured[i])
+                o << std::fixed << std::setprecision(1) << step.times[i];
+        }
+        o << std::endl;
+    }
+
+    o << std::endl
+      << "stage,points,fixed_us,fixed_ci95_us,us_per_mb,us_per_mb_ci95,bandwidth_mb_s,"
+         "bandwidth_ci95_low_mb_s,bandwidth_ci95_high_mb_s,r2" << std::endl;
+    for (const auto& fit : Fit())
+    {
+        o << fit.metric << "," << fit.points << ","
+          << std::fixed << std::setprecision(1) << fit.fixed << ",";
+        if (fit.HasErrors())
+            o << fit.fixedError;
+        o << "," << std::setprecision(3) << fit.perByte * 1e6 << ",";
+        if (fit.HasErrors())
+            o << fit.perByteError * 1e6;
+        o << "," << std::setprecision(1);
+        if (fit.Bandwidth() > 0)
+            o << fit.Bandwidth();
+        else
+            o << "inf";
+        o << ",";
+        if (fit.HasErrors())
+        {
+            if (fit.BandwidthLow() > 0)
+                o << fit.BandwidthLow();
+            else
+                o << "inf";
+            o << "," << fit.BandwidthHigh();
+        }
+        else
+        {
+            o << ",";
+        }
+        o << "," << std::setprecision(4) << fit.r2 << std::endl;
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Frame.h"
+
+// A straight line fitted to the stage time of each frame size:
+//
+//   time = fixed + bytes / bandwidth
+//
+// along with the half-widths of the 95% confidence intervals of the fixed time
+// and of the time per byte.
+struct StageFit
+{
+    std::string metric;
+    std::string label;
+
+    // The number of frame sizes that the stage was measured at.
+    size_t points;
+
+    double fixed;          // Microseconds.
+    double perByte;        // Microseconds per byte.
+    double fixedError;
+    double perByteError;
+
+    // The coefficient of determination of the fit (1 is a perfect fit).
+    double r2;
+
+    // The statistics of the fit that the confidence intervals are derived from.
+    double meanBytes;
+    double bytesSumSquares;
+    double residualVariance;
+    double tQuantile;
+
+    // Whether there were enough points (3 or more) for confidence intervals.
+    bool HasErrors() const { return points > 2; }
+
+    // The bandwidth (bytes per microsecond, i.e. MB/s) and its confidence
+    // interval. The bandwidth is infinite if the time does not grow with the
+    // frame size, which is reported as zero (or as INFINITY by BandwidthHigh).
+    double Bandwidth() const { return perByte > 0 ? 1.0 / perByte : 0.0; }
+    double BandwidthLow() const;
+    double BandwidthHigh() const;
+
+    // The time predicted for a frame of the given size, and the half-width of
+    // the 95% confidence interval of the prediction (of the average time).
+    double Predict(size_t bytes) const { return fixed + perByte * bytes; }
+    double PredictError(size_t bytes) const;
+};
+
+// Characterizes how the time of each stage grows with the frame size from the
+// measurements of the same path at several frame sizes (see the --ramp option),
+// so that the latency of frame sizes that were not measured can be predicted.
+class BandwidthModel
+{
+public:
+
+    // Adds the stage times of the frames received at the given format.
+    void AddStep(const TestFormat& format, const std::vector<std::shared_ptr<Frame>>& frames);
+
+    size_t Steps() const { return m_steps.size(); }
+
+    // Fits each stage that was measured at two or more frame sizes, along with
+    // the total time (metric "total").
+    std::vector<StageFit> Fit() const;
+
+    // Writes a CSV row with the average stage times of each step, followed by
+    // a row with the fit of each stage.
+    void Write(std::ostream& o) const;
+
+    // Fits a line to the given points using least squares.
+    static StageFit FitLine(const std::vector<double>& bytes, const std::vector<double>& times);
+
+private:
+
+    struct Step
+    {
+        TestFormat format;
+        size_t frames;
+
+        // The average time of each stage, indexed as m_metrics, and whether
+        // the stage was measured at all.
+        std::vector<double> times;
+        std::vector<bool> measured;
+    };
+
+    size_t MetricIndex(const std::string& metric, const std::string& label);
+
+    std::vector<std::string> m_metrics;
+    std::vector<std::string> m_labels;
+    std::vector<Step> m_steps;
+};
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "CaptureAnalysis.h"
+
+CaptureAnalysis::CaptureAnalysis(const std::vector<std::shared_ptr<Frame>>& frames,
+                                 const std::vector<ExternalSource::Capture>& captures,
+                                 const Microseconds& frameInterval)
+    : m_driverTimes(!captures.empty())
+    , m_droppedFrames(0)
+    , m_dropEvents(0)
+    , m_longestDrop(0)
+    , m_decodedIds(0)
+    , m_undecodedIds(0)
+    , m_sourceSkipped(0)
+    , m_sourceRepeated(0)
+{
+    // The captures of the received frames, which are looked up by the frame
+    // number since a consumer may capture frames that it does not receive.
+    std::map<uint32_t, const ExternalSource::Capture*> capturesByFrame;
+    for (const auto& c : captures)
+    {
+        capturesByFrame[c.frame] = &c;
+        m_driverTimes = m_driverTimes && c.driverTime != TimePoint();
+    }
+
+    // The received marker is not recorded when the instrumentation is off.
+    MarkerId receivedMarker = MarkerEnabled(MARKER_FRAME_RECEIVED) ? MARKER_FRAME_RECEIVED : MARKER_COPIED_TO_GPU;
+    auto arrival = [&](const Frame& f, const ExternalSource::Capture* c)
+    {
+        return m_driverTimes && c ? c->driverTime : f.Time(receivedMarker);
+    };
+
+    const Frame* previous = nullptr;
+    const ExternalSource::Capture* previousCapture = nullptr;
+    for (const auto& f : frames)
+    {
+        auto it = capturesByFrame.find(f->Number());
+        const ExternalSource::Capture* capture = it != capturesByFrame.end() ? it->second : nullptr;
+
+        if (capture && capture->driverTime != TimePoint() && MarkerEnabled(MARKER_FRAME_RECEIVED))
+            m_dequeueTimes.Append(capture->driverTime, f->Time(MARKER_FRAME_RECEIVED));
+        if (capture && capture->decoded)
+            m_decodedIds++;
+        else if (capture)
+            m_undecodedIds++;
+
+        if (previous)
+        {
+            uint32_t frames = f->Number() - previous->Number();
+            if (frames > 1)
+            {
+                m_droppedFrames += frames - 1;
+                m_dropEvents++;
+                m_longestDrop = std::max<size_t>(m_longestDrop, frames - 1);
+            }
+
+            Microseconds interval = std::chrono::duration_cast<Microseconds>(
+                arrival(*f, capture) - arrival(*previous, previousCapture));
+            Microseconds deviation = interval - frameInterval * frames;
+            m_intervals.Append(interval);
+            m_jitter.Append(deviation.count() < 0 ? -deviation : deviation);
+
+            // The embedded IDs should advance by as many frames as the driver
+            // sequence, modulo the number of distinct IDs. Advancing by more
+            // means that the source skipped frames, and by less that it
+            // repeated them (e.g. an ID that does not change at all).
+            if (capture && capture->decoded && previousCapture && previousCapture->decoded)
+            {
+                uint32_t ids = (capture->embeddedId + ExternalSource::EMBEDDED_ID_COUNT - previousCapture->embeddedId) %
+                               ExternalSource::EMBEDDED_ID_COUNT;
+                uint32_t expected = frames % ExternalSource::EMBEDDED_ID_COUNT;
+                if (ids > expected)
+                    m_sourceSkipped += ids - expected;
+                else
+                    m_sourceRepeated += expected - ids;
+            }
+        }
+        previous = f.get();
+        previousCapture = capture;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ExternalSource.h"
+#include "Frame.h"
+
+// Measures the frames captured from an external source (see ExternalSource):
+// how regularly the frames arrived, the frames that the capture path dropped
+// (the gaps in the driver sequence numbers), the time from the driver capture
+// until each frame was dequeued and, if the embedded frame IDs were decoded,
+// the frames that the source itself skipped or repeated.
+class CaptureAnalysis
+{
+public:
+
+    CaptureAnalysis(const std::vector<std::shared_ptr<Frame>>& frames,
+                    const std::vector<ExternalSource::Capture>& captures,
+                    const Microseconds& frameInterval);
+
+    // Whether the arrival times are the driver timestamps, rather than the
+    // times that the frames were received by the consumer.
+    bool DriverTimes() const { return m_driverTimes; }
+
+    // The times between the arrivals of successive captured frames, and how
+    // far each differed from the frame intervals expected between them
+    // (which counts the intervals of any frames dropped in between).
+    const DurationList& Intervals() const { return m_intervals; }
+    const DurationList& Jitter() const { return m_jitter; }
+
+    size_t DroppedFrames() const { return m_droppedFrames; }
+    size_t DropEvents() const { return m_dropEvents; }
+    size_t LongestDrop() const { return m_longestDrop; }
+
+    // The time from the driver timestamp until the frame was dequeued, if
+    // the driver gives timestamps.
+    const DurationList& DequeueTimes() const { return m_dequeueTimes; }
+
+    // The frames whose embedded ID was or was not decoded, and the frames
+    // that the embedded IDs show were skipped or repeated by the source.
+    size_t DecodedIds() const { return m_decodedIds; }
+    size_t UndecodedIds() const { return m_undecodedIds; }
+    size_t SourceSkipped() const { return m_sourceSkipped; }
+    size_t SourceRepeated() const { return m_sourceRepeated; }
+
+private:
+
+    bool m_driverTimes;
+    DurationList m_intervals;
+    DurationList m_jitter;
+    size_t m_droppedFrames;
+    size_t m_dropEvents;
+    size_t m_longestDrop;
+    DurationList m_dequeueTimes;
+    size_t m_decodedIds;
+    size_t m_undecodedIds;
+    size_t m_sourceSkipped;
+    size_t m_sourceRepeated;
+};
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "Consumer.h"
+#include "AsyncLog.h"
+#include "Console.h"
+#include "CudaUtils.h"
+
+Consumer::Consumer(std::shared_ptr<Producer> producer)
+    : m_producer(producer)
+    , m_flightRecorder(nullptr)
+    , m_convertToRGBA(false)
+    , m_convertedMarker(MAX_MARKERS)
+    , m_rgbaBuffer(nullptr)
+    , m_verifyFrames(false)
+    , m_verifiedMarker(MAX_MARKERS)
+    , m_cudaLineFlags(nullptr)
+    , m_cudaExpected(nullptr)
+    , m_corruptedFrames(0)
+    , m_resilient(false)
+    , m_maxGlitch(0)
+    , m_inGlitch(false)
+{
+    m_identifiedMarker = StageRegistry::Register("identified", "Identify Frame", "identify",
+                                                 STAGE_TOOL, MARKER_COPIED_TO_GPU);
+    WarnIfUnregistered(m_identifiedMarker, "Identify Frame");
+}
+
+Consumer::~Consumer()
+{
+    for (auto& t : m_snapshotThreads)
+        t.join();
+    if (m_rgbaBuffer)
+        CudaFree(m_rgbaBuffer);
+    if (m_cudaLineFlags)
+        CudaFree(m_cudaLineFlags);
+    if (m_cudaExpected)
+        CudaFree(m_cudaExpected);
+}
+
+void Consumer::ResetReceivedFrames()
+{
+    m_frames.clear();
+    m_glitches.clear();
+    m_inGlitch = false;
+    m_corruptedFrames = 0;
+    m_firstCaptureTime = TimePoint();
+}
+
+void Consumer::SetConvertToRGBA(bool convert)
+{
+    m_convertToRGBA = convert;
+    if (convert)
+    {
+        m_convertedMarker = StageRegistry::Register("converted", "Convert To RGBA", "convert",
+                                                    STAGE_CONSUMER, MARKER_COPIED_TO_GPU);
+        WarnIfUnregistered(m_convertedMarker, "Convert To RGBA");
+    }
+}
+
+void Consumer::SetVerifyFrames(bool verify)
+{
+    m_verifyFrames = verify;
+    if (verify)
+    {
+        m_verifiedMarker = StageRegistry::Register("verified", "Verify Frame", "verify",
+                                                   STAGE_TOOL, m_identifiedMarker);
+        WarnIfUnregistered(m_verifiedMarker, "Verify Frame");
+    }
+}
+
+void Consumer::SetResilient(bool resilient, const std::string& snapshotDirectory, Microseconds maxGlitch)
+{
+    m_resilient = resilient;
+    m_snapshotDirectory = snapshotDirectory;
+    m_maxGlitch = maxGlitch;
+}
+
+void Consumer::WarnIfUnregistered(MarkerId marker, const char* label)
+{
+    if (marker == MAX_MARKERS)
+        Warning("The '" << label << "' stage is not measured since all " << MAX_MARKERS << " markers are registered.");
+}
+
+bool Consumer::AllocateBuffers()
+{
+    const TestFormat& format = m_producer->Format();
+    if (m_convertToRGBA && !m_rgbaBuffer)
+    {
+        m_rgbaBuffer = (uint32_t*)CudaAlloc(format.width * format.height * sizeof(uint32_t));
+        if (!m_rgbaBuffer)
+            return false;
+    }
+    if (m_verifyFrames && !m_cudaLineFlags)
+    {
+        m_cudaLineFlags = (uint8_t*)CudaAlloc(format.height);
+        if (!m_cudaLineFlags)
+            return false;
+        m_lineFlags.resize(format.height);
+    }
+    if (m_verifyFrames && m_producer->Content() != CONTENT_SOLID && !m_cudaExpected)
+    {
+        m_cudaExpected = CudaAlloc(format.totalBytes);
+        if (!m_cudaExpected)
+            return false;
+    }
+    return true;
+}
+
+Timestamp Consumer::ConvertToRGBA(const void* cudaBuffer)
+{
+    if (!m_rgbaBuffer)
+        return Timestamp();
+    CudaConvertToRGBA(m_rgbaBuffer, cudaBuffer, m_producer->Format());
+    return Timestamp::Now(m_convertedMarker);
+}
+
+std::shared_ptr<Frame> Consumer::IdentifyFrame(const void* ptr, void* cudaBuffer, const Timestamp& received,
+                                               const DriverCapture& driver)
+{
+    auto frame = m_producer->IdentifyCapture(ptr, driver);
+    if (frame)
+    {
+        if (m_inGlitch)
+        {
+            m_glitches.back().end = received.time;
+            m_glitches.back().recovered = true;
+            m_inGlitch = false;
+        }
+        return frame;
+    }
+
+    if (!m_resilient)
+    {
+        FrameId id(m_producer->ReadFrameId(ptr));
+        Error("Could not find frame color (" << (int)id[0] << "," << (int)id[1] << "," << (int)id[2] <<
+              ") in producer records." << std::endl <<
+              "This means that the consumer received a frame color that was never" << std::endl <<
+              "generated by the producer. This could be caused by a general producer" << std::endl <<
+              "and/or consumer error, but it could also be caused by the loopback" << std::endl <<
+              "cable not being connected properly to the required device ports." << std::endl <<
+              "Please check the cable connections and try again.");
+        return frame;
+    }
+
+    RecordGlitch(received.time, cudaBuffer);
+    return frame;
+}
+
+bool Consumer::SkipGlitch() const
+{
+    return m_resilient && !(m_inGlitch && m_glitches.back().end - m_glitches.back().start > m_maxGlitch);
+}
+
+void Consumer::RecordGlitch(const TimePoint& time, void* cudaBuffer)
+{
+    if (!m_inGlitch)
+    {
+        Glitch glitch;
+        glitch.start = time;
+        glitch.captures = 0;
+        glitch.recovered = false;
+        m_glitches.push_back(glitch);
+        m_inGlitch = true;
+
+        if (m_glitches.size() <= MAX_LOGGED_GLITCHES)
+        {
+            auto sinceStart = std::chrono::duration_cast<std::chrono::milliseconds>(time - m_firstCaptureTime);
+            LogAsync("Glitch ", m_glitches.size(), ": ",
+                     cudaBuffer ? "unidentifiable frame" : "no frames", " at ", sinceStart.count(), " ms");
+        }
+        else if (m_glitches.size() == MAX_LOGGED_GLITCHES + 1)
+        {
+            LogAsync("Further glitches are not logged.");
+        }
+
+        if (cudaBuffer && m_snapshotDirectory.size() && m_glitches.size() <= MAX_GLITCH_SNAPSHOTS)
+            SnapshotFrame(cudaBuffer, m_glitches.size());
+    }
+    Glitch& glitch = m_glitches.back();
+    bool exceeded = glitch.end - glitch.start > m_maxGlitch;
+    glitch.end = time;
+    if (cudaBuffer)
+        glitch.captures++;
+
+    if (!exceeded && glitch.end - glitch.start > m_maxGlitch)
+    {
+        Error("Glitch " << m_glitches.size() << " lasted longer than the maximum of " <<
+              std::chrono::duration_cast<std::chrono::seconds>(m_maxGlitch).count() << " s (-c.max-glitch)." << std::endl <<
+              "The signal appears to be lost, so the capture is stopped.");
+    }
+}
+
+void Consumer::SnapshotFrame(void* cudaBuffer, size_t glitch)
+{
+    const TestFormat& format = m_producer->Format();
+    std::vector<uint8_t> data(format.totalBytes);
+    CudaMemcpyDtoH(data.data(), cudaBuffer, data.size());
+
+    std::ostringstream filename;
+    filename << m_snapshotDirectory << "/glitch-" << glitch << "-" << format.width << "x" << format.height
+             << "-" << PixelFormatName(format.pixelFormat) << ".raw";
+    m_snapshotThreads.emplace_back([data = std::move(data), filename = filename.str()]()
+    {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.write((const char*)data.data(), data.size()))
+            LogAsync("Failed to write glitch snapshot ", filename);
+    });
+}
+
+void Consumer::VerifyFrame(Frame* frame, const void* cudaBuffer)
+{
+    const TestFormat& format = m_producer->Format();
+    FramePattern pattern = m_producer->Pattern(*frame);
+    if (m_cudaExpected)
+    {
+        m_producer->RenderFrame(*frame, m_cudaExpected);
+        CudaVerifyFrame(cudaBuffer, m_cudaExpected, pattern, format.stride, format.ActiveLineBytes(),
+                        format.height, m_cudaLineFlags, m_lineFlags.data());
+    }
+    else
+    {
+        CudaVerifyPattern(cudaBuffer, pattern, format.stride, format.ActiveLineBytes(),
+                          format.height, m_cudaLineFlags, m_lineFlags.data());
+    }
+    frame->Record(m_verifiedMarker);
+
+    size_t mismatched = 0;
+    std::ostringstream ranges;
+    for (size_t line = 0; line < m_lineFlags.size();)
+    {
+        if (!m_lineFlags[line])
+        {
+            line++;
+            continue;
+        }
+        size_t first = line;
+        while (line < m_lineFlags.size() && m_lineFlags[line])
+            line++;
+        ranges << (mismatched ? ", " : "") << first;
+        if (line - 1 > first)
+            ranges << "-" << (line - 1);
+        mismatched += line - first;
+    }
+    if (!mismatched)
+        return;
+
+    frame->RecordMismatchedLines(mismatched);
+    if (m_corruptedFrames++ < MAX_LOGGED_CORRUPTIONS)
+    {
+        LogAsync("Frame ", frame->Number(), " does not match the expected contents in lines ", ranges.str());
+    }
+    else if (m_corruptedFrames == MAX_LOGGED_CORRUPTIONS + 1)
+    {
+        LogAsync("Further corrupted frames are not logged.");
+    }
+}
+
+void Consumer::ReceiveFrame(const std::shared_ptr<Frame>& frame, const void* cudaBuffer,
+                            const Timestamp& received, const Timestamp& readEnd,
+                            const Timestamp& copiedToGPU, const Timestamp& converted)
+{
+    Timestamp identified = Timestamp::Now(m_identifiedMarker);
+    if (m_frames.size() && m_frames.back()->Number() == frame->Number())
+    {
+        frame->RecordDuplicateReceive();
+    }
+    else
+    {
+        frame->Record(MARKER_FRAME_RECEIVED, received);
+        frame->Record(MARKER_READ_END, readEnd);
+        frame->Record(MARKER_COPIED_TO_GPU, copiedToGPU);
+        if (m_rgbaBuffer)
+            frame->Record(m_convertedMarker, converted);
+        frame->Record(m_identifiedMarker, identified);
+        frame->RecordFramesInFlight(m_producer->FramesInFlight());
+        if (m_verifyFrames)
+            VerifyFrame(frame.get(), cudaBuffer);
+        m_frames.push_back(frame);
+
+        if (m_flightRecorder)
+            m_flightRecorder->Add(*frame, frame->FramesInFlight());
+    }
+}
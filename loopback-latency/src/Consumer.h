@@ -22,13 +22,34 @@
 
 #pragma once
 
+#include <thread>
+
+#include "FlightRecorder.h"
 #include "Producer.h"
 
+// A run of consecutive captures that could not be identified as a produced
+// frame, such as the black or partial frames sent during a hot-plug or mode
+// switch, or a time without any captures at all.
+struct Glitch
+{
+    // The time of the first capture (or timeout) in the glitch.
+    TimePoint start;
+
+    // The time of the first identified capture after the glitch, or of the last
+    // capture in the glitch if no frame was identified after it.
+    TimePoint end;
+
+    // The number of unidentifiable captures.
+    size_t captures;
+
+    bool recovered;
+};
+
 class Consumer
 {
 public:
 
-    virtual ~Consumer() {}
+    virtual ~Consumer();
 
     virtual bool Initialize() = 0;
     virtual void Close() = 0;
@@ -40,13 +61,135 @@ public:
 
     const std::vector<std::shared_ptr<Frame>>& GetReceivedFrames() const { return m_frames; }
 
+    // Clears the frames, glitches and corruptions recorded by earlier captures
+    // so that the consumer can be reused for another measurement.
+    void ResetReceivedFrames();
+
+    // The time taken by each phase of the consumer startup.
+    const PhaseTimer& StartupPhases() const { return m_startupPhases; }
+
+    // The time that the first frame (including warmup frames) was captured
+    // since the last call to ResetFirstCapture.
+    TimePoint FirstCaptureTime() const { return m_firstCaptureTime; }
+    void ResetFirstCapture() { m_firstCaptureTime = TimePoint(); }
+
+    // Sets the flight recorder that received frames are added to, if any.
+    // This must not be changed while frames are being captured.
+    void SetFlightRecorder(FlightRecorder* recorder) { m_flightRecorder = recorder; }
+
+    // Enables the conversion of captured YUV frames to RGBA on the GPU, which
+    // is recorded as an additional consumer stage. This must be set before the
+    // consumer is initialized.
+    void SetConvertToRGBA(bool convert);
+
+    // Enables the verification of every line of each received frame against
+    // the expected frame contents, which is recorded as an additional stage
+    // of the tool. This must be set before the consumer is initialized.
+    void SetVerifyFrames(bool verify);
+
+    // Enables the resilient capture mode, where captured buffers that do not
+    // identify a produced frame are recorded as glitches and skipped rather
+    // than ending the capture. If a directory is given, the first buffer of
+    // each of the first MAX_GLITCH_SNAPSHOTS glitches is written to it. A
+    // glitch that lasts longer than maxGlitch (e.g. a signal that is lost for
+    // good) still ends the capture with an error.
+    void SetResilient(bool resilient, const std::string& snapshotDirectory, Microseconds maxGlitch);
+    bool Resilient() const { return m_resilient; }
+
+    const std::vector<Glitch>& Glitches() const { return m_glitches; }
+
 protected:
 
-    Consumer(std::shared_ptr<Producer> producer)
-        : m_producer(producer)
-    {}
+    Consumer(std::shared_ptr<Producer> producer);
+
+    // Warns that the stage of a marker is not measured since it could not be
+    // registered (see StageRegistry::Register).
+    static void WarnIfUnregistered(MarkerId marker, const char* label);
+
+    void RecordCapture(const TimePoint& time)
+    {
+        if (m_firstCaptureTime == TimePoint())
+            m_firstCaptureTime = time;
+    }
+
+    // Allocates the buffers used to convert and verify frames, if enabled.
+    // Called by the consumers during initialization.
+    bool AllocateBuffers();
+
+    // Converts the captured frame in the given GPU buffer to RGBA if enabled,
+    // returning the time at which the conversion finished.
+    Timestamp ConvertToRGBA(const void* cudaBuffer);
+
+    // Returns the produced frame that the captured buffer at the given host
+    // pointer identifies (see Producer::IdentifyCapture), along with what the
+    // driver reported about it, if anything. If it cannot be identified,
+    // returns null after either logging an error or, in the resilient mode,
+    // recording it as part of a glitch (with a snapshot of the captured frame
+    // in the given GPU buffer) so that the consumer can skip it and continue
+    // capturing.
+    std::shared_ptr<Frame> IdentifyFrame(const void* ptr, void* cudaBuffer, const Timestamp& received,
+                                         const DriverCapture& driver = DriverCapture());
+
+    // Returns whether the consumer should skip a capture that could not be
+    // identified (or a timeout) and keep capturing, which is the case in the
+    // resilient mode until the current glitch lasts longer than the maximum.
+    bool SkipGlitch() const;
+
+    // Records a capture that could not be identified, or a time without any
+    // captures if cudaBuffer is null, as part of the current glitch.
+    void RecordGlitch(const TimePoint& time, void* cudaBuffer);
+
+    // Copies the captured frame from the GPU and writes it to a raw file in
+    // the snapshot directory from a separate thread.
+    void SnapshotFrame(void* cudaBuffer, size_t glitch);
+
+    // Compares every line of the captured frame in the given GPU buffer with
+    // the expected contents of the frame, and logs the ranges of the lines
+    // that do not match (e.g. lines that were not written by a partial DMA).
+    // Frames with content other than the solid frame color are compared with
+    // a copy of the frame that is rendered again by the producer.
+    void VerifyFrame(Frame* frame, const void* cudaBuffer);
+
+    // Adds a frame that was identified by the producer to the received list
+    // along with its capture timestamps, or counts it as a duplicate if it is
+    // the same frame that was last received. The frame is verified using the
+    // captured copy in the given GPU buffer, if enabled.
+    void ReceiveFrame(const std::shared_ptr<Frame>& frame, const void* cudaBuffer,
+                      const Timestamp& received, const Timestamp& readEnd,
+                      const Timestamp& copiedToGPU, const Timestamp& converted);
 
     std::shared_ptr<Producer> m_producer;
+    FlightRecorder* m_flightRecorder;
+    MarkerId m_identifiedMarker;
+
+    bool m_convertToRGBA;
+    MarkerId m_convertedMarker;
+    uint32_t* m_rgbaBuffer;
+
+    // The number of corrupted frames that are logged as they are received.
+    static constexpr size_t MAX_LOGGED_CORRUPTIONS = 10;
+
+    bool m_verifyFrames;
+    MarkerId m_verifiedMarker;
+    uint8_t* m_cudaLineFlags;
+    void* m_cudaExpected;
+    std::vector<uint8_t> m_lineFlags;
+    size_t m_corruptedFrames;
+
+    // The number of glitches that are logged as they occur, and the number
+    // that have a snapshot written.
+    static constexpr size_t MAX_LOGGED_GLITCHES = 10;
+    static constexpr size_t MAX_GLITCH_SNAPSHOTS = 16;
+
+    bool m_resilient;
+    Microseconds m_maxGlitch;
+    bool m_inGlitch;
+    std::vector<Glitch> m_glitches;
+    std::string m_snapshotDirectory;
+    std::vector<std::thread> m_snapshotThreads;
+
+    PhaseTimer m_startupPhases;
+    TimePoint m_firstCaptureTime;
 
     std::vector<std::shared_ptr<Frame>> m_frames;
 };
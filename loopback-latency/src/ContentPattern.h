@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "FramePattern.h"
+
+// The content that producers write into each frame in addition to the frame
+// color. Solid color frames are unrealistically cheap for display pipelines
+// that compress frames, for video encoders and for the consumer caches, so
+// the other content types fill the frame (other than the ID lines) with
+// moving or high entropy images.
+enum ContentType
+{
+    CONTENT_SOLID,      // The frame color only
+    CONTENT_GRADIENT,   // Moving horizontal, vertical and diagonal gradients
+    CONTENT_ZONE_PLATE, // A moving circular zone plate up to the Nyquist frequency
+    CONTENT_BARS,       // Horizontally scrolling color bars
+    CONTENT_NOISE,      // Seeded random noise that changes every frame
+    CONTENT_TILE,       // Diagonally scrolling tiles of an image file
+    CONTENT_TYPE_COUNT,
+};
+
+inline const char* ContentTypeName(ContentType type)
+{
+    switch (type)
+    {
+        case CONTENT_SOLID:      return "solid";
+        case CONTENT_GRADIENT:   return "gradient";
+        case CONTENT_ZONE_PLATE: return "zoneplate";
+        case CONTENT_BARS:       return "bars";
+        case CONTENT_NOISE:      return "noise";
+        case CONTENT_TILE:       return "tile";
+        default:                 return "unknown";
+    }
+}
+
+// Returns the content type with the given name, or CONTENT_TYPE_COUNT if
+// there is no such type.
+inline ContentType ParseContentType(const char* name)
+{
+    for (int i = 0; i < CONTENT_TYPE_COUNT; i++)
+    {
+        if (!strcasecmp(name, ContentTypeName((ContentType)i)))
+            return (ContentType)i;
+    }
+    return CONTENT_TYPE_COUNT;
+}
+
+// The number of lines at the top of every frame that are always the solid
+// frame color, which covers the values that frames are identified by (see
+// FrameCodec) including the first chroma line of 4:2:0 formats.
+constexpr size_t CONTENT_ID_LINES = 2;
+
+// The parameters of the content, which are passed by value to the kernels.
+// The scales are precomputed so that the pixel functions only multiply
+// (rather than divide), which allows the host loops to be vectorized.
+struct ContentParams
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t seed;
+
+    uint32_t xScale;        // 256 / width (16.16 fixed point)
+    uint32_t yScale;        // 256 / height (16.16 fixed point)
+    uint32_t diagonalScale; // 256 / (width + height) (16.16 fixed point)
+    uint32_t barScale;      // 8 / width (16.16 fixed point)
+    float zoneScale;        // 1 / (2 * width)
+
+    // The 8-bit RGB pixels of the tile image, in host or GPU memory depending
+    // on where the content is written.
+    const uint8_t* tile;
+    uint32_t tileWidth;
+    uint32_t tileHeight;
+};
+
+inline ContentParams MakeContentParams(uint32_t width, uint32_t height, uint32_t seed)
+{
+    ContentParams p = {};
+    p.width = width;
+    p.height = height;
+    p.seed = seed;
+    p.xScale = (256 << 16) / width;
+    p.yScale = (256 << 16) / height;
+    p.diagonalScale = (256 << 16) / (width + height);
+    p.barScale = (8 << 16) / width;
+    p.zoneScale = 0.5f / width;
+    return p;
+}
+
+// Approximates cos(2 * pi * turns) for turns >= 0 using a parabola with a
+// correction term, which has an error of about 0.001 and is vectorized.
+PIXEL_FUNCTION float CosTurns(float turns)
+{
+    float u = turns + 0.25f;
+    u -= (float)(uint32_t)(u + 0.5f);
+    float y = 8.0f * u - 16.0f * u * fabsf(u);
+    return 0.225f * (y * fabsf(y) - y) + y;
+}
+
+// The 8-bit RGB value of each pixel of the content, which is a function of the
+// pixel position and the frame number only.
+template <ContentType C> struct Content;
+
+template <> struct Content<CONTENT_GRADIENT>
+{
+    PIXEL_FUNCTION static FrameId Pixel(const ContentParams& p, uint32_t x, uint32_t y, uint32_t frame)
+    {
+        return { uint8_t(((x * p.xScale) >> 16) + frame * 4),
+                 uint8_t(((y * p.yScale) >> 16) + frame * 2),
+                 uint8_t((((x + y) * p.diagonalScale) >> 16) - frame * 3) };
+    }
+};
+
+template <> struct Content<CONTENT_ZONE_PLATE>
+{
+    // The phase (in turns) increases with the square of the distance from the
+    // center such that the frequency reaches half a cycle per pixel at the left
+    // and right edges.
+    PIXEL_FUNCTION static FrameId Pixel(const ContentParams& p, uint32_t x, uint32_t y, uint32_t frame)
+    {
+        float dx = (float)x - p.width * 0.5f;
+        float dy = (float)y - p.height * 0.5f;
+        float turns = (dx * dx + dy * dy) * p.zoneScale + (frame % 25) * 0.04f;
+        uint8_t v = uint8_t(127.5f + 127.0f * CosTurns(turns));
+        return { v, v, v };
+    }
+};
+
+template <> struct Content<CONTENT_BARS>
+{
+    // Eight bars (white, yellow, cyan, green, magenta, red, blue and black)
+    // that scroll by 8 pixels per frame.
+    PIXEL_FUNCTION static FrameId Pixel(const ContentParams& p, uint32_t x, uint32_t, uint32_t frame)
+    {
+        uint32_t offset = x + frame * 8 % p.width;
+        offset -= offset >= p.width ? p.width : 0;
+        offset -= offset >= p.width ? p.width : 0;
+        uint32_t bar = (offset * p.barScale) >> 16;
+        return { uint8_t(bar & 2 ? 16 : 235), uint8_t(bar & 4 ? 16 : 235), uint8_t(bar & 1 ? 16 : 235) };
+    }
+};
+
+template <> struct Content<CONTENT_NOISE>
+{
+    PIXEL_FUNCTION static FrameId Pixel(const ContentParams& p, uint32_t x, uint32_t y, uint32_t frame)
+    {
+        uint32_t h = (x * 0x8DA6B343u) ^ (y * 0xD8163841u) ^ (frame * 0xCB1AB31Fu) ^ p.seed;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return { uint8_t(h), uint8_t(h >> 8), uint8_t(h >> 16) };
+    }
+};
+
+template <> struct Content<CONTENT_TILE>
+{
+    // The tiles scroll diagonally by one pixel per frame.
+    PIXEL_FUNCTION static FrameId Pixel(const ContentParams& p, uint32_t x, uint32_t y, uint32_t frame)
+    {
+        const uint8_t* t = p.tile + ((y + frame) % p.tileHeight * p.tileWidth + (x + frame) % p.tileWidth) * 3;
+        return { t[0], t[1], t[2] };
+    }
+};
+
+// Converts 8-bit RGB to limited range BT.709 YUV.
+PIXEL_FUNCTION FrameId RGBToYUV(const FrameId& rgb)
+{
+    int r = rgb[0], g = rgb[1], b = rgb[2];
+    return { uint8_t(16 + ((47 * r + 157 * g + 16 * b + 128) >> 8)),
+             uint8_t(128 + ((-26 * r - 87 * g + 112 * b + 128) >> 8)),
+             uint8_t(128 + ((112 * r - 102 * g - 10 * b + 128) >> 8)) };
+}
+
+// The value of a content pixel in the color space of a layout.
+template <ContentType C, bool YUV>
+PIXEL_FUNCTION FrameId ContentPixel(const ContentParams& p, uint32_t x, uint32_t y, uint32_t frame)
+{
+    FrameId rgb = Content<C>::Pixel(p, x, y, frame);
+    return YUV ? RGBToYUV(rgb) : rgb;
+}
+
+// Writes the content of one group of pixels (see PixelFormatLayout::Store).
+template <PixelFormat F, ContentType C>
+PIXEL_FUNCTION void WriteContentGroup(uint8_t* frame, size_t stride, size_t chromaOffset,
+                                      const ContentParams& p, size_t x, size_t y, uint32_t frameNumber)
+{
+    using Layout = PixelFormatLayout<F>;
+    FrameId pixels[Layout::GROUP_PIXELS];
+    for (size_t i = 0; i < Layout::GROUP_PIXELS; i++)
+        pixels[i] = ContentPixel<C, Layout::YUV>(p, x + i, y, frameNumber);
+    Layout::Store(frame, stride, chromaOffset, x, y, pixels);
+}
+
+// Returns Writer<F, C>::Write for the given pixel format and content type, or
+// null for solid content. This is used to select the specialization once
+// rather than branching for every frame or pixel.
+template <template <PixelFormat, ContentType> class Writer, PixelFormat F>
+auto SelectContentWriterFor(ContentType type) -> decltype(&Writer<F, CONTENT_GRADIENT>::Write)
+{
+    switch (type)
+    {
+        case CONTENT_GRADIENT:   return &Writer<F, CONTENT_GRADIENT>::Write;
+        case CONTENT_ZONE_PLATE: return &Writer<F, CONTENT_ZONE_PLATE>::Write;
+        case CONTENT_BARS:       return &Writer<F, CONTENT_BARS>::Write;
+        case CONTENT_NOISE:      return &Writer<F, CONTENT_NOISE>::Write;
+        case CONTENT_TILE:       return &Writer<F, CONTENT_TILE>::Write;
+        default:                 return nullptr;
+    }
+}
+
+template <template <PixelFormat, ContentType> class Writer>
+auto SelectContentWriter(PixelFormat format, ContentType type) -> decltype(&Writer<PIXEL_FORMAT_RGBA, CONTENT_GRADIENT>::Write)
+{
+    switch (format)
+    {
+        case PIXEL_FORMAT_UYVY:    return SelectContentWriterFor<Writer, PIXEL_FORMAT_UYVY>(type);
+        case PIXEL_FORMAT_YUYV:    return SelectContentWriterFor<Writer, PIXEL_FORMAT_YUYV>(type);
+        case PIXEL_FORMAT_NV12:    return SelectContentWriterFor<Writer, PIXEL_FORMAT_NV12>(type);
+        case PIXEL_FORMAT_RGB10A2: return SelectContentWriterFor<Writer, PIXEL_FORMAT_RGB10A2>(type);
+        case PIXEL_FORMAT_V210:    return SelectContentWriterFor<Writer, PIXEL_FORMAT_V210>(type);
+        case PIXEL_FORMAT_P010:    return SelectContentWriterFor<Writer, PIXEL_FORMAT_P010>(type);
+        default:                   return SelectContentWriterFor<Writer, PIXEL_FORMAT_RGBA>(type);
+    }
+}
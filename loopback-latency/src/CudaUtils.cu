@@ -25,6 +25,12 @@
 #include "CudaUtils.h"
 #include "Console.h"
 
+void CudaInitialize()
+{
+    // Freeing a null pointer is a no-op, but forces the CUDA context creation.
+    cudaFree(0);
+}
+
 void* CudaAlloc(size_t size, bool enableRDMA)
 {
     void* ptr;
@@ -58,7 +64,7 @@ void CudaMemcpyHtoD(void* dev, void* host, size_t bytes)
 }
 
 __global__
-void WriteRGBA(uint32_t *ptr, size_t elementCount, uint32_t value)
+void WriteBlock(uint4 *ptr, size_t elementCount, uint4 value)
 {
     int index = blockIdx.x * blockDim.x + threadIdx.x;
     int stride = blockDim.x * gridDim.x;
@@ -68,13 +74,363 @@ void WriteRGBA(uint32_t *ptr, size_t elementCount, uint32_t value)
     }
 }
 
-void CudaWriteRGBA(uint32_t* ptr, size_t elementCount, uint8_t r, uint8_t g, uint8_t b)
+// Writes the bytes of a plane that cannot use 128-bit stores, which are
+// either a partial block at the end or a plane that is not 16 byte aligned.
+__global__
+void WriteBlockBytes(uint8_t *ptr, size_t bytes, uint4 value)
+{
+    const uint8_t* block = (const uint8_t*)&value;
+    int index = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+    for (int i = index; i < bytes; i += stride)
+    {
+        ptr[i] = block[i % sizeof(uint4)];
+    }
+}
+
+void CudaWritePattern(void* ptr, const FramePattern& pattern)
 {
     unsigned int blockSize = 1024;
-    unsigned int numBlocks = (elementCount + blockSize - 1) / blockSize;
 
-    uint32_t abgr = (0xFF << 24) | (b << 16) | (g << 8) | (r << 0);
-    WriteRGBA<<<numBlocks, blockSize>>>(ptr, elementCount, abgr);
+    for (size_t i = 0; i < pattern.planeCount; i++)
+    {
+        const FramePattern::Plane& plane = pattern.planes[i];
+        uint8_t* planePtr = (uint8_t*)ptr + plane.offset;
+        uint4 value;
+        memcpy(&value, plane.block, sizeof(value));
+
+        size_t elementCount = ((uintptr_t)planePtr % sizeof(uint4)) ? 0 : plane.bytes / sizeof(uint4);
+        if (elementCount)
+        {
+            unsigned int numBlocks = (elementCount + blockSize - 1) / blockSize;
+            WriteBlock<<<numBlocks, blockSize>>>((uint4*)planePtr, elementCount, value);
+        }
+
+        size_t written = elementCount * sizeof(uint4);
+        if (written < plane.bytes)
+        {
+            unsigned int numBlocks = (plane.bytes - written + blockSize - 1) / blockSize;
+            WriteBlockBytes<<<numBlocks, blockSize>>>(planePtr + written, plane.bytes - written, value);
+        }
+    }
+
+    cudaStreamSynchronize(cudaStreamPerThread);
+}
+
+// Each thread block compares one line of a plane with the pattern, reducing
+// the result of every thread to a single flag for the picture lines that the
+// plane line covers (2 for the chroma plane of 4:2:0 formats). Only the first
+// lineBytes of each line are compared, since the line padding (and a partial
+// last v210 block) is not sent over the link. Lines are read with 128-bit
+// loads where possible, then 32-bit loads, and only 8-bit formats may have
+// lines that are not a whole number of words.
+__global__
+void VerifyLines(const uint8_t* plane, FramePattern pattern, size_t planeIndex,
+                 size_t stride, size_t lineBytes, size_t lineScale, uint8_t* lineFlags)
+{
+    size_t line = blockIdx.x;
+    const uint8_t* src = plane + line * stride;
+    const uint8_t* expected = pattern.planes[planeIndex].block;
+    size_t phase = (line * stride) % FramePattern::BLOCK_SIZE;
+    bool mismatch = false;
+
+    if ((uintptr_t)src % sizeof(uint4) == 0 && lineBytes % sizeof(uint4) == 0)
+    {
+        const uint4* blocks = (const uint4*)src;
+        uint4 e = *(const uint4*)expected;
+        for (size_t i = threadIdx.x; i < lineBytes / sizeof(uint4); i += blockDim.x)
+        {
+            uint4 b = blocks[i];
+            mismatch |= !(pattern.WordMatches(b.x, e.x) && pattern.WordMatches(b.y, e.y) &&
+                          pattern.WordMatches(b.z, e.z) && pattern.WordMatches(b.w, e.w));
+        }
+    }
+    else if ((uintptr_t)src % sizeof(uint32_t) == 0 && lineBytes % sizeof(uint32_t) == 0)
+    {
+        const uint32_t* words = (const uint32_t*)src;
+        const uint32_t* e = (const uint32_t*)expected;
+        for (size_t i = threadIdx.x; i < lineBytes / sizeof(uint32_t); i += blockDim.x)
+        {
+            mismatch |= !pattern.WordMatches(words[i], e[(phase / sizeof(uint32_t) + i) % 4]);
+        }
+    }
+    else
+    {
+        for (size_t i = threadIdx.x; i < lineBytes; i += blockDim.x)
+        {
+            mismatch |= SampleDiff(src[i], expected[(phase + i) % FramePattern::BLOCK_SIZE], 0, 0xFF) > 1;
+        }
+    }
+
+    if (__syncthreads_or(mismatch) && threadIdx.x == 0)
+    {
+        for (size_t i = 0; i < lineScale; i++)
+        {
+            lineFlags[line * lineScale + i] = 1;
+        }
+    }
+}
+
+// As VerifyLines, comparing each line with the same line of an expected frame.
+__global__
+void VerifyFrameLines(const uint8_t* plane, const uint8_t* expectedPlane, FramePattern pattern,
+                      size_t stride, size_t lineBytes, size_t lineScale, uint8_t* lineFlags)
+{
+    size_t line = blockIdx.x;
+    const uint8_t* src = plane + line * stride;
+    const uint8_t* expected = expectedPlane + line * stride;
+    bool mismatch = false;
+
+    if ((uintptr_t)src % sizeof(uint4) == 0 && lineBytes % sizeof(uint4) == 0)
+    {
+        const uint4* blocks = (const uint4*)src;
+        const uint4* expectedBlocks = (const uint4*)expected;
+        for (size_t i = threadIdx.x; i < lineBytes / sizeof(uint4); i += blockDim.x)
+        {
+            uint4 b = blocks[i];
+            uint4 e = expectedBlocks[i];
+            mismatch |= !(pattern.WordMatches(b.x, e.x) && pattern.WordMatches(b.y, e.y) &&
+                          pattern.WordMatches(b.z, e.z) && pattern.WordMatches(b.w, e.w));
+        }
+    }
+    else if ((uintptr_t)src % sizeof(uint32_t) == 0 && lineBytes % sizeof(uint32_t) == 0)
+    {
+        const uint32_t* words = (const uint32_t*)src;
+        const uint32_t* expectedWords = (const uint32_t*)expected;
+        for (size_t i = threadIdx.x; i < lineBytes / sizeof(uint32_t); i += blockDim.x)
+        {
+            mismatch |= !pattern.WordMatches(words[i], expectedWords[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = threadIdx.x; i < lineBytes; i += blockDim.x)
+        {
+            mismatch |= SampleDiff(src[i], expected[i], 0, 0xFF) > 1;
+        }
+    }
+
+    if (__syncthreads_or(mismatch) && threadIdx.x == 0)
+    {
+        for (size_t i = 0; i < lineScale; i++)
+        {
+            lineFlags[line * lineScale + i] = 1;
+        }
+    }
+}
+
+void CudaVerifyFrame(const void* ptr, const void* expected, const FramePattern& pattern, size_t stride,
+                     size_t lineBytes, size_t height, uint8_t* cudaLineFlags, uint8_t* lineFlags)
+{
+    cudaMemsetAsync(cudaLineFlags, 0, height, cudaStreamPerThread);
+
+    for (size_t i = 0; i < pattern.planeCount; i++)
+    {
+        const FramePattern::Plane& plane = pattern.planes[i];
+        size_t lineCount = plane.bytes / stride;
+        if (!lineCount)
+            continue;
+        VerifyFrameLines<<<lineCount, 256>>>((const uint8_t*)ptr + plane.offset,
+                                             (const uint8_t*)expected + plane.offset, pattern,
+                                             stride, lineBytes, height / lineCount, cudaLineFlags);
+    }
+
+    cudaMemcpy(lineFlags, cudaLineFlags, height, cudaMemcpyDeviceToHost);
+}
+
+void CudaVerifyPattern(const void* ptr, const FramePattern& pattern, size_t stride, size_t lineBytes,
+                       size_t height, uint8_t* cudaLineFlags, uint8_t* lineFlags)
+{
+    cudaMemsetAsync(cudaLineFlags, 0, height, cudaStreamPerThread);
+
+    for (size_t i = 0; i < pattern.planeCount; i++)
+    {
+        const FramePattern::Plane& plane = pattern.planes[i];
+        size_t lineCount = plane.bytes / stride;
+        if (!lineCount)
+            continue;
+        VerifyLines<<<lineCount, 256>>>((const uint8_t*)ptr + plane.offset, pattern, i,
+                                         stride, lineBytes, height / lineCount, cudaLineFlags);
+    }
+
+    cudaMemcpy(lineFlags, cudaLineFlags, height, cudaMemcpyDeviceToHost);
+}
+
+// Each thread writes the content of one group of pixels (see
+// PixelFormatLayout::Store) below the ID lines.
+template <PixelFormat F, ContentType C>
+__global__
+void WriteContent(uint8_t* frame, TestFormat format, ContentParams content, uint32_t frameNumber)
+{
+    constexpr size_t GROUP_PIXELS = PixelFormatLayout<F>::GROUP_PIXELS;
+    size_t groupsPerLine = (format.width + GROUP_PIXELS - 1) / GROUP_PIXELS;
+    size_t groupCount = groupsPerLine * (format.height - CONTENT_ID_LINES);
+    size_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    size_t stride = blockDim.x * gridDim.x;
+    for (size_t i = index; i < groupCount; i += stride)
+    {
+        size_t x = i % groupsPerLine * GROUP_PIXELS;
+        size_t y = i / groupsPerLine + CONTENT_ID_LINES;
+        WriteContentGroup<F, C>(frame, format.stride, format.chromaOffset, content, x, y, frameNumber);
+    }
+}
+
+template <PixelFormat F, ContentType C>
+struct CudaContentWriterImpl
+{
+    static void Write(void* ptr, const TestFormat& format, const ContentParams& content, uint32_t frameNumber)
+    {
+        constexpr size_t GROUP_PIXELS = PixelFormatLayout<F>::GROUP_PIXELS;
+        unsigned int blockSize = 256;
+        size_t groupCount = (format.width + GROUP_PIXELS - 1) / GROUP_PIXELS * (format.height - CONTENT_ID_LINES);
+        unsigned int numBlocks = (groupCount + blockSize - 1) / blockSize;
+
+        WriteContent<F, C><<<numBlocks, blockSize>>>((uint8_t*)ptr, format, content, frameNumber);
+
+        cudaStreamSynchronize(cudaStreamPerThread);
+    }
+};
+
+CudaContentWriter CudaSelectContentWriter(PixelFormat format, ContentType type)
+{
+    return SelectContentWriter<CudaContentWriterImpl>(format, type);
+}
+
+// Converts limited range BT.709 YUV to RGBA (R in the lowest byte).
+__device__
+uint32_t YUVToRGBA(int y, int u, int v)
+{
+    float c = 1.164f * (y - 16);
+    float d = u - 128;
+    float e = v - 128;
+    int r = min(max(__float2int_rn(c + 1.793f * e), 0), 255);
+    int g = min(max(__float2int_rn(c - 0.213f * d - 0.533f * e), 0), 255);
+    int b = min(max(__float2int_rn(c + 2.112f * d), 0), 255);
+    return (0xFF << 24) | (b << 16) | (g << 8) | (r << 0);
+}
+
+// Each thread converts one 4:2:2 macropixel (2 pixels) with a single 32-bit
+// read and a single 64-bit write. The arguments give the byte index of each
+// value within the macropixel.
+__global__
+void ConvertPacked422(uint2* rgba, const uint32_t* src, size_t macropixelCount,
+                      int y0Byte, int y1Byte, int uByte, int vByte)
+{
+    int index = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+    for (int i = index; i < macropixelCount; i += stride)
+    {
+        uint32_t m = src[i];
+        int u = (m >> (uByte * 8)) & 0xFF;
+        int v = (m >> (vByte * 8)) & 0xFF;
+        rgba[i] = make_uint2(YUVToRGBA((m >> (y0Byte * 8)) & 0xFF, u, v),
+                             YUVToRGBA((m >> (y1Byte * 8)) & 0xFF, u, v));
+    }
+}
+
+// Each thread converts one 2x2 block of pixels that share a UV pair.
+__global__
+void ConvertNV12(uint2* rgba, const uint8_t* src, size_t width, size_t height)
+{
+    int index = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+    int blocksPerRow = width / 2;
+    for (int i = index; i < blocksPerRow * (height / 2); i += stride)
+    {
+        int x = i % blocksPerRow;
+        int row = (i / blocksPerRow) * 2;
+        uchar2 uv = ((const uchar2*)(src + width * height + (row / 2) * width))[x];
+        for (int dy = 0; dy < 2; dy++)
+        {
+            uchar2 y = ((const uchar2*)(src + (row + dy) * width))[x];
+            rgba[(row + dy) * blocksPerRow + x] = make_uint2(YUVToRGBA(y.x, uv.x, uv.y),
+                                                             YUVToRGBA(y.y, uv.x, uv.y));
+        }
+    }
+}
+
+// Each thread converts one 2x2 block of pixels that share a UV pair, using
+// the upper 8 bits of each 16-bit sample.
+__global__
+void ConvertP010(uint2* rgba, const uint8_t* src, size_t width, size_t height, size_t stride)
+{
+    int index = blockIdx.x * blockDim.x + threadIdx.x;
+    int gridStride = blockDim.x * gridDim.x;
+    int blocksPerRow = width / 2;
+    for (int i = index; i < blocksPerRow * (height / 2); i += gridStride)
+    {
+        int x = i % blocksPerRow;
+        int row = (i / blocksPerRow) * 2;
+        ushort2 uv = ((const ushort2*)(src + stride * height + (row / 2) * stride))[x];
+        for (int dy = 0; dy < 2; dy++)
+        {
+            ushort2 y = ((const ushort2*)(src + (row + dy) * stride))[x];
+            rgba[(row + dy) * blocksPerRow + x] = make_uint2(YUVToRGBA(y.x >> 8, uv.x >> 8, uv.y >> 8),
+                                                             YUVToRGBA(y.y >> 8, uv.x >> 8, uv.y >> 8));
+        }
+    }
+}
+
+// Each thread converts one v210 block of 6 pixels, which is read with a
+// single 128-bit load. The last block of a line may be partially used.
+__global__
+void ConvertV210(uint32_t* rgba, const uint8_t* src, size_t width, size_t height, size_t stride)
+{
+    int index = blockIdx.x * blockDim.x + threadIdx.x;
+    int gridStride = blockDim.x * gridDim.x;
+    int blocksPerRow = (width + 5) / 6;
+    for (int i = index; i < blocksPerRow * height; i += gridStride)
+    {
+        int row = i / blocksPerRow;
+        int x = (i % blocksPerRow) * 6;
+        uint4 b = ((const uint4*)(src + row * stride))[i % blocksPerRow];
+
+        // The 8-bit Y, U and V values of the block in pixel order.
+        int y[6] = { (int)(b.x >> 12) & 0xFF, (int)(b.y >> 2) & 0xFF, (int)(b.y >> 22) & 0xFF,
+                     (int)(b.z >> 12) & 0xFF, (int)(b.w >> 2) & 0xFF, (int)(b.w >> 22) & 0xFF };
+        int u[3] = { (int)(b.x >> 2) & 0xFF, (int)(b.y >> 12) & 0xFF, (int)(b.z >> 22) & 0xFF };
+        int v[3] = { (int)(b.x >> 22) & 0xFF, (int)(b.z >> 2) & 0xFF, (int)(b.w >> 12) & 0xFF };
+
+        uint32_t* dst = rgba + row * width + x;
+        for (int p = 0; p < 6 && x + p < width; p++)
+        {
+            dst[p] = YUVToRGBA(y[p], u[p / 2], v[p / 2]);
+        }
+    }
+}
+
+void CudaConvertToRGBA(uint32_t* rgba, const void* src, const TestFormat& format)
+{
+    unsigned int blockSize = 1024;
+    size_t pairCount = format.width * format.height / 2;
+    unsigned int numBlocks = (pairCount + blockSize - 1) / blockSize;
+
+    switch (format.pixelFormat)
+    {
+        case PIXEL_FORMAT_UYVY:
+            ConvertPacked422<<<numBlocks, blockSize>>>((uint2*)rgba, (const uint32_t*)src, pairCount, 1, 3, 0, 2);
+            break;
+        case PIXEL_FORMAT_YUYV:
+            ConvertPacked422<<<numBlocks, blockSize>>>((uint2*)rgba, (const uint32_t*)src, pairCount, 0, 2, 1, 3);
+            break;
+        case PIXEL_FORMAT_NV12:
+            numBlocks = (pairCount / 2 + blockSize - 1) / blockSize;
+            ConvertNV12<<<numBlocks, blockSize>>>((uint2*)rgba, (const uint8_t*)src, format.width, format.height);
+            break;
+        case PIXEL_FORMAT_P010:
+            numBlocks = (pairCount / 2 + blockSize - 1) / blockSize;
+            ConvertP010<<<numBlocks, blockSize>>>((uint2*)rgba, (const uint8_t*)src,
+                                                  format.width, format.height, format.stride);
+            break;
+        case PIXEL_FORMAT_V210:
+            numBlocks = ((format.width + 5) / 6 * format.height + blockSize - 1) / blockSize;
+            ConvertV210<<<numBlocks, blockSize>>>(rgba, (const uint8_t*)src,
+                                                  format.width, format.height, format.stride);
+            break;
+        default:
+            Error("Not a YUV format: " << PixelFormatName(format.pixelFormat));
+            return;
+    }
 
     cudaStreamSynchronize(cudaStreamPerThread);
 }
@@ -24,10 +24,24 @@
 
 #include <stdint.h>
 
+#include "ContentPattern.h"
+
+void CudaInitialize();
 void* CudaAlloc(size_t size, bool enableRDMA = false);
 void CudaFree(void* ptr);
 void CudaMemcpyDtoH(void* host, void* dev, size_t bytes);
 void CudaMemcpyHtoD(void* dev, void* host, size_t bytes);
 
-void CudaWriteRGBA(uint32_t* ptr, size_t elementCount, uint8_t r, uint8_t g, uint8_t b);
+void CudaWritePattern(void* ptr, const FramePattern& pattern);
+void CudaVerifyFrame(const void* ptr, const void* expected, const FramePattern& pattern, size_t stride,
+                     size_t lineBytes, size_t height, uint8_t* cudaLineFlags, uint8_t* lineFlags);
+void CudaVerifyPattern(const void* ptr, const FramePattern& pattern, size_t stride, size_t lineBytes,
+                       size_t height, uint8_t* cudaLineFlags, uint8_t* lineFlags);
+
+// Writes the content of a frame, other than the ID lines (see FrameContent).
+using CudaContentWriter = void (*)(void* ptr, const TestFormat& format, const ContentParams& content,
+                                   uint32_t frameNumber);
+CudaContentWriter CudaSelectContentWriter(PixelFormat format, ContentType type);
+
+void CudaConvertToRGBA(uint32_t* rgba, const void* src, const TestFormat& format);
 void CudaSimulateProcessing(uint32_t* ptr, size_t elementCount, size_t loopCount);
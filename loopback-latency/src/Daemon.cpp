@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Daemon.h"
+#include "AsyncLog.h"
+#include "Console.h"
+
+namespace Daemon
+{
+
+namespace
+{
+
+// The longest request that is accepted, and the time that a client has to
+// send it.
+constexpr size_t MAX_REQUEST_SIZE = 4096;
+constexpr std::chrono::milliseconds REQUEST_TIMEOUT(5000);
+
+volatile sig_atomic_t s_stopped = 0;
+
+void Stop(int)
+{
+    s_stopped = 1;
+}
+
+bool MakeAddress(const std::string& path, sockaddr_un* address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address->sun_path))
+    {
+        Error("The socket path is too long: " << path);
+        return false;
+    }
+    strncpy(address->sun_path, path.c_str(), sizeof(address->sun_path) - 1);
+    return true;
+}
+
+// Reads the request line of a connection, which ends at a newline or when the
+// client shuts down its end. Returns false if the request is too long or not
+// received in time, since the daemon serves one connection at a time and a
+// stalled client would otherwise block it.
+bool ReceiveRequest(int connection, std::string* request)
+{
+    auto deadline = std::chrono::steady_clock::now() + REQUEST_TIMEOUT;
+    while (request->size() < MAX_REQUEST_SIZE)
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+            return false;
+        pollfd fd = { connection, POLLIN, 0 };
+        int ready = poll(&fd, 1, remaining.count());
+        if (ready < 0 && errno == EINTR && !s_stopped)
+            continue;
+        if (ready <= 0)
+            return false;
+
+        char c;
+        ssize_t received = recv(connection, &c, 1, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0)
+            return false;
+        if (received == 0 || c == '\n')
+            return true;
+        request->push_back(c);
+    }
+    return false;
+}
+
+bool SendAll(int connection, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(connection, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+}
+
+Server::Server()
+    : m_socket(-1)
+{
+}
+
+Server::~Server()
+{
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        unlink(m_path.c_str());
+    }
+}
+
+bool Server::Listen(const std::string& path)
+{
+    sockaddr_un address;
+    if (!MakeAddress(path, &address))
+        return false;
+
+    // Only a socket is replaced, so that a mistyped path cannot remove a file.
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            Error("Cannot create the daemon socket since " << path << " exists and is not a socket.");
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0)
+    {
+        Error("Failed to create the daemon socket: " << strerror(errno));
+        return false;
+    }
+    if (bind(m_socket, (const sockaddr*)&address, sizeof(address)) < 0 || listen(m_socket, 8) < 0)
+    {
+        Error("Failed to listen on " << path << ": " << strerror(errno));
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    m_path = path;
+
+    // SIGINT and SIGTERM interrupt the wait for a connection (no SA_RESTART)
+    // so that the daemon exits cleanly, restoring any tuned system settings
+    // and removing the socket.
+    struct sigaction action = {};
+    action.sa_handler = Stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    return true;
+}
+
+int Server::Accept(std::vector<std::string>* arguments)
+{
+    while (!s_stopped)
+    {
+        int connection = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            Error("Failed to accept a daemon connection: " << strerror(errno));
+            return -1;
+        }
+
+        // The request is a single line.
+        std::string request;
+        if (!ReceiveRequest(connection, &request))
+        {
+            Warning("Ignoring an invalid or stalled daemon request.");
+            close(connection);
+            continue;
+        }
+
+        arguments->clear();
+        std::istringstream ss(request);
+        std::string argument;
+        while (ss >> argument)
+            arguments->push_back(argument);
+        return connection;
+    }
+    return -1;
+}
+
+void Server::Finish(int connection, int status)
+{
+    std::ostringstream ss;
+    ss << STATUS_PREFIX << status << std::endl;
+    SendAll(connection, ss.str().data(), ss.str().size());
+    close(connection);
+}
+
+OutputRedirect::OutputRedirect(int connection)
+    : m_connection(connection)
+{
+    // The AsyncLog drain thread does not write to std::cout itself, so that
+    // its buffer can be swapped here while messages are being written.
+    AsyncLog::Flush();
+    std::cout.flush();
+    std::cerr.flush();
+    m_cout = std::cout.rdbuf(this);
+    m_cerr = std::cerr.rdbuf(this);
+    m_log = AsyncLog::SetOutput(this);
+}
+
+OutputRedirect::~OutputRedirect()
+{
+    AsyncLog::Flush();
+    AsyncLog::SetOutput(m_log);
+    std::cout.rdbuf(m_cout);
+    std::cerr.rdbuf(m_cerr);
+}
+
+int OutputRedirect::overflow(int c)
+{
+    if (c != traits_type::eof())
+    {
+        char ch = c;
+        SendAll(m_connection, &ch, 1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize OutputRedirect::xsputn(const char* s, std::streamsize n)
+{
+    // The output of a disconnected client is dropped rather than failing the
+    // stream, which would silence the daemon's own output after the run.
+    SendAll(m_connection, s, n);
+    return n;
+}
+
+int RunClient(const std::string& path, const std::vector<std::string>& arguments)
+{
+    sockaddr_un address;
+    if (!MakeAddress(path, &address))
+        return 1;
+
+    int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection < 0 || connect(connection, (const sockaddr*)&address, sizeof(address)) < 0)
+    {
+        Error("Failed to connect to the daemon at " << path << ": " << strerror(errno));
+        if (connection >= 0)
+            close(connection);
+        return 1;
+    }
+
+    std::string request;
+    for (const auto& argument : arguments)
+    {
+        if (argument.find_first_of(" \t\n") != std::string::npos)
+        {
+            Error("Daemon arguments cannot contain whitespace: '" << argument << "'");
+            close(connection);
+            return 1;
+        }
+        request += (request.empty() ? "" : " ") + argument;
+    }
+    request += "\n";
+    if (!SendAll(connection, request.data(), request.size()))
+    {
+        Error("Failed to send the request to the daemon: " << strerror(errno));
+        close(connection);
+        return 1;
+    }
+
+    // Forward the response line by line, holding back the status line.
+    int status = -1;
+    const std::string prefix(STATUS_PREFIX);
+    std::string line;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(connection, buffer, sizeof(buffer), 0)) > 0 ||
+           (received < 0 && errno == EINTR))
+    {
+        for (ssize_t i = 0; i < received; i++)
+        {
+            line.push_back(buffer[i]);
+            if (buffer[i] != '\n')
+                continue;
+            // The status may follow output that did not end with a newline.
+            size_t position = line.find(prefix);
+            if (position != std::string::npos)
+            {
+                std::cout << line.substr(0, position);
+                status = atoi(line.c_str() + position + prefix.size());
+            }
+            else
+            {
+                std::cout << line;
+            }
+            line.clear();
+        }
+        std::cout.flush();
+    }
+    std::cout << line << std::flush;
+    close(connection);
+
+    if (status < 0)
+    {
+        Error("The daemon closed the connection before the run finished.");
+        return 1;
+    }
+    return status;
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// The control socket of the daemon mode, where the producer and consumer are
+// initialized once and kept open while runs are requested over a Unix domain
+// socket. Each connection sends a single request line with the arguments of
+// the run (as they would be given on the command line, separated by
+// whitespace), and receives the output of the run followed by a status line
+// with its exit code.
+namespace Daemon
+{
+
+// The prefix of the final line of each response, which is followed by the
+// exit code of the run.
+constexpr const char* STATUS_PREFIX = "loopback-latency-status: ";
+
+class Server
+{
+public:
+
+    Server();
+    ~Server();
+
+    // Creates the socket at the given path, replacing a stale socket left by
+    // an earlier daemon.
+    bool Listen(const std::string& path);
+
+    // Waits for the next connection and reads its request, returning the
+    // connection or -1 if the socket failed or a signal was received (e.g.
+    // SIGTERM, which stops the daemon).
+    int Accept(std::vector<std::string>* arguments);
+
+    // Sends the status line of the response and closes the connection.
+    void Finish(int connection, int status);
+
+private:
+
+    std::string m_path;
+    int m_socket;
+};
+
+// Redirects std::cout, std::cerr and the AsyncLog output to a connection for
+// its lifetime, so that the output of a run is streamed back to the client.
+// Output is dropped if the client disconnects.
+class OutputRedirect : private std::streambuf
+{
+public:
+
+    OutputRedirect(int connection);
+    ~OutputRedirect();
+
+private:
+
+    virtual int overflow(int c) override;
+    virtual std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+    int m_connection;
+    std::streambuf* m_cout;
+    std::streambuf* m_cerr;
+    std::streambuf* m_log;
+};
+
+// Sends the given arguments to the daemon listening at the given path and
+// writes its response to std::cout, returning the exit code of the run.
+int RunClient(const std::string& path, const std::vector<std::string>& arguments);
+
+}
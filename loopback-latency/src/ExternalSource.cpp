@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ExternalSource.h"
+
+ExternalSource::ExternalSource(const TestFormat& format, bool decodeIds)
+    : Producer(format, 0)
+    , m_decodeIds(decodeIds)
+    , m_started(false)
+    , m_driverSequence(false)
+    , m_firstSequence(0)
+    , m_nextSequence(0)
+{
+}
+
+bool ExternalSource::Initialize()
+{
+    m_startupPhases.Resume();
+    return true;
+}
+
+void ExternalSource::Close()
+{
+}
+
+bool ExternalSource::StartStreaming()
+{
+    // The source streams on its own, so there is no thread to start.
+    return true;
+}
+
+void ExternalSource::StopStreaming()
+{
+}
+
+void ExternalSource::StreamThread()
+{
+}
+
+void ExternalSource::ResetCaptures()
+{
+    std::lock_guard<std::mutex> lock(m_capturesMutex);
+    m_started = false;
+    m_captures.clear();
+}
+
+std::vector<ExternalSource::Capture> ExternalSource::Captures() const
+{
+    std::lock_guard<std::mutex> lock(m_capturesMutex);
+    return m_captures;
+}
+
+bool ExternalSource::DriverSequence() const
+{
+    std::lock_guard<std::mutex> lock(m_capturesMutex);
+    return m_driverSequence;
+}
+
+std::shared_ptr<Frame> ExternalSource::IdentifyCapture(const void* ptr, const DriverCapture& driver)
+{
+    std::lock_guard<std::mutex> lock(m_capturesMutex);
+    uint64_t sequence = driver.hasSequence ? driver.sequence : m_nextSequence;
+    if (!m_started)
+    {
+        m_started = true;
+        m_driverSequence = driver.hasSequence;
+        m_firstSequence = sequence;
+    }
+    m_nextSequence = sequence + 1;
+
+    Capture capture;
+    capture.frame = sequence - m_firstSequence;
+    capture.driverTime = driver.time;
+    capture.decoded = m_decodeIds && DecodeNumber(ReadFrameId(ptr), m_format.pixelFormat, &capture.embeddedId);
+    if (!capture.decoded)
+        capture.embeddedId = 0;
+    m_captures.push_back(capture);
+
+    return std::make_shared<Frame>(capture.frame);
+}
+
+bool ExternalSource::DecodeNumber(const FrameId& id, PixelFormat format, uint32_t* number)
+{
+    // The inverse of the values that Frame derives from the frame number, each
+    // of which holds 4 bits of it.
+    const int step = IsYUVFormat(format) ? 13 : 16;
+    const int offset = IsYUVFormat(format) ? 22 : 8;
+    *number = 0;
+    for (size_t i = 0; i < 3; i++)
+    {
+        int value = std::max(0, id[i] - offset + step / 2) / step;
+        if (value > 15 || std::abs(id[i] - (value * step + offset)) > 1)
+            return false;
+        *number = (*number << 4) | value;
+    }
+    return true;
+}
+
+std::ostream& ExternalSource::Dump(std::ostream& o) const
+{
+    o << "External source (none)" << std::endl
+      << "    Decode frame IDs: " << m_decodeIds << std::endl;
+    return o;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "Producer.h"
+
+// A producer for frames that come from a source outside of the tool, such as
+// a signal generator or another machine, so that a consumer can be measured
+// on its own. Nothing is produced. Instead, each captured buffer becomes a new
+// frame that is numbered by the sequence number of the capture driver, so the
+// frames dropped by the capture path show up as skipped frames.
+//
+// If enabled, the frame ID that a loopback-latency producer embeds in each
+// frame (see Frame) is also decoded, which tells the frames that the source
+// skipped or repeated apart from those that the capture path dropped.
+class ExternalSource : public Producer
+{
+public:
+
+    // A captured frame, along with what the driver and the embedded frame ID
+    // reported about it.
+    struct Capture
+    {
+        uint32_t frame;
+        TimePoint driverTime;
+        bool decoded;
+        uint32_t embeddedId;
+    };
+
+    ExternalSource(const TestFormat& format, bool decodeIds);
+
+    virtual bool Initialize() override;
+    virtual void Close() override;
+    virtual bool StartStreaming() override;
+    virtual void StopStreaming() override;
+
+    virtual std::shared_ptr<Frame> IdentifyCapture(const void* ptr, const DriverCapture& driver) override;
+
+    bool DecodeIds() const { return m_decodeIds; }
+
+    // Clears the captures and numbers the next capture as frame 0. This must
+    // be called before each run, while the consumer is not capturing.
+    void ResetCaptures();
+
+    // The frames captured since ResetCaptures, in the order captured, and
+    // whether the driver gave them sequence numbers (if not, the frames are
+    // numbered in the order captured and drops cannot be detected).
+    std::vector<Capture> Captures() const;
+    bool DriverSequence() const;
+
+    // The number of distinct embedded frame IDs, after which they wrap.
+    static constexpr uint32_t EMBEDDED_ID_COUNT = 4096;
+
+protected:
+
+    virtual void StreamThread() override;
+    virtual std::ostream& Dump(std::ostream& o) const override;
+
+private:
+
+    // Decodes the frame number from the ID of a frame in the given format,
+    // allowing the same difference in each value as identifying a produced
+    // frame. Returns false if the ID was not written by a producer.
+    static bool DecodeNumber(const FrameId& id, PixelFormat format, uint32_t* number);
+
+    bool m_decodeIds;
+
+    bool m_started;
+    bool m_driverSequence;
+    uint64_t m_firstSequence;
+    uint64_t m_nextSequence;
+    std::vector<Capture> m_captures;
+    mutable std::mutex m_capturesMutex;
+};
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "FlightRecorder.h"
+#include "StageExport.h"
+#include "Console.h"
+
+namespace
+{
+
+Microseconds Latency(const Frame& f)
+{
+    return f.Elapsed(MARKER_PROCESSING_START, MARKER_COPIED_TO_GPU);
+}
+
+int64_t Elapsed(const TimePoint& a, const TimePoint& b)
+{
+    return std::chrono::duration_cast<Microseconds>(b - a).count();
+}
+
+// Writes the on-CPU time, off-CPU time and context switches between two
+// thread samples, or empty fields if the samples were not taken.
+void WriteThreadStats(std::ostream& o, const TimePoint& startTime, const ThreadSample& start,
+                      const TimePoint& endTime, const ThreadSample& end)
+{
+    if (!start.valid || !end.valid)
+    {
+        o << ",,,,";
+        return;
+    }
+
+    auto onCpu = std::chrono::duration_cast<Microseconds>(end.cpuTime - start.cpuTime).count();
+    o << "," << onCpu
+      << "," << std::max<int64_t>(0, Elapsed(startTime, endTime) - onCpu)
+      << "," << (end.voluntarySwitches - start.voluntarySwitches)
+      << "," << (end.involuntarySwitches - start.involuntarySwitches);
+}
+
+} // anonymous namespace
+
+FlightRecorder::FlightRecorder()
+    : m_threshold(0)
+    , m_count(0)
+    , m_collecting(false)
+    , m_windowStart(0)
+    , m_windowEnd(0)
+    , m_windowTrigger(0)
+    , m_windowLatency(0)
+    , m_windowTriggers(0)
+    , m_triggers(0)
+    , m_dumps(0)
+    , m_dumpSize(0)
+    , m_dumpTrigger(0)
+    , m_dumpLatency(0)
+    , m_dumpTriggers(0)
+    , m_dumpReady(false)
+    , m_stopping(false)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    Stop();
+}
+
+bool FlightRecorder::Start(const std::string& filename, size_t capacity, const Microseconds& threshold)
+{
+    m_file.open(filename);
+    if (!m_file.is_open())
+    {
+        Error("Could not open flight recorder file: " << filename);
+        return false;
+    }
+
+    m_filename = filename;
+    m_threshold = threshold;
+    m_ring.resize(std::max<size_t>(capacity, 4));
+    m_dump.resize(m_ring.size());
+    m_stopping = false;
+    m_writer = std::thread(&FlightRecorder::WriterThread, this);
+    return true;
+}
+
+void FlightRecorder::Stop()
+{
+    if (!m_writer.joinable())
+        return;
+
+    if (m_collecting)
+    {
+        // Wait for the writer to finish any previous window so that the final
+        // (partial) window is not dropped.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]{ return !m_dumpReady; });
+        }
+        m_windowEnd = std::min(m_windowEnd, m_count);
+        QueueDump();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    m_writer.join();
+    m_file.close();
+}
+
+void FlightRecorder::Add(const Frame& frame, size_t framesInFlight)
+{
+    Record& record = m_ring[m_count % m_ring.size()];
+    record.frame = frame;
+    record.framesInFlight = framesInFlight;
+    m_count++;
+
+    Microseconds latency = Latency(frame);
+    if (latency > m_threshold)
+    {
+        m_triggers++;
+        if (m_collecting)
+        {
+            if (m_count <= m_windowEnd)
+                m_windowTriggers++;
+        }
+        else
+        {
+            size_t postTrigger = m_ring.size() / 4;
+            size_t preTrigger = m_ring.size() - postTrigger - 1;
+            m_collecting = true;
+            m_windowStart = m_count - 1 - std::min<uint64_t>(m_count - 1, preTrigger);
+            m_windowEnd = m_count + postTrigger;
+            m_windowTrigger = frame.Number();
+            m_windowLatency = latency;
+            m_windowTriggers = 1;
+        }
+    }
+
+    if (m_collecting && m_count >= m_windowEnd)
+        QueueDump();
+}
+
+void FlightRecorder::QueueDump()
+{
+    {
+        // If the writer is still busy with the previous window then this is
+        // retried when the next record is added.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dumpReady)
+            return;
+
+        // The oldest records of the window will have been overwritten if the
+        // writer was busy for a while, so the window is clamped to the ring.
+        uint64_t start = std::max<uint64_t>(m_windowStart, m_count > m_ring.size() ? m_count - m_ring.size() : 0);
+        m_dumpSize = 0;
+        for (uint64_t i = start; i < m_windowEnd; i++)
+            m_dump[m_dumpSize++] = m_ring[i % m_ring.size()];
+        m_dumpTrigger = m_windowTrigger;
+        m_dumpLatency = m_windowLatency;
+        m_dumpTriggers = m_windowTriggers;
+        m_dumpReady = true;
+        m_dumps++;
+        m_collecting = false;
+    }
+    m_condition.notify_all();
+}
+
+void FlightRecorder::WriterThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]{ return m_dumpReady || m_stopping; });
+        if (m_dumpReady)
+        {
+            // The dump buffer is not touched by the capture thread until it is
+            // released, so the lock is not held while writing.
+            lock.unlock();
+            WriteDump();
+            lock.lock();
+            m_dumpReady = false;
+            m_condition.notify_all();
+        }
+        else if (m_stopping)
+        {
+            break;
+        }
+    }
+}
+
+void FlightRecorder::WriteDump()
+{
+    m_file << "# trigger=" << m_dumpTrigger
+           << ",latency=" << m_dumpLatency.count()
+           << ",threshold=" << m_threshold.count()
+           << ",triggers=" << m_dumpTriggers << std::endl;
+    m_file << "Frame,Count,Skipped,In Flight,Frame Start Timestamp,Latency";
+    StageExport::WriteStageLabels(m_file);
+    m_file << ",Producer On CPU,Producer Off CPU,Producer Voluntary Switches,Producer Involuntary Switches,"
+           << "Consumer On CPU,Consumer Off CPU,Consumer Voluntary Switches,Consumer Involuntary Switches"
+           << std::endl;
+
+    for (size_t i = 0; i < m_dumpSize; i++)
+    {
+        const Record& record = m_dump[i];
+        const Frame& f = record.frame;
+        uint32_t skipped = i > 0 ? f.Number() - m_dump[i - 1].frame.Number() - 1 : 0;
+        m_file << f.Number() << ","
+               << (f.DuplicateReceives() + 1) << ","
+               << skipped << ","
+               << record.framesInFlight << ","
+               << std::chrono::duration_cast<Microseconds>(f.Time(MARKER_PROCESSING_START).time_since_epoch()).count() << ","
+               << Latency(f).count();
+        StageExport::WriteStageTimes(m_file, f);
+        WriteThreadStats(m_file, f.Time(MARKER_PROCESSING_START), f.Thread(MARKER_PROCESSING_START),
+                         f.Time(MARKER_SCANOUT_START), f.Thread(MARKER_SCANOUT_START));
+        WriteThreadStats(m_file, f.Time(MARKER_FRAME_RECEIVED), f.Thread(MARKER_FRAME_RECEIVED),
+                         f.Time(MARKER_COPIED_TO_GPU), f.Thread(MARKER_COPIED_TO_GPU));
+        m_file << std::endl;
+    }
+    m_file << std::endl;
+    m_file.flush();
+}
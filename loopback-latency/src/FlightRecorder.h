@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Frame.h"
+
+// Keeps the detailed records of the most recently received frames in a
+// preallocated ring and, whenever a frame's latency exceeds a threshold,
+// dumps the window of records around that frame to a file. The records are
+// added by the consumer capture thread while the file is written by a
+// separate writer thread so that a dump does not stall the capture.
+class FlightRecorder
+{
+public:
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // Opens the dump file and allocates a ring of the given number of records.
+    // Each dump contains the records of up to three quarters of the ring before
+    // the triggering frame and a quarter of the ring after it.
+    bool Start(const std::string& filename, size_t capacity, const Microseconds& threshold);
+
+    // Writes any partially collected window and waits for the writer to finish.
+    void Stop();
+
+    // Records a received frame along with the number of frames that were in
+    // flight (produced but not yet received) when it was received.
+    void Add(const Frame& frame, size_t framesInFlight);
+
+    const std::string& Filename() const { return m_filename; }
+    const Microseconds& Threshold() const { return m_threshold; }
+
+    // The number of frames that exceeded the threshold.
+    size_t Triggers() const { return m_triggers; }
+
+    // The number of windows written.
+    size_t Dumps() const { return m_dumps; }
+
+private:
+
+    struct Record
+    {
+        Record()
+            : frame(0)
+            , framesInFlight(0)
+        {}
+
+        Frame frame;
+        size_t framesInFlight;
+    };
+
+    void QueueDump();
+    void WriterThread();
+    void WriteDump();
+
+    std::string m_filename;
+    std::ofstream m_file;
+    Microseconds m_threshold;
+
+    // The ring of records and the total number of records added to it.
+    std::vector<Record> m_ring;
+    uint64_t m_count;
+
+    // The window that is currently being collected, if any.
+    bool m_collecting;
+    uint64_t m_windowStart;
+    uint64_t m_windowEnd;
+    uint32_t m_windowTrigger;
+    Microseconds m_windowLatency;
+    size_t m_windowTriggers;
+
+    size_t m_triggers;
+    size_t m_dumps;
+
+    // The window handed off to the writer thread.
+    std::vector<Record> m_dump;
+    size_t m_dumpSize;
+    uint32_t m_dumpTrigger;
+    Microseconds m_dumpLatency;
+    size_t m_dumpTriggers;
+    bool m_dumpReady;
+
+    bool m_stopping;
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
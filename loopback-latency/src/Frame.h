@@ -23,6 +23,34 @@
 #pragma once
 
 #include "DurationList.h"
+#include "FramePattern.h"
+#include "Instrumentation.h"
+#include "StageRegistry.h"
+#include "TestFormat.h"
+#include "ThreadStats.h"
+
+// A point in time along with a sample of the thread that recorded it.
+struct Timestamp
+{
+    static Timestamp Now()
+    {
+        Timestamp t;
+        if constexpr (INSTRUMENTATION >= INSTRUMENTATION_COUNTERS)
+            t.thread = ThreadSample::Now();
+        t.time = Clock::now();
+        return t;
+    }
+
+    // Returns the current time to be recorded for the given marker, or an
+    // empty timestamp if the marker is not recorded at the compiled level.
+    static Timestamp Now(MarkerId marker)
+    {
+        return MarkerEnabled(marker) ? Now() : Timestamp();
+    }
+
+    TimePoint time;
+    ThreadSample thread;
+};
 
 class Frame
 {
@@ -31,6 +59,8 @@ public:
     Frame(uint32_t number)
         : m_number(number)
         , m_duplicateReceives(0)
+        , m_mismatchedLines(0)
+        , m_framesInFlight(0)
     {
         // This creates a color value that increments (and wraps) one or more of
         // the RGB values by 16 between successive frames. The +8 offset is added
@@ -38,6 +68,13 @@ public:
         m_r = ((number & 0xF00) >> 8) * 16 + 8;
         m_g = ((number & 0xF0) >> 4) * 16 + 8;
         m_b = (number & 0xF) * 16 + 8;
+
+        // YUV formats carry the same number directly in the Y, U and V values
+        // (no color conversion), using steps of 13 from 22 so that the values
+        // stay within the limited range (16-235) that video links may clamp to.
+        m_y = ((number & 0xF00) >> 8) * 13 + 22;
+        m_u = ((number & 0xF0) >> 4) * 13 + 22;
+        m_v = (number & 0xF) * 13 + 22;
     }
 
     uint32_t Number() const { return m_number; }
@@ -46,39 +83,83 @@ public:
     uint8_t G() const { return m_g; }
     uint8_t B() const { return m_b; }
 
-    void RecordProcessingStart() { m_processingStart = Clock::now(); }
-    void RecordRenderStart() { m_renderStart = Clock::now(); }
-    void RecordRenderEnd() { m_renderEnd = Clock::now(); }
-    void RecordCopiedFromGPU() { m_copiedFromGPU = Clock::now(); }
-    void RecordWriteEnd() { m_writeEnd = Clock::now(); }
-    void RecordScanoutStart() { m_scanoutStart = Clock::now(); }
-    void RecordFrameReceived() { m_frameReceived = Clock::now(); }
-    void RecordReadEnd() { m_readEnd = Clock::now(); }
-    void RecordCopiedToGPU() { m_copiedToGPU = Clock::now(); }
-
-    void RecordProcessingStart(TimePoint time) { m_processingStart = time; }
-    void RecordRenderStart(TimePoint time) { m_renderStart = time; }
-    void RecordRenderEnd(TimePoint time) { m_renderEnd = time; }
-    void RecordCopiedFromGPU(TimePoint time) { m_copiedFromGPU = time; }
-    void RecordWriteEnd(TimePoint time) { m_writeEnd = time; }
-    void RecordScanoutStart(TimePoint time) { m_scanoutStart = time; }
-    void RecordFrameReceived(TimePoint time) { m_frameReceived = time; }
-    void RecordReadEnd(TimePoint time) { m_readEnd = time; }
-    void RecordCopiedToGPU(TimePoint time) { m_copiedToGPU = time; }
-
-    const TimePoint& ProcessingStart() const { return m_processingStart; }
-    const TimePoint& RenderStart() const { return m_renderStart; }
-    const TimePoint& RenderEnd() const { return m_renderEnd; }
-    const TimePoint& CopiedFromGPU() const { return m_copiedFromGPU; }
-    const TimePoint& WriteEnd() const { return m_writeEnd; }
-    const TimePoint& ScanoutStart() const { return m_scanoutStart; }
-    const TimePoint& FrameReceived() const { return m_frameReceived; }
-    const TimePoint& ReadEnd() const { return m_readEnd; }
-    const TimePoint& CopiedToGPU() const { return m_copiedToGPU; }
+    uint8_t Y() const { return m_y; }
+    uint8_t U() const { return m_u; }
+    uint8_t V() const { return m_v; }
+
+    // The values that identify this frame in a buffer of the given format.
+    FrameId Id(PixelFormat format) const
+    {
+        if (IsYUVFormat(format))
+            return { m_y, m_u, m_v };
+        return { m_r, m_g, m_b };
+    }
+
+    // Records a marker (see StageRegistry) at the current time or at the given
+    // time. Markers that are not enabled at the compiled instrumentation level
+    // are not recorded, and the check is folded away for constant markers.
+    void Record(MarkerId marker)
+    {
+        if (MarkerEnabled(marker))
+            Record(marker, Timestamp::Now());
+    }
+    void Record(MarkerId marker, const Timestamp& t)
+    {
+        if (MarkerEnabled(marker))
+        {
+            m_times[marker] = t.time;
+            m_threads[marker] = t.thread;
+        }
+    }
+
+    bool Recorded(MarkerId marker) const { return marker < MAX_MARKERS && m_times[marker] != TimePoint(); }
+    const TimePoint& Time(MarkerId marker) const { return m_times[marker]; }
+
+    // The thread sample taken with the marker (only valid if thread sampling
+    // is enabled; see ThreadSample::Enable).
+    const ThreadSample& Thread(MarkerId marker) const { return m_threads[marker]; }
+
+    Microseconds Elapsed(MarkerId start, MarkerId end) const
+    {
+        return std::chrono::duration_cast<Microseconds>(m_times[end] - m_times[start]);
+    }
+
+    // Gets the markers that start and end the stage at the given position in
+    // the pipeline order (see StageRegistry::Markers). The stage starts at the
+    // closest earlier marker that was recorded so that a marker that is not
+    // recorded by every backend does not leave a gap. Returns false if the
+    // marker ending the stage was not recorded.
+    bool StageMarkers(size_t position, MarkerId* start, MarkerId* end) const
+    {
+        if constexpr (INSTRUMENTATION == INSTRUMENTATION_OFF)
+            return false;
+
+        const auto& markers = StageRegistry::Markers();
+        *end = markers[position].id;
+        if (position == 0 || !Recorded(*end))
+            return false;
+        for (size_t i = position; i-- > 0;)
+        {
+            *start = markers[i].id;
+            if (Recorded(*start))
+                return true;
+        }
+        return false;
+    }
 
     void RecordDuplicateReceive() { m_duplicateReceives++; }
     size_t DuplicateReceives() const { return m_duplicateReceives; }
 
+    // The number of lines that did not match the expected frame contents when
+    // the frame was verified (see Consumer::SetVerifyFrames).
+    void RecordMismatchedLines(size_t lines) { m_mismatchedLines = lines; }
+    size_t MismatchedLines() const { return m_mismatchedLines; }
+
+    // The number of frames that had been produced but not yet received when
+    // this frame was received (see Producer::FramesInFlight).
+    void RecordFramesInFlight(size_t frames) { m_framesInFlight = frames; }
+    size_t FramesInFlight() const { return m_framesInFlight; }
+
 private:
 
     uint32_t m_number;
@@ -87,15 +168,14 @@ private:
     uint8_t m_g;
     uint8_t m_b;
 
-    TimePoint m_processingStart;
-    TimePoint m_renderStart;
-    TimePoint m_renderEnd;
-    TimePoint m_copiedFromGPU;
-    TimePoint m_writeEnd;
-    TimePoint m_scanoutStart;
-    TimePoint m_frameReceived;
-    TimePoint m_readEnd;
-    TimePoint m_copiedToGPU;
+    uint8_t m_y;
+    uint8_t m_u;
+    uint8_t m_v;
+
+    TimePoint m_times[MAX_MARKERS];
+    ThreadSample m_threads[MAX_MARKERS];
 
     size_t m_duplicateReceives;
+    size_t m_mismatchedLines;
+    size_t m_framesInFlight;
 };
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include "FrameContent.h"
+#include "Console.h"
+
+namespace
+{
+
+// The maximum number of threads that write the content of host buffers.
+constexpr size_t MAX_HOST_WORKERS = 8;
+
+// Writes the lines of a band of a host buffer. Each specialization has a
+// branch-free inner loop so that the compiler can vectorize it.
+template <PixelFormat F, ContentType C>
+struct HostContentWriter
+{
+    static void Write(uint8_t* frame, const TestFormat& format, const ContentParams& content,
+                      uint32_t frameNumber, size_t firstLine, size_t endLine)
+    {
+        constexpr size_t GROUP_PIXELS = PixelFormatLayout<F>::GROUP_PIXELS;
+        for (size_t y = std::max(firstLine, CONTENT_ID_LINES); y < endLine; y++)
+        {
+            for (size_t x = 0; x < format.width; x += GROUP_PIXELS)
+            {
+                WriteContentGroup<F, C>(frame, format.stride, format.chromaOffset, content, x, y, frameNumber);
+            }
+        }
+    }
+};
+
+// Reads the next token of a PPM header, skipping whitespace and comments.
+std::string ReadPPMToken(std::istream& file)
+{
+    std::string token;
+    while (file >> std::ws && file.peek() == '#')
+        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    file >> token;
+    return token;
+}
+
+}
+
+FrameContent::FrameContent()
+    : m_type(CONTENT_SOLID)
+    , m_seed(0)
+    , m_format(FORMAT_UNKNOWN)
+    , m_hostParams({})
+    , m_deviceParams({})
+    , m_cudaTile(nullptr)
+    , m_deviceWriter(nullptr)
+    , m_hostWriter(nullptr)
+    , m_workerCount(0)
+    , m_workBuffer(nullptr)
+    , m_workFrame(0)
+    , m_workGeneration(0)
+    , m_workPending(0)
+    , m_stopping(false)
+{
+}
+
+FrameContent::~FrameContent()
+{
+    Close();
+}
+
+void FrameContent::Configure(ContentType type, uint32_t seed, const std::string& tileFilename)
+{
+    m_type = type;
+    m_seed = seed;
+    m_tileFilename = tileFilename;
+}
+
+bool FrameContent::Initialize(const TestFormat& format, bool host)
+{
+    Close();
+
+    m_format = format;
+    if (m_type == CONTENT_SOLID)
+        return true;
+
+    if (format.height <= CONTENT_ID_LINES)
+    {
+        Error("The frames are too small to hold any content.");
+        return false;
+    }
+
+    m_hostParams = MakeContentParams(format.width, format.height, m_seed);
+    m_deviceParams = m_hostParams;
+    if (m_type == CONTENT_TILE)
+    {
+        if (!LoadTile())
+            return false;
+        m_cudaTile = CudaAlloc(m_tile.size());
+        if (!m_cudaTile)
+        {
+            Error("Failed to allocate CUDA memory for the content tile.");
+            return false;
+        }
+        CudaMemcpyHtoD(m_cudaTile, m_tile.data(), m_tile.size());
+        m_hostParams.tile = m_tile.data();
+        m_deviceParams.tile = (const uint8_t*)m_cudaTile;
+        m_deviceParams.tileWidth = m_hostParams.tileWidth;
+        m_deviceParams.tileHeight = m_hostParams.tileHeight;
+    }
+
+    m_deviceWriter = CudaSelectContentWriter(format.pixelFormat, m_type);
+    if (host)
+    {
+        m_hostWriter = SelectContentWriter<HostContentWriter>(format.pixelFormat, m_type);
+
+        m_stopping = false;
+        m_workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, MAX_HOST_WORKERS);
+        for (size_t i = 0; i < m_workerCount; i++)
+            m_workers.emplace_back(&FrameContent::WorkerThread, this, i);
+    }
+
+    return true;
+}
+
+void FrameContent::Close()
+{
+    if (m_workers.size())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_workMutex);
+            m_stopping = true;
+        }
+        m_workReady.notify_all();
+        for (auto& worker : m_workers)
+            worker.join();
+        m_workers.clear();
+    }
+    m_workerCount = 0;
+    m_deviceWriter = nullptr;
+    m_hostWriter = nullptr;
+
+    if (m_cudaTile)
+        CudaFree(m_cudaTile);
+    m_cudaTile = nullptr;
+}
+
+FramePattern FrameContent::IdPattern(const FramePattern& pattern) const
+{
+    if (m_type == CONTENT_SOLID)
+        return pattern;
+
+    // Each plane keeps the same fraction of its lines, so the chroma plane of
+    // 4:2:0 formats keeps half as many lines as the luma plane.
+    FramePattern id(pattern);
+    for (size_t i = 0; i < id.planeCount; i++)
+    {
+        size_t planeLines = id.planes[i].bytes / m_format.stride;
+        id.planes[i].bytes = m_format.stride * (CONTENT_ID_LINES * planeLines / m_format.height);
+    }
+    return id;
+}
+
+void FrameContent::WriteDevice(void* cudaBuffer, uint32_t frameNumber) const
+{
+    if (m_deviceWriter)
+        m_deviceWriter(cudaBuffer, m_format, m_deviceParams, frameNumber);
+}
+
+void FrameContent::WriteHost(void* buffer, uint32_t frameNumber)
+{
+    if (!m_hostWriter)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_workMutex);
+    m_workBuffer = (uint8_t*)buffer;
+    m_workFrame = frameNumber;
+    m_workPending = m_workerCount;
+    m_workGeneration++;
+    m_workReady.notify_all();
+    m_workDone.wait(lock, [this] { return m_workPending == 0; });
+}
+
+void FrameContent::WorkerThread(size_t index)
+{
+    // Each worker writes an equal band of lines.
+    size_t firstLine = m_format.height * index / m_workerCount;
+    size_t endLine = m_format.height * (index + 1) / m_workerCount;
+
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(m_workMutex);
+    while (true)
+    {
+        m_workReady.wait(lock, [&] { return m_stopping || m_workGeneration != generation; });
+        if (m_stopping)
+            return;
+        generation = m_workGeneration;
+
+        lock.unlock();
+        m_hostWriter(m_workBuffer, m_format, m_hostParams, m_workFrame, firstLine, endLine);
+        lock.lock();
+
+        if (--m_workPending == 0)
+            m_workDone.notify_one();
+    }
+}
+
+bool FrameContent::LoadTile()
+{
+    std::ifstream file(m_tileFilename, std::ios::binary);
+    if (m_tileFilename.empty() || !file.is_open())
+    {
+        Error("Could not open the content tile: " << m_tileFilename);
+        return false;
+    }
+
+    // Only binary 8-bit RGB PPM images (P6) are supported.
+    std::string magic = ReadPPMToken(file);
+    unsigned long width = std::stoul("0" + ReadPPMToken(file));
+    unsigned long height = std::stoul("0" + ReadPPMToken(file));
+    unsigned long maxValue = std::stoul("0" + ReadPPMToken(file));
+    file.get();
+    if (magic != "P6" || !width || !height || maxValue != 255)
+    {
+        Error("The content tile must be a binary PPM (P6) image with 8-bit values: " << m_tileFilename);
+        return false;
+    }
+
+    m_tile.resize(width * height * 3);
+    if (!file.read((char*)m_tile.data(), m_tile.size()))
+    {
+        Error("The content tile is truncated: " << m_tileFilename);
+        return false;
+    }
+
+    m_hostParams.tileWidth = width;
+    m_hostParams.tileHeight = height;
+    return true;
+}
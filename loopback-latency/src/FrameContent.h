@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ContentPattern.h"
+#include "CudaUtils.h"
+
+// Writes the content (see ContentType) of each frame into a GPU buffer or a
+// host buffer. The writer for the pixel format and content type is selected
+// once when the content is initialized. Host buffers are written by a set of
+// worker threads that each write a band of lines.
+class FrameContent
+{
+public:
+
+    FrameContent();
+    ~FrameContent();
+
+    // Sets the content type, the noise seed and the tile image (a binary PPM
+    // file, which is only used by CONTENT_TILE). This must be set before the
+    // content is initialized.
+    void Configure(ContentType type, uint32_t seed, const std::string& tileFilename);
+
+    // Loads the tile image and selects the writers for the given format. The
+    // host worker threads are only started if host is true.
+    bool Initialize(const TestFormat& format, bool host);
+    void Close();
+
+    ContentType Type() const { return m_type; }
+
+    // Returns the part of the given frame pattern that is kept with this
+    // content, which is the ID lines unless the content is solid.
+    FramePattern IdPattern(const FramePattern& pattern) const;
+
+    // Writes the content of the given frame (other than the ID lines).
+    void WriteDevice(void* cudaBuffer, uint32_t frameNumber) const;
+    void WriteHost(void* buffer, uint32_t frameNumber);
+
+    using HostWriter = void (*)(uint8_t* frame, const TestFormat& format, const ContentParams& content,
+                                uint32_t frameNumber, size_t firstLine, size_t endLine);
+
+private:
+
+    bool LoadTile();
+    void WorkerThread(size_t index);
+
+    ContentType m_type;
+    uint32_t m_seed;
+    std::string m_tileFilename;
+
+    TestFormat m_format;
+    ContentParams m_hostParams;
+    ContentParams m_deviceParams;
+    std::vector<uint8_t> m_tile;
+    void* m_cudaTile;
+
+    CudaContentWriter m_deviceWriter;
+    HostWriter m_hostWriter;
+
+    // The host worker threads and the frame that they are writing.
+    size_t m_workerCount;
+    std::vector<std::thread> m_workers;
+    std::mutex m_workMutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_workDone;
+    uint8_t* m_workBuffer;
+    uint32_t m_workFrame;
+    uint64_t m_workGeneration;
+    size_t m_workPending;
+    bool m_stopping;
+};
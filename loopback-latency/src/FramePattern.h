@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "TestFormat.h"
+
+// The functions that are shared by the host and device code.
+#ifdef __CUDACC__
+#define PIXEL_FUNCTION __host__ __device__ inline
+#else
+#define PIXEL_FUNCTION inline
+#endif
+
+// The three 8-bit values that identify a frame within a captured buffer:
+// the R, G and B values of RGB formats or the Y, U and V values of YUV formats.
+struct FrameId
+{
+    PIXEL_FUNCTION uint8_t& operator[](size_t i) { return values[i]; }
+    PIXEL_FUNCTION const uint8_t& operator[](size_t i) const { return values[i]; }
+
+    uint8_t values[3];
+};
+
+// How the samples of a layout are stored, which determines how captured
+// values are compared with the expected values when frames are verified.
+enum PixelSamples
+{
+    SAMPLES_8,         // 8-bit samples in bytes
+    SAMPLES_10_PACKED, // 10-bit samples in bits 0-9, 10-19 and 20-29 of 32-bit words
+    SAMPLES_10_MSB,    // 10-bit samples in the upper bits of 16-bit words
+};
+
+PIXEL_FUNCTION uint32_t SampleDiff(uint32_t a, uint32_t b, int shift, uint32_t mask)
+{
+    uint32_t x = (a >> shift) & mask;
+    uint32_t y = (b >> shift) & mask;
+    return x > y ? x - y : y - x;
+}
+
+// The contents of a solid color frame, in which every plane repeats a 16 byte
+// block from its start. Every supported layout repeats within 16 bytes, and
+// the strides are multiples of the repeat so that every line starts the same.
+struct FramePattern
+{
+    static constexpr size_t BLOCK_SIZE = 16;
+    static constexpr size_t MAX_PLANES = 2;
+
+    // Whether a captured 32-bit word matches the expected word, allowing each
+    // sample to differ by one 8-bit step (the same tolerance that is used to
+    // identify frames) and ignoring the alpha or padding bits.
+    PIXEL_FUNCTION bool WordMatches(uint32_t actual, uint32_t expected) const
+    {
+        actual |= ignoredBits;
+        expected |= ignoredBits;
+        switch (samples)
+        {
+            case SAMPLES_10_PACKED:
+                return SampleDiff(actual, expected, 0, 0x3FF) <= 4 &&
+                       SampleDiff(actual, expected, 10, 0x3FF) <= 4 &&
+                       SampleDiff(actual, expected, 20, 0x3FF) <= 4;
+            case SAMPLES_10_MSB:
+                return SampleDiff(actual, expected, 6, 0x3FF) <= 4 &&
+                       SampleDiff(actual, expected, 22, 0x3FF) <= 4;
+            default:
+                return SampleDiff(actual, expected, 0, 0xFF) <= 1 &&
+                       SampleDiff(actual, expected, 8, 0xFF) <= 1 &&
+                       SampleDiff(actual, expected, 16, 0xFF) <= 1 &&
+                       SampleDiff(actual, expected, 24, 0xFF) <= 1;
+        }
+    }
+
+    struct Plane
+    {
+        size_t offset;
+        size_t bytes;
+        alignas(16) uint8_t block[BLOCK_SIZE];
+    };
+
+    Plane planes[MAX_PLANES];
+    size_t planeCount;
+
+    PixelSamples samples;
+    uint32_t ignoredBits; // The alpha or padding bits of each 32-bit word, which are not verified.
+};
+
+namespace PixelLayout
+{
+
+// Fills a block by repeating the given bytes.
+inline void Repeat(uint8_t* block, const uint8_t* unit, size_t unitSize)
+{
+    for (size_t i = 0; i < FramePattern::BLOCK_SIZE; i++)
+        block[i] = unit[i % unitSize];
+}
+
+inline void Repeat32(uint8_t* block, uint32_t word)
+{
+    const uint8_t unit[4] = { uint8_t(word), uint8_t(word >> 8), uint8_t(word >> 16), uint8_t(word >> 24) };
+    Repeat(block, unit, sizeof(unit));
+}
+
+PIXEL_FUNCTION uint32_t Read32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+PIXEL_FUNCTION uint16_t Read16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+PIXEL_FUNCTION uint8_t Decode10(uint32_t word, int shift)
+{
+    return DecodeSample10((word >> shift) & 0x3FF);
+}
+
+PIXEL_FUNCTION void Write32(uint8_t* p, uint32_t word)
+{
+    *(uint32_t*)p = word;
+}
+
+PIXEL_FUNCTION uint32_t Encode10(uint8_t value, int shift)
+{
+    return uint32_t(EncodeSample10(value)) << shift;
+}
+
+// 8-bit RGB in 32-bit pixels, with the byte index of each component.
+template <int R, int G, int B, int A>
+struct PackedRGB8
+{
+    static constexpr size_t PLANES = 1;
+    static constexpr PixelSamples SAMPLES = SAMPLES_8;
+    static constexpr uint32_t IGNORED_BITS = 0xFFu << (A * 8);
+    static constexpr bool YUV = false;
+    static constexpr size_t GROUP_PIXELS = 1;
+
+    static void Encode(const FrameId& id, FramePattern* pattern)
+    {
+        uint8_t unit[4];
+        unit[R] = id[0];
+        unit[G] = id[1];
+        unit[B] = id[2];
+        unit[A] = 0xFF;
+        Repeat(pattern->planes[0].block, unit, sizeof(unit));
+    }
+
+    PIXEL_FUNCTION static FrameId Decode(const uint8_t* frame, size_t)
+    {
+        return { frame[R], frame[G], frame[B] };
+    }
+
+    PIXEL_FUNCTION static void Store(uint8_t* frame, size_t stride, size_t, size_t x, size_t y, const FrameId* pixels)
+    {
+        Write32(frame + y * stride + x * 4, (0xFFu << (A * 8)) |
+                                            (uint32_t(pixels[0][0]) << (R * 8)) |
+                                            (uint32_t(pixels[0][1]) << (G * 8)) |
+                                            (uint32_t(pixels[0][2]) << (B * 8)));
+    }
+};
+
+// 10-bit RGB in 32-bit words, with the lowest bit of each component.
+template <int R, int G, int B>
+struct PackedRGB10
+{
+    static constexpr size_t PLANES = 1;
+    static constexpr PixelSamples SAMPLES = SAMPLES_10_PACKED;
+    static constexpr uint32_t IGNORED_BITS = 0x3u << 30;
+    static constexpr bool YUV = false;
+    static constexpr size_t GROUP_PIXELS = 1;
+
+    static void Encode(const FrameId& id, FramePattern* pattern)
+    {
+        Repeat32(pattern->planes[0].block, Pack(id));
+    }
+
+    PIXEL_FUNCTION static void Store(uint8_t* frame, size_t stride, size_t, size_t x, size_t y, const FrameId* pixels)
+    {
+        Write32(frame + y * stride + x * 4, Pack(pixels[0]));
+    }
+
+    PIXEL_FUNCTION static uint32_t Pack(const FrameId& pixel)
+    {
+        return (0x3u << 30) | Encode10(pixel[0], R) | Encode10(pixel[1], G) | Encode10(pixel[2], B);
+    }
+
+    PIXEL_FUNCTION static FrameId Decode(const uint8_t* frame, size_t)
+    {
+        uint32_t word = Read32(frame);
+        return { Decode10(word, R), Decode10(word, G), Decode10(word, B) };
+    }
+};
+
+// 8-bit 4:2:2 in 4 byte macropixels, with the byte index of each value.
+template <int Y0, int U, int Y1, int V>
+struct Packed422
+{
+    static constexpr size_t PLANES = 1;
+    static constexpr PixelSamples SAMPLES = SAMPLES_8;
+    static constexpr uint32_t IGNORED_BITS = 0;
+    static constexpr bool YUV = true;
+    static constexpr size_t GROUP_PIXELS = 2;
+
+    static void Encode(const FrameId& id, FramePattern* pattern)
+    {
+        uint8_t unit[4];
+        unit[Y0] = id[0];
+        unit[U] = id[1];
+        unit[Y1] = id[0];
+        unit[V] = id[2];
+        Repeat(pattern->planes[0].block, unit, sizeof(unit));
+    }
+
+    PIXEL_FUNCTION static FrameId Decode(const uint8_t* frame, size_t)
+    {
+        return { frame[Y0], frame[U], frame[V] };
+    }
+
+    // The chroma of each pair of pixels is taken from the first pixel.
+    PIXEL_FUNCTION static void Store(uint8_t* frame, size_t stride, size_t, size_t x, size_t y, const FrameId* pixels)
+    {
+        Write32(frame + y * stride + x * 2, (uint32_t(pixels[0][0]) << (Y0 * 8)) |
+                                            (uint32_t(pixels[0][1]) << (U * 8)) |
+                                            (uint32_t(pixels[1][0]) << (Y1 * 8)) |
+                                            (uint32_t(pixels[0][2]) << (V * 8)));
+    }
+};
+
+// 10-bit 4:2:2 in 16 byte blocks of 6 pixels, which hold the 10-bit values
+// from the lowest bits as Cb0 Y0 Cr0 | Y1 Cb1 Y2 | Cr1 Y3 Cb2 | Y4 Cr2 Y5.
+struct PackedV210
+{
+    static constexpr size_t PLANES = 1;
+    static constexpr PixelSamples SAMPLES = SAMPLES_10_PACKED;
+    static constexpr uint32_t IGNORED_BITS = 0x3u << 30;
+    static constexpr bool YUV = true;
+    static constexpr size_t GROUP_PIXELS = 6;
+
+    static void Encode(const FrameId& id, FramePattern* pattern)
+    {
+        const FrameId pixels[GROUP_PIXELS] = { id, id, id, id, id, id };
+        Store(pattern->planes[0].block, 0, 0, 0, 0, pixels);
+    }
+
+    // The chroma of each pair of pixels is taken from the first pixel.
+    PIXEL_FUNCTION static void Store(uint8_t* frame, size_t stride, size_t, size_t x, size_t y, const FrameId* pixels)
+    {
+        uint8_t* p = frame + y * stride + x / GROUP_PIXELS * 16;
+        Write32(p,      Encode10(pixels[0][1], 0) | Encode10(pixels[0][0], 10) | Encode10(pixels[0][2], 20));
+        Write32(p + 4,  Encode10(pixels[1][0], 0) | Encode10(pixels[2][1], 10) | Encode10(pixels[2][0], 20));
+        Write32(p + 8,  Encode10(pixels[2][2], 0) | Encode10(pixels[3][0], 10) | Encode10(pixels[4][1], 20));
+        Write32(p + 12, Encode10(pixels[4][0], 0) | Encode10(pixels[4][2], 10) | Encode10(pixels[5][0], 20));
+    }
+
+    PIXEL_FUNCTION static FrameId Decode(const uint8_t* frame, size_t)
+    {
+        uint32_t word = Read32(frame);
+        return { Decode10(word, 10), Decode10(word, 0), Decode10(word, 20) };
+    }
+};
+
+// 4:2:0 with a luma plane followed by an interleaved UV plane, using 8-bit
+// samples or 16-bit samples that hold a 10-bit value in their upper bits.
+template <int BITS>
+struct SemiPlanar420
+{
+    static_assert(BITS == 8 || BITS == 10, "Unsupported bit depth");
+
+    static constexpr size_t PLANES = 2;
+    static constexpr size_t SAMPLE_SIZE = BITS == 8 ? 1 : 2;
+    static constexpr PixelSamples SAMPLES = BITS == 8 ? SAMPLES_8 : SAMPLES_10_MSB;
+    static constexpr uint32_t IGNORED_BITS = 0;
+    static constexpr bool YUV = true;
+    static constexpr size_t GROUP_PIXELS = 2;
+
+    static void Encode(const FrameId& id, FramePattern* pattern)
+    {
+        uint8_t luma[2], chroma[4];
+        EncodeSample(id[0], luma);
+        EncodeSample(id[1], chroma);
+        EncodeSample(id[2], chroma + SAMPLE_SIZE);
+        Repeat(pattern->planes[0].block, luma, SAMPLE_SIZE);
+        Repeat(pattern->planes[1].block, chroma, SAMPLE_SIZE * 2);
+    }
+
+    PIXEL_FUNCTION static FrameId Decode(const uint8_t* frame, size_t chromaOffset)
+    {
+        return { DecodeSample(frame),
+                 DecodeSample(frame + chromaOffset),
+                 DecodeSample(frame + chromaOffset + SAMPLE_SIZE) };
+    }
+
+    static void EncodeSample(uint8_t value, uint8_t* sample)
+    {
+        if (BITS == 8)
+        {
+            sample[0] = value;
+        }
+        else
+        {
+            uint16_t s = EncodeSample10(value) << 6;
+            sample[0] = s & 0xFF;
+            sample[1] = s >> 8;
+        }
+    }
+
+    PIXEL_FUNCTION static uint8_t DecodeSample(const uint8_t* sample)
+    {
+        return BITS == 8 ? sample[0] : DecodeSample10(Read16(sample) >> 6);
+    }
+
+    // Writes two luma samples, and for even lines the chroma of the 2x2 block
+    // below them, which is taken from the first pixel.
+    PIXEL_FUNCTION static void Store(uint8_t* frame, size_t stride, size_t chromaOffset,
+                                     size_t x, size_t y, const FrameId* pixels)
+    {
+        StorePair(frame + y * stride + x * SAMPLE_SIZE, pixels[0][0], pixels[1][0]);
+        if (y % 2 == 0)
+            StorePair(frame + chromaOffset + y / 2 * stride + x * SAMPLE_SIZE, pixels[0][1], pixels[0][2]);
+    }
+
+    PIXEL_FUNCTION static void StorePair(uint8_t* p, uint8_t a, uint8_t b)
+    {
+        if (BITS == 8)
+        {
+            p[0] = a;
+            p[1] = b;
+        }
+        else
+        {
+            Write32(p, Encode10(a, 6) | Encode10(b, 22));
+        }
+    }
+};
+
+} // namespace PixelLayout
+
+// Writes a pattern to a host buffer (see CudaWritePattern for GPU buffers).
+// The blocks are copied whole so that the copies are vectorized.
+inline void WritePattern(void* ptr, const FramePattern& pattern)
+{
+    for (size_t i = 0; i < pattern.planeCount; i++)
+    {
+        const FramePattern::Plane& plane = pattern.planes[i];
+        uint8_t* dst = (uint8_t*)ptr + plane.offset;
+        size_t offset = 0;
+        for (; offset + FramePattern::BLOCK_SIZE <= plane.bytes; offset += FramePattern::BLOCK_SIZE)
+            memcpy(dst + offset, plane.block, FramePattern::BLOCK_SIZE);
+        for (; offset < plane.bytes; offset++)
+            dst[offset] = plane.block[offset % FramePattern::BLOCK_SIZE];
+    }
+}
+
+// The layout of each pixel format.
+template <PixelFormat F> struct PixelFormatLayout;
+template <> struct PixelFormatLayout<PIXEL_FORMAT_RGBA>    : PixelLayout::PackedRGB8<0, 1, 2, 3> {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_UYVY>    : PixelLayout::Packed422<1, 0, 3, 2> {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_YUYV>    : PixelLayout::Packed422<0, 1, 2, 3> {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_NV12>    : PixelLayout::SemiPlanar420<8> {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_RGB10A2> : PixelLayout::PackedRGB10<0, 10, 20> {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_V210>    : PixelLayout::PackedV210 {};
+template <> struct PixelFormatLayout<PIXEL_FORMAT_P010>    : PixelLayout::SemiPlanar420<10> {};
+
+// Returns the pattern of a frame with the given ID.
+template <PixelFormat F>
+FramePattern EncodeFrame(const FrameId& id, const TestFormat& format)
+{
+    using Layout = PixelFormatLayout<F>;
+
+    FramePattern pattern = {};
+    pattern.planeCount = Layout::PLANES;
+    pattern.samples = Layout::SAMPLES;
+    pattern.ignoredBits = Layout::IGNORED_BITS;
+    if (Layout::PLANES == 2)
+    {
+        pattern.planes[0] = { 0, format.chromaOffset };
+        pattern.planes[1] = { format.chromaOffset, format.totalBytes - format.chromaOffset };
+    }
+    else
+    {
+        pattern.planes[0] = { 0, format.totalBytes };
+    }
+    Layout::Encode(id, &pattern);
+    return pattern;
+}
+
+// Returns the ID of a captured frame.
+template <PixelFormat F>
+PIXEL_FUNCTION FrameId DecodeFrame(const uint8_t* frame, const TestFormat& format)
+{
+    return PixelFormatLayout<F>::Decode(frame, format.chromaOffset);
+}
+
+// The encode and decode functions for a pixel format, which are selected once
+// (e.g. when a producer is created) rather than branching on every frame.
+struct FrameCodec
+{
+    FramePattern (*encode)(const FrameId& id, const TestFormat& format);
+    FrameId (*decode)(const uint8_t* frame, const TestFormat& format);
+};
+
+template <PixelFormat F>
+constexpr FrameCodec MakeFrameCodec()
+{
+    return { &EncodeFrame<F>, &DecodeFrame<F> };
+}
+
+inline FrameCodec GetFrameCodec(PixelFormat format)
+{
+    switch (format)
+    {
+        case PIXEL_FORMAT_UYVY:    return MakeFrameCodec<PIXEL_FORMAT_UYVY>();
+        case PIXEL_FORMAT_YUYV:    return MakeFrameCodec<PIXEL_FORMAT_YUYV>();
+        case PIXEL_FORMAT_NV12:    return MakeFrameCodec<PIXEL_FORMAT_NV12>();
+        case PIXEL_FORMAT_RGB10A2: return MakeFrameCodec<PIXEL_FORMAT_RGB10A2>();
+        case PIXEL_FORMAT_V210:    return MakeFrameCodec<PIXEL_FORMAT_V210>();
+        case PIXEL_FORMAT_P010:    return MakeFrameCodec<PIXEL_FORMAT_P010>();
+        default:                   return MakeFrameCodec<PIXEL_FORMAT_RGBA>();
+    }
+}
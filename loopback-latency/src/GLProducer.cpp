@@ -30,7 +30,9 @@ GLProducer::GLProducer(const TestFormat& format, size_t simulatedProcessing)
     , m_window(nullptr)
     , m_cudaBuffer(nullptr)
 {
+    m_startupPhases.Resume();
     glfwInit();
+    m_startupPhases.Record("Initialize GLFW");
 }
 
 GLProducer::~GLProducer()
@@ -54,6 +56,14 @@ void GLProducer::ShowSupportedVideoModes(GLFWmonitor* monitor)
 
 bool GLProducer::Initialize()
 {
+    m_startupPhases.Resume();
+
+    if (m_format.pixelFormat != PIXEL_FORMAT_RGBA)
+    {
+        Error("The GL producer only supports the RGBA pixel format.");
+        return false;
+    }
+
     int monitorCount;
     glfwGetMonitors(&monitorCount);
     if (monitorCount > 1)
@@ -71,8 +81,13 @@ bool GLProducer::Initialize()
         return false;
     }
 
-    glfwWindowHint(GLFW_REFRESH_RATE, m_format.frameRate);
+    m_startupPhases.Record("Get monitor");
+
+    // GLFW video modes only have whole refresh rates, so fractional rates
+    // (e.g. 59.94Hz) cannot be distinguished from the rounded rate (60Hz).
+    glfwWindowHint(GLFW_REFRESH_RATE, m_format.frameRate.RoundedHz());
     m_window = glfwCreateWindow(m_format.width, m_format.height, "GLRenderer", m_monitor, nullptr);
+    m_startupPhases.Record("Create window");
 
     // The window may be initialized at a less-than-fullscreen size due to
     // desktop UI menu/toolbars and then switched to the actual fullscreen
@@ -88,12 +103,13 @@ bool GLProducer::Initialize()
         glfwWaitEventsTimeout(WINDOW_SIZE_WAIT_EVENT_TIMEOUT);
         glfwGetWindowSize(m_window, &windowWidth, &windowHeight);
     }
+    m_startupPhases.Record("Wait for fullscreen");
 
     const GLFWvidmode* mode = glfwGetVideoMode(m_monitor);
     if (!m_window || !mode ||
         mode->width != m_format.width ||
         mode->height != m_format.height ||
-        mode->refreshRate != m_format.frameRate ||
+        mode->refreshRate != (int)m_format.frameRate.RoundedHz() ||
         windowWidth != m_format.width ||
         windowHeight != m_format.height)
     {
@@ -124,6 +140,20 @@ bool GLProducer::Initialize()
         Error("Failed to allocate CUDA memory.");
         return false;
     }
+    m_startupPhases.Record("Allocate CUDA buffer");
+
+    // Content other than the solid frame color is written to a host buffer
+    // that is drawn to the window.
+    if (Content() != CONTENT_SOLID)
+    {
+        if (!InitializeContent(true))
+        {
+            Error("Failed to initialize the frame content.");
+            return false;
+        }
+        m_hostBuffer.resize(m_format.totalBytes);
+        m_startupPhases.Record("Initialize content");
+    }
 
     return true;
 }
@@ -136,12 +166,18 @@ void GLProducer::Close()
     if (m_cudaBuffer)
         CudaFree(m_cudaBuffer);
     m_cudaBuffer = nullptr;
+    m_hostBuffer.clear();
 
     if (m_window)
         glfwDestroyWindow(m_window);
     m_window = nullptr;
 }
 
+bool GLProducer::CanDisableVsync() const
+{
+    return true;
+}
+
 std::ostream& GLProducer::Dump(std::ostream& o) const
 {
     o << "OpenGL" << std::endl
@@ -153,37 +189,51 @@ void GLProducer::StreamThread()
 {
     glfwMakeContextCurrent(m_window);
 
-    glfwSwapInterval(1);
+    glfwSwapInterval(Vsync() ? 1 : 0);
+
+    // The host buffer starts with the top line, so it is drawn downwards
+    // from the top left corner of the window.
+    glRasterPos2f(-1.0f, 1.0f);
+    glPixelZoom(1.0f, -1.0f);
 
     while (IsStreaming())
     {
         auto frame = StartFrame();
 
-        frame->RecordProcessingStart();
+        frame->Record(MARKER_PROCESSING_START);
 
         // Simulate processing time.
         size_t elementCount = m_format.width * m_format.height;
-        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, m_simulatedProcessing);
+        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, SimulatedProcessing(*frame));
 
-        frame->RecordRenderStart();
+        frame->Record(MARKER_RENDER_START);
 
         // Render the frame.
-        glClearColor(frame->R() / 255.0f, frame->G() / 255.0f, frame->B() / 255.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        if (m_hostBuffer.empty())
+        {
+            glClearColor(frame->R() / 255.0f, frame->G() / 255.0f, frame->B() / 255.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        else
+        {
+            RenderFrameHost(*frame, m_hostBuffer.data());
+            glDrawPixels(m_format.width, m_format.height, GL_RGBA, GL_UNSIGNED_BYTE, m_hostBuffer.data());
+        }
         glFinish();
 
-        frame->RecordRenderEnd();
-        frame->RecordCopiedFromGPU();
-        frame->RecordWriteEnd();
+        frame->Record(MARKER_RENDER_END);
+        frame->Record(MARKER_COPIED_FROM_GPU);
+        frame->Record(MARKER_WRITE_END);
 
         // Present the frame and wait for scanout to start
         // Note: The glFinish here is essentially blocking until the back buffer
         //       for the next frame is available for rendering (implying that
-        //       scanout of the front buffer has begun).
+        //       scanout of the front buffer has begun). With the vsync disabled
+        //       this only waits for the buffers to be swapped.
         glfwSwapBuffers(m_window);
         glFinish();
 
-        frame->RecordScanoutStart();
+        RecordScanout(*frame);
     }
 
     glfwMakeContextCurrent(nullptr);
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <GLFW/glfw3.h>
+#include <vector>
 
 #include "Producer.h"
 
@@ -35,6 +36,7 @@ public:
 
     virtual bool Initialize();
     virtual void Close();
+    virtual bool CanDisableVsync() const;
 
 private:
 
@@ -47,4 +49,7 @@ private:
     GLFWwindow* m_window;
 
     void* m_cudaBuffer;
+
+    // The frame that is drawn when there is content other than the frame color.
+    std::vector<uint8_t> m_hostBuffer;
 };
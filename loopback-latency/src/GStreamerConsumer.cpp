@@ -24,6 +24,7 @@
 #include <gst/app/gstappsink.h>
 
 #include "GStreamerConsumer.h"
+#include "AsyncLog.h"
 #include "Console.h"
 #include "CudaUtils.h"
 
@@ -42,7 +43,9 @@ GStreamerConsumer::GStreamerConsumer(std::shared_ptr<Producer> producer,
     , m_warmupFramesRemaining(0)
     , m_framesRemaining(0)
 {
+    m_startupPhases.Resume();
     gst_init(argc, argv);
+    m_startupPhases.Record("Initialize GStreamer");
 }
 
 GStreamerConsumer::~GStreamerConsumer()
@@ -52,6 +55,8 @@ GStreamerConsumer::~GStreamerConsumer()
 
 bool GStreamerConsumer::Initialize()
 {
+    m_startupPhases.Resume();
+
     // Create the GStreamer elements.
     m_pipeline = gst_pipeline_new("v4l2-consumer");
     m_source = gst_element_factory_make("v4l2src", "v4l2-camera-src");
@@ -71,7 +76,7 @@ bool GStreamerConsumer::Initialize()
         "format", G_TYPE_STRING, GetCapsFormat(m_producer->Format().pixelFormat).c_str(),
         "width", G_TYPE_INT, m_producer->Format().width,
         "height", G_TYPE_INT, m_producer->Format().height,
-        "framerate", GST_TYPE_FRACTION, m_producer->Format().frameRate, 1, NULL);
+        "framerate", GST_TYPE_FRACTION, m_producer->Format().frameRate.num, m_producer->Format().frameRate.den, NULL);
     gst_caps_append_structure(m_caps, s);
     gst_app_sink_set_caps(GST_APP_SINK(m_sink), m_caps);
 
@@ -94,6 +99,7 @@ bool GStreamerConsumer::Initialize()
 
     // Create the main loop to handle GLib events.
     m_loop = g_main_loop_new(NULL, FALSE);
+    m_startupPhases.Record("Create pipeline");
 
     // Allocate the CUDA buffer.
     m_cudaBuffer = CudaAlloc(m_producer->Format().totalBytes);
@@ -102,6 +108,12 @@ bool GStreamerConsumer::Initialize()
         Error("Failed to allocate CUDA memory.");
         return false;
     }
+    if (!AllocateBuffers())
+    {
+        Error("Failed to allocate the frame conversion and verification buffers.");
+        return false;
+    }
+    m_startupPhases.Record("Allocate CUDA buffer");
 
     return true;
 }
@@ -131,8 +143,18 @@ void GStreamerConsumer::Close()
 
 bool GStreamerConsumer::StartStreaming()
 {
+    m_startupPhases.Resume();
     gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
 
+    // Wait for the state change to complete so that it can be timed.
+    const GstClockTime STATE_CHANGE_TIMEOUT = 5 * GST_SECOND;
+    if (gst_element_get_state(m_pipeline, nullptr, nullptr, STATE_CHANGE_TIMEOUT) == GST_STATE_CHANGE_FAILURE)
+    {
+        Error("Failed to set the GStreamer pipeline to PLAYING.");
+        return false;
+    }
+    m_startupPhases.Record("Set pipeline to PLAYING");
+
     return true;
 }
 
@@ -148,10 +170,15 @@ bool GStreamerConsumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
     m_numFrames = numFrames;
     m_warmupFramesRemaining = warmupFrames;
     m_framesRemaining = numFrames;
+    m_lastBufferTime = Clock::now();
     m_frameCountMutex.unlock();
 
-    // Wait until the callback has measured the requested frames.
+    // Wait until the callback has measured the requested frames. A wait
+    // without any buffers (e.g. when the signal is lost) ends the capture, or
+    // is recorded as a glitch in the resilient mode.
+    const auto BUFFER_TIMEOUT = std::chrono::seconds(2);
     bool done = false;
+    bool timedOut = false;
     m_eos = false;
     while (!done)
     {
@@ -164,10 +191,30 @@ bool GStreamerConsumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
 
         m_frameCountMutex.lock();
         done = m_framesRemaining == 0 && m_warmupFramesRemaining == 0;
+        TimePoint now = Clock::now();
+        if (!done && now - m_lastBufferTime > BUFFER_TIMEOUT)
+        {
+            if (Resilient())
+            {
+                RecordGlitch(now, nullptr);
+                m_lastBufferTime = now;
+                timedOut = !SkipGlitch();
+            }
+            else
+            {
+                Error("Timed out waiting for a buffer from the GStreamer pipeline.");
+                timedOut = true;
+            }
+        }
         m_frameCountMutex.unlock();
+        if (timedOut)
+        {
+            StopStreaming();
+            return false;
+        }
         usleep(1000);
     }
-    Log(numFrames << " / " << numFrames);
+    LogAsync(numFrames, " / ", numFrames);
 
     return true;
 }
@@ -182,6 +229,16 @@ GstFlowReturn GStreamerConsumer::BufferCallback(GstElement* sink)
         return GST_FLOW_ERROR;
     }
 
+    GstFlowReturn result = ProcessSample(sample);
+
+    // Release the sample and buffer reference.
+    gst_sample_unref(sample);
+
+    return result;
+}
+
+GstFlowReturn GStreamerConsumer::ProcessSample(GstSample* sample)
+{
     GstBuffer* buffer = gst_sample_get_buffer(sample);
     if (!buffer)
     {
@@ -189,9 +246,11 @@ GstFlowReturn GStreamerConsumer::BufferCallback(GstElement* sink)
         return GST_FLOW_ERROR;
     }
 
-    TimePoint receiveTime = Clock::now();
+    Timestamp receiveTime = Timestamp::Now();
 
     std::lock_guard<std::mutex> lock(m_frameCountMutex);
+    m_lastBufferTime = receiveTime.time;
+    RecordCapture(receiveTime.time);
     if (m_warmupFramesRemaining)
     {
         m_warmupFramesRemaining--;
@@ -205,46 +264,46 @@ GstFlowReturn GStreamerConsumer::BufferCallback(GstElement* sink)
             return GST_FLOW_ERROR;
         }
 
-        TimePoint readEnd = Clock::now();
+        Timestamp readEnd = Timestamp::Now(MARKER_READ_END);
 
         // Copy the buffer to GPU.
         CudaMemcpyHtoD(m_cudaBuffer, map.data, m_producer->Format().totalBytes);
 
-        TimePoint copiedToGPU = Clock::now();
+        Timestamp copiedToGPU = Timestamp::Now(MARKER_COPIED_TO_GPU);
 
-        // Get the frame pointer from the producer.
-        auto frame = m_producer->GetFrame(map.data);
-        if (!frame)
+        Timestamp converted = ConvertToRGBA(m_cudaBuffer);
+
+        // Sources that number their buffers (such as v4l2src) set the offset
+        // to the frame number, which skips the frames that they dropped.
+        DriverCapture driver;
+        if (GST_BUFFER_OFFSET(buffer) != GST_BUFFER_OFFSET_NONE)
         {
-            return GST_FLOW_ERROR;
+            driver.hasSequence = true;
+            driver.sequence = GST_BUFFER_OFFSET(buffer);
         }
 
+        // Get the frame pointer from the producer. Frames that cannot be
+        // identified are skipped in the resilient mode.
+        auto frame = IdentifyFrame(map.data, m_cudaBuffer, receiveTime, driver);
         gst_buffer_unmap(buffer, &map);
-
-        if (m_frames.size() && m_frames.back()->Number() == frame->Number())
-        {
-            // If this frame has already been received, increment the duplicate count.
-            frame->RecordDuplicateReceive();
-        }
-        else
+        if (!frame && !SkipGlitch())
         {
-            // Otherwise, record the times and add it to the consumer list.
-            frame->RecordFrameReceived(receiveTime);
-            frame->RecordReadEnd(readEnd);
-            frame->RecordCopiedToGPU(copiedToGPU);
-            m_frames.push_back(frame);
+            return GST_FLOW_ERROR;
         }
 
-        if (m_framesRemaining != m_numFrames && (m_numFrames - m_framesRemaining) % 100 == 0)
+        // Skipped captures do not count towards the frames to measure.
+        if (frame)
         {
-            Log((m_numFrames - m_framesRemaining) << " / " << m_numFrames);
-        }
+            ReceiveFrame(frame, m_cudaBuffer, receiveTime, readEnd, copiedToGPU, converted);
 
-        m_framesRemaining--;
-    }
+            if (m_framesRemaining != m_numFrames && (m_numFrames - m_framesRemaining) % 100 == 0)
+            {
+                LogAsync(m_numFrames - m_framesRemaining, " / ", m_numFrames);
+            }
 
-    // Release the sample and buffer reference.
-    gst_sample_unref(sample);
+            m_framesRemaining--;
+        }
+    }
 
     return GST_FLOW_OK;
 }
@@ -269,6 +328,12 @@ std::string GStreamerConsumer::GetCapsFormat(PixelFormat format)
         // Note: The V4L2 GStreamer source uses "BGRA" as the format, even though
         //       the actual input format is RGBA.
         case PIXEL_FORMAT_RGBA: return "BGRA";
+        case PIXEL_FORMAT_UYVY: return "UYVY";
+        case PIXEL_FORMAT_YUYV: return "YUY2";
+        case PIXEL_FORMAT_NV12: return "NV12";
+        case PIXEL_FORMAT_RGB10A2: return "RGB10A2_LE";
+        case PIXEL_FORMAT_V210: return "v210";
+        case PIXEL_FORMAT_P010: return "P010_10LE";
         default: return "UNKNOWN";
     }
 }
@@ -43,6 +43,7 @@ public:
 private:
 
     GstFlowReturn BufferCallback(GstElement* sink);
+    GstFlowReturn ProcessSample(GstSample* sample);
     static GstFlowReturn BufferCallbackStatic(GstElement* sink, GStreamerConsumer* consumer);
 
     static gboolean BusCallbackStatic(GstBus* bus, GstMessage* msg, gpointer data);
@@ -65,4 +66,5 @@ private:
     size_t m_numFrames;
     size_t m_warmupFramesRemaining;
     size_t m_framesRemaining;
+    TimePoint m_lastBufferTime;
 };
@@ -20,6 +20,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <cmath>
 #include <gdk/gdkx.h>
 #include <gst/app/gstappsrc.h>
 #include <gst/video/videooverlay.h>
@@ -47,8 +48,11 @@ GStreamerProducer::GStreamerProducer(int* argc, char** argv[],
     , m_pool(nullptr)
     , m_cudaBuffer(nullptr)
 {
+    m_startupPhases.Resume();
     gtk_init(argc, argv);
+    m_startupPhases.Record("Initialize GTK");
     gst_init(argc, argv);
+    m_startupPhases.Record("Initialize GStreamer");
 }
 
 GStreamerProducer::~GStreamerProducer()
@@ -58,6 +62,14 @@ GStreamerProducer::~GStreamerProducer()
 
 bool GStreamerProducer::Initialize()
 {
+    m_startupPhases.Resume();
+
+    if (m_format.pixelFormat != PIXEL_FORMAT_RGBA)
+    {
+        Error("The GStreamer producer only supports the RGBA pixel format.");
+        return false;
+    }
+
     // Create the GStreamer elements.
     m_pipeline = gst_pipeline_new("gstreamer-producer");
     m_source = gst_element_factory_make("appsrc", "app-source");
@@ -74,7 +86,7 @@ bool GStreamerProducer::Initialize()
         "format", G_TYPE_STRING, GetCapsFormat(m_format.pixelFormat).c_str(),
         "width", G_TYPE_INT, m_format.width,
         "height", G_TYPE_INT, m_format.height,
-        "framerate", GST_TYPE_FRACTION, m_format.frameRate, 1, NULL);
+        "framerate", GST_TYPE_FRACTION, m_format.frameRate.num, m_format.frameRate.den, NULL);
     gst_caps_append_structure(m_caps, s);
     if (m_useRDMA)
     {
@@ -111,6 +123,7 @@ bool GStreamerProducer::Initialize()
         Error("Failed to link GStreamer elements.");
         return false;
     }
+    m_startupPhases.Record("Create pipeline");
 
 #ifdef ENABLE_DEEPSTREAM
     // Create the NvDsBufferPool for RDMA.
@@ -136,6 +149,7 @@ bool GStreamerProducer::Initialize()
         }
 
         gst_buffer_pool_set_active(m_pool, true);
+        m_startupPhases.Record("Create buffer pool");
     }
 #endif
 
@@ -146,6 +160,14 @@ bool GStreamerProducer::Initialize()
         Error("Failed to allocate CUDA memory.");
         return false;
     }
+    m_startupPhases.Record("Allocate CUDA buffer");
+
+    if (!InitializeContent(false))
+    {
+        Error("Failed to initialize the frame content.");
+        return false;
+    }
+    m_startupPhases.Record("Initialize content");
 
     // Check the display configuration.
     GdkDisplay* display = gdk_display_get_default();
@@ -173,10 +195,16 @@ bool GStreamerProducer::Initialize()
     GdkRectangle geometry;
     gdk_monitor_get_geometry(monitor, &geometry);
     int scaleFactor = gdk_monitor_get_scale_factor(monitor);
-    int refreshRate = gdk_monitor_get_refresh_rate(monitor) / 1000;
+    // The refresh rate is given in millihertz, which distinguishes the
+    // fractional rates (e.g. 59940 for 59.94Hz) from the whole rates.
+    int refreshRateMilli = gdk_monitor_get_refresh_rate(monitor);
+    double refreshRate = refreshRateMilli / 1000.0;
+    // Allows for the rounding of the mode timings, but is well below the 60mHz
+    // between a fractional rate and the whole rate (e.g. 59.94Hz and 60Hz).
+    const double REFRESH_RATE_TOLERANCE_MILLI = 20.0;
     if (geometry.width * scaleFactor != m_format.width ||
         geometry.height * scaleFactor != m_format.height ||
-        refreshRate != m_format.frameRate)
+        std::abs(refreshRateMilli - m_format.frameRate.Hz() * 1000.0) > REFRESH_RATE_TOLERANCE_MILLI)
     {
         Error("The requested format (" << m_format.width << "x" << m_format.height << " @ " <<
               m_format.frameRate << "Hz) does not match" << std::endl <<
@@ -193,6 +221,7 @@ bool GStreamerProducer::Initialize()
               "       the mode is supported by the devices.");
         return false;
     }
+    m_startupPhases.Record("Check display mode");
 
     // Create the window for the rendering overlay.
     GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -202,6 +231,7 @@ bool GStreamerProducer::Initialize()
     gtk_window_set_default_size(GTK_WINDOW(window), 1920, 1080);
     gtk_window_fullscreen(GTK_WINDOW(window));
     gtk_widget_show_all(window);
+    m_startupPhases.Record("Create window");
 
     // Create the main loop to handle GLib events.
     m_loop = g_main_loop_new(NULL, FALSE);
@@ -240,7 +270,12 @@ void GStreamerProducer::Close()
 
 bool GStreamerProducer::StartStreaming()
 {
+    // Note that the pipeline can't reach the PLAYING state until the sink has
+    // prerolled with the first buffer from the stream thread, so the time until
+    // then is included in the time to the first frame rather than waited for here.
+    m_startupPhases.Resume();
     gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
+    m_startupPhases.Record("Set pipeline to PLAYING");
 
     return Producer::StartStreaming();
 }
@@ -285,13 +320,13 @@ void GStreamerProducer::StreamThread()
 
         auto frame = StartFrame();
 
-        frame->RecordProcessingStart();
+        frame->Record(MARKER_PROCESSING_START);
 
         // Simulate processing time.
         size_t elementCount = m_format.width * m_format.height;
-        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, m_simulatedProcessing);
+        CudaSimulateProcessing((uint32_t*)m_cudaBuffer, elementCount, SimulatedProcessing(*frame));
 
-        frame->RecordRenderStart();
+        frame->Record(MARKER_RENDER_START);
 
         GstBuffer* buf(nullptr);
         GstMapInfo map;
@@ -303,17 +338,17 @@ void GStreamerProducer::StreamThread()
 
             gst_buffer_map(buf, &map, (GstMapFlags)(GST_MAP_READ | GST_MAP_WRITE));
             NvBufSurface* surf = (NvBufSurface*)map.data;
-            CudaWriteRGBA((uint32_t*)surf->surfaceList->dataPtr, elementCount, frame->R(), frame->G(), frame->B());
+            RenderFrame(*frame, surf->surfaceList->dataPtr);
             gst_buffer_unmap(buf, &map);
         }
         else
 #endif
         {
             // Write to the scratch CUDA buffer.
-            CudaWriteRGBA((uint32_t*)m_cudaBuffer, elementCount, frame->R(), frame->G(), frame->B());
+            RenderFrame(*frame, m_cudaBuffer);
         }
 
-        frame->RecordRenderEnd();
+        frame->Record(MARKER_RENDER_END);
 
         if (!m_useRDMA)
         {
@@ -324,14 +359,14 @@ void GStreamerProducer::StreamThread()
             gst_buffer_unmap(buf, &map);
         }
 
-        frame->RecordCopiedFromGPU();
+        frame->Record(MARKER_COPIED_FROM_GPU);
 
-        frame->RecordWriteEnd();
+        frame->Record(MARKER_WRITE_END);
 
         // Push the buffer to the appsrc.
         gst_app_src_push_buffer(GST_APP_SRC(m_source), buf);
 
-        frame->RecordScanoutStart();
+        RecordScanout(*frame);
     }
 }
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "StageRegistry.h"
+
+// The instrumentation level is selected at compile time with the
+// INSTRUMENTATION_LEVEL CMake option such that any instrumentation above the
+// selected level is removed entirely. Comparing the results of builds at
+// different levels gives the overhead added by the measurement itself.
+enum InstrumentationLevel
+{
+    // Only the markers that are needed for the end-to-end latency and the
+    // startup times are recorded; no stage times are available.
+    INSTRUMENTATION_OFF,
+
+    // Every marker is recorded.
+    INSTRUMENTATION_TIMESTAMPS,
+
+    // Every marker is recorded along with the thread CPU time and hardware
+    // counters, when enabled by the --cpu-stats and --perf-counters options.
+    INSTRUMENTATION_COUNTERS,
+
+    // As above, plus a log message for every frame that is produced or received.
+    INSTRUMENTATION_TRACE,
+};
+
+#ifndef INSTRUMENTATION_LEVEL
+#define INSTRUMENTATION_LEVEL INSTRUMENTATION_COUNTERS
+#endif
+
+constexpr InstrumentationLevel INSTRUMENTATION = INSTRUMENTATION_LEVEL;
+
+// Returns whether the marker is recorded at the compiled instrumentation level.
+// A marker that could not be registered (MAX_MARKERS) is never recorded.
+constexpr bool MarkerEnabled(MarkerId marker)
+{
+    return marker < MAX_MARKERS &&
+           (INSTRUMENTATION >= INSTRUMENTATION_TIMESTAMPS ||
+            marker == MARKER_PROCESSING_START ||
+            marker == MARKER_SCANOUT_START ||
+            marker == MARKER_COPIED_TO_GPU);
+}
+
+inline const char* InstrumentationName(InstrumentationLevel level)
+{
+    switch (level)
+    {
+        case INSTRUMENTATION_OFF:        return "off";
+        case INSTRUMENTATION_TIMESTAMPS: return "timestamps";
+        case INSTRUMENTATION_COUNTERS:   return "counters";
+        case INSTRUMENTATION_TRACE:      return "trace";
+        default:                         return "unknown";
+    }
+}
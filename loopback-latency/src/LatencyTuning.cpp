@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include "LatencyTuning.h"
+#include "Console.h"
+#include "SystemAudit.h"
+
+namespace
+{
+    // The tuning that is restored by RestoreOnSignal.
+    LatencyTuning* s_applied = nullptr;
+}
+
+LatencyTuning::LatencyTuning()
+    : m_dmaLatencyFd(-1)
+    , m_signalsInstalled(false)
+{
+}
+
+LatencyTuning::~LatencyTuning()
+{
+    Restore();
+}
+
+bool LatencyTuning::Apply()
+{
+    bool applied = true;
+
+    // The PM QoS request only remains active while the file is held open.
+    m_dmaLatencyFd = open("/dev/cpu_dma_latency", O_WRONLY);
+    int32_t latency = 0;
+    if (m_dmaLatencyFd < 0 || write(m_dmaLatencyFd, &latency, sizeof(latency)) != sizeof(latency))
+    {
+        Warning("Failed to set /dev/cpu_dma_latency to 0 (requires root).");
+        applied = false;
+    }
+
+    for (int cpu : SystemAudit::OnlineCpus())
+    {
+        const std::string path("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor");
+        if (access(path.c_str(), F_OK) == 0 && !WriteSetting(path, "performance"))
+        {
+            Warning("Failed to set the CPU" << cpu << " frequency governor to performance.");
+            applied = false;
+        }
+    }
+
+    const std::string thpDefrag("/sys/kernel/mm/transparent_hugepage/defrag");
+    if (access(thpDefrag.c_str(), F_OK) == 0 && !WriteSetting(thpDefrag, "madvise"))
+    {
+        Warning("Failed to set transparent huge page defragmentation to madvise.");
+        applied = false;
+    }
+
+    // The settings are not changed after this, so the handler can read them.
+    if (!m_originalSettings.empty() && !m_signalsInstalled)
+    {
+        s_applied = this;
+
+        struct sigaction action = {};
+        action.sa_handler = RestoreOnSignal;
+        action.sa_flags = SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &m_previousInt);
+        sigaction(SIGTERM, &action, &m_previousTerm);
+        m_signalsInstalled = true;
+    }
+
+    return applied;
+}
+
+void LatencyTuning::Restore()
+{
+    // The handlers are removed first so that they never see a partial restore.
+    if (m_signalsInstalled)
+    {
+        sigaction(SIGINT, &m_previousInt, nullptr);
+        sigaction(SIGTERM, &m_previousTerm, nullptr);
+        m_signalsInstalled = false;
+        s_applied = nullptr;
+    }
+
+    if (m_dmaLatencyFd >= 0)
+        close(m_dmaLatencyFd);
+    m_dmaLatencyFd = -1;
+
+    for (auto it = m_originalSettings.rbegin(); it != m_originalSettings.rend(); ++it)
+    {
+        std::ofstream file(it->first);
+        file << it->second;
+    }
+    m_originalSettings.clear();
+}
+
+bool LatencyTuning::WriteSetting(const std::string& path, const std::string& value)
+{
+    std::string original;
+    std::ifstream in(path);
+    std::getline(in, original);
+
+    // Option lists (e.g. "always [madvise] never") give the current value in brackets.
+    size_t start = original.find('[');
+    size_t end = original.find(']');
+    if (start != std::string::npos && end != std::string::npos && end > start)
+        original = original.substr(start + 1, end - start - 1);
+
+    std::ofstream out(path);
+    out << value;
+    out.flush();
+    if (out.fail())
+        return false;
+
+    m_originalSettings.push_back(std::make_pair(path, original));
+    return true;
+}
+
+void LatencyTuning::RestoreOnSignal(int signal)
+{
+    if (s_applied)
+    {
+        for (auto it = s_applied->m_originalSettings.rbegin(); it != s_applied->m_originalSettings.rend(); ++it)
+        {
+            int fd = open(it->first.c_str(), O_WRONLY | O_TRUNC);
+            if (fd >= 0)
+            {
+                ssize_t written = write(fd, it->second.c_str(), it->second.size());
+                (void)written;
+                close(fd);
+            }
+        }
+
+        const char message[] = "Restored the latency tuning settings.\n";
+        ssize_t written = write(STDERR_FILENO, message, strlen(message));
+        (void)written;
+    }
+
+    // SA_RESETHAND has restored the default action, which ends the process.
+    raise(signal);
+}
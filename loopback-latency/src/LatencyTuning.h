@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <signal.h>
+
+#include <string>
+#include <vector>
+
+// Applies the recommended low-latency system settings for the duration of a
+// run, restoring the original settings when destroyed. This requires root.
+//
+// The following settings are applied:
+//   - /dev/cpu_dma_latency is held open at 0 to keep CPUs out of deep C-states.
+//   - The CPU frequency governor is set to "performance" for all online CPUs.
+//   - Transparent huge page defragmentation is limited to madvise regions to
+//     avoid direct compaction stalls.
+//
+// The governor and huge page settings are system-wide and outlive the process,
+// so they are also restored if the run is ended by SIGINT or SIGTERM.
+class LatencyTuning
+{
+public:
+
+    LatencyTuning();
+    ~LatencyTuning();
+
+    // Applies the settings, returning false if any of them could not be applied.
+    bool Apply();
+    void Restore();
+
+private:
+
+    bool WriteSetting(const std::string& path, const std::string& value);
+
+    // Restores the settings of the applied tuning from a signal handler (using
+    // only async-signal-safe calls), then ends the process with the signal.
+    static void RestoreOnSignal(int signal);
+
+    int m_dmaLatencyFd;
+    std::vector<std::pair<std::string, std::string>> m_originalSettings;
+
+    bool m_signalsInstalled;
+    struct sigaction m_previousInt;
+    struct sigaction m_previousTerm;
+};
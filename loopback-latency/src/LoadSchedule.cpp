@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "Console.h"
+#include "LoadSchedule.h"
+
+// Parses a non-negative integer that makes up the whole of the given string.
+static bool ParseCount(const std::string& value, size_t* count)
+{
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    *count = strtoull(value.c_str(), nullptr, 10);
+    return true;
+}
+
+bool LoadSchedule::Parse(const std::string& schedule)
+{
+    // The schedule is only replaced once all of it has been parsed.
+    LoadSchedule parsed;
+    std::istringstream ss(schedule);
+    std::string entry;
+    while (std::getline(ss, entry, ','))
+    {
+        if (parsed.m_repeat)
+        {
+            Error("Invalid load schedule '" << schedule << "': repeat must be the last entry.");
+            return false;
+        }
+        if (entry == "repeat")
+        {
+            parsed.m_repeat = true;
+            continue;
+        }
+
+        Segment segment;
+        size_t frames = 0;
+        auto colon = entry.find(':');
+        auto dash = entry.find('-');
+        bool valid = colon != std::string::npos && ParseCount(entry.substr(colon + 1), &frames) && frames > 0;
+        if (valid && dash != std::string::npos && dash < colon)
+        {
+            valid = ParseCount(entry.substr(0, dash), &segment.from) &&
+                    ParseCount(entry.substr(dash + 1, colon - dash - 1), &segment.to);
+        }
+        else if (valid)
+        {
+            valid = ParseCount(entry.substr(0, colon), &segment.from);
+            segment.to = segment.from;
+        }
+        if (!valid)
+        {
+            Error("Invalid load schedule segment '" << entry << "' (expected {loops}:{frames} or {from}-{to}:{frames}).");
+            return false;
+        }
+        segment.frames = frames;
+        parsed.m_segments.push_back(segment);
+        parsed.m_length += segment.frames;
+    }
+
+    if (parsed.m_segments.empty())
+    {
+        Error("Invalid load schedule '" << schedule << "': no segments were given.");
+        return false;
+    }
+    *this = parsed;
+    return true;
+}
+
+size_t LoadSchedule::Loops(uint32_t frame) const
+{
+    if (m_segments.empty())
+        return 0;
+    if (frame >= m_length)
+    {
+        if (!m_repeat)
+            return m_segments.back().to;
+        frame %= m_length;
+    }
+
+    for (const auto& segment : m_segments)
+    {
+        if (frame < segment.frames)
+        {
+            if (segment.frames == 1 || segment.from == segment.to)
+                return segment.to;
+
+            // The ramp reaches the final load on the last frame of the segment.
+            double progress = double(frame) / (segment.frames - 1);
+            return segment.from + ((double)segment.to - (double)segment.from) * progress + 0.5;
+        }
+        frame -= segment.frames;
+    }
+    return m_segments.back().to;
+}
+
+std::vector<LoadSchedule::Transition> LoadSchedule::Transitions(uint32_t endFrame) const
+{
+    std::vector<Transition> transitions;
+    uint32_t start = 0;
+    for (size_t pass = 0; start < endFrame && (pass == 0 || m_repeat); pass++)
+    {
+        for (size_t i = 0; i < m_segments.size() && start < endFrame; i++)
+        {
+            const auto& segment = m_segments[i];
+            Transition t;
+            t.frame = start;
+            t.end = start + segment.frames;
+            t.from = start > 0 ? Loops(start - 1) : segment.from;
+            t.to = segment.to;
+            t.ramp = segment.from != segment.to;
+            if (start > 0 && (t.ramp || t.from != t.to))
+                transitions.push_back(t);
+            start += segment.frames;
+        }
+    }
+
+    // Without repeating, the last segment lasts until the end of the run.
+    if (!m_repeat && !transitions.empty() && transitions.back().end == m_length)
+        transitions.back().end = std::max(endFrame, m_length);
+    return transitions;
+}
+
+std::ostream& operator<<(std::ostream& o, const LoadSchedule& schedule)
+{
+    for (size_t i = 0; i < schedule.Segments().size(); i++)
+    {
+        const auto& segment = schedule.Segments()[i];
+        o << (i ? "," : "") << segment.from;
+        if (segment.from != segment.to)
+            o << "-" << segment.to;
+        o << ":" << segment.frames;
+    }
+    if (schedule.Repeats())
+        o << ",repeat";
+    return o;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A schedule of the simulated processing (in CUDA loops, see -s) added to each
+// frame, made up of segments that each hold or ramp the load for a number of
+// frames. The schedule is given as comma-separated segments:
+//
+//   {loops}:{frames}            Hold the load for the given frames (a step,
+//                               or a burst when the segment is short).
+//   {from}-{to}:{frames}        Ramp the load linearly from one value to the
+//                               other over the given frames.
+//   repeat                      Repeat the schedule from the start (only as
+//                               the last entry). Otherwise the load of the
+//                               last segment is held once the schedule ends.
+//
+// e.g. 0:300,20000:120,0:300 steps the load up and back down again, while
+// 0:120,30000:3,repeat adds a 3 frame burst every 123 frames.
+//
+// The schedule is indexed by the frame number, which counts the frames
+// produced since the producer started streaming.
+class LoadSchedule
+{
+public:
+
+    struct Segment
+    {
+        size_t from;
+        size_t to;
+        uint32_t frames;
+    };
+
+    // The start of a segment (other than the first) that changes the load.
+    struct Transition
+    {
+        uint32_t frame;
+
+        // The frame at which the next segment starts.
+        uint32_t end;
+
+        // The load of the frame before the transition, and that at the end of
+        // the segment.
+        size_t from;
+        size_t to;
+
+        bool ramp;
+    };
+
+    LoadSchedule()
+        : m_length(0)
+        , m_repeat(false)
+    {}
+
+    // Parses the schedule, logging an error and returning false if it is invalid.
+    bool Parse(const std::string& schedule);
+
+    bool Empty() const { return m_segments.empty(); }
+    bool Repeats() const { return m_repeat; }
+    const std::vector<Segment>& Segments() const { return m_segments; }
+
+    // The number of frames in one pass of the schedule.
+    uint32_t Length() const { return m_length; }
+
+    // The load of the given frame.
+    size_t Loops(uint32_t frame) const;
+
+    // The transitions that start before the given frame, including those of
+    // each pass when the schedule repeats.
+    std::vector<Transition> Transitions(uint32_t endFrame) const;
+
+private:
+
+    std::vector<Segment> m_segments;
+    uint32_t m_length;
+    bool m_repeat;
+};
+
+// Writes the schedule in the form that it is parsed from.
+std::ostream& operator<<(std::ostream& o, const LoadSchedule& schedule);
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+
+#include "LossAnalysis.h"
+#include "StageExport.h"
+
+const char* LossCauseName(LossCause cause)
+{
+    switch (cause)
+    {
+        case LOSS_CAUSE_PRODUCER: return "producer";
+        case LOSS_CAUSE_WIRE:     return "wire";
+        case LOSS_CAUSE_CONSUMER: return "consumer";
+        default:                  return "unknown";
+    }
+}
+
+template <typename T>
+static T Median(std::vector<T>& values)
+{
+    if (values.empty())
+        return T();
+    auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+LossAnalysis::LossAnalysis(const std::vector<std::shared_ptr<Frame>>& frames, const Microseconds& frameInterval)
+    : m_frames(frames)
+    , m_frameInterval(frameInterval)
+    , m_receivedMarker(MarkerEnabled(MARKER_FRAME_RECEIVED) ? MARKER_FRAME_RECEIVED : MARKER_COPIED_TO_GPU)
+    , m_typicalFramesInFlight(0)
+    , m_skippedFrames(0)
+    , m_repeatedFrames(0)
+    , m_skipBursts(MAX_BURST_LENGTH)
+    , m_repeatBursts(MAX_BURST_LENGTH)
+    , m_longestBurst(0)
+    , m_causes{}
+    , m_precedingStageTimes(StageRegistry::Markers().size())
+    , m_stageTimes(StageRegistry::Markers().size())
+{
+    // The typical scanout to receive delay and frames in flight are the medians
+    // so that the frames received while the consumer is behind do not skew them.
+    std::vector<Microseconds> delays;
+    std::vector<size_t> framesInFlight;
+    const auto& markers = StageRegistry::Markers();
+    for (const auto& f : frames)
+    {
+        if (f->Recorded(MARKER_SCANOUT_START) && f->Recorded(m_receivedMarker))
+            delays.push_back(std::chrono::duration_cast<Microseconds>(f->Time(m_receivedMarker) - f->Time(MARKER_SCANOUT_START)));
+        if (f->FramesInFlight())
+            framesInFlight.push_back(f->FramesInFlight());
+
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (f->StageMarkers(i, &start, &end))
+                m_stageTimes[i].Append(f->Elapsed(start, end));
+        }
+    }
+    m_typicalDelay = Median(delays);
+    m_typicalFramesInFlight = Median(framesInFlight);
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        const Frame& f = *frames[i];
+        if (i > 0 && f.Number() > frames[i - 1]->Number() + 1)
+        {
+            const Frame& previous = *frames[i - 1];
+            AddEvent(false, SkipCause(previous, f), f.Number() - previous.Number() - 1, i - 1);
+        }
+        if (f.DuplicateReceives())
+        {
+            const Frame* next = i + 1 < frames.size() ? frames[i + 1].get() : nullptr;
+            AddEvent(true, RepeatCause(f, next), f.DuplicateReceives(), i);
+        }
+    }
+}
+
+void LossAnalysis::AddEvent(bool repeat, LossCause cause, size_t frames, size_t preceding)
+{
+    const Frame& f = *m_frames[preceding];
+    TimePoint time = f.Time(m_receivedMarker);
+
+    LossEvent event;
+    event.repeat = repeat;
+    event.cause = cause;
+    event.frames = frames;
+    event.preceding = preceding;
+    event.interval = Microseconds(0);
+    if (m_events.size())
+    {
+        event.interval = std::chrono::duration_cast<Microseconds>(time - m_lastEventTime);
+        m_intervals.Append(event.interval);
+    }
+    m_events.push_back(event);
+    m_lastEventTime = time;
+
+    auto& bursts = repeat ? m_repeatBursts : m_skipBursts;
+    bursts[std::min(frames, MAX_BURST_LENGTH) - 1]++;
+    m_longestBurst = std::max(m_longestBurst, frames);
+    (repeat ? m_repeatedFrames : m_skippedFrames) += frames;
+    m_causes[cause]++;
+
+    const auto& markers = StageRegistry::Markers();
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        MarkerId start, end;
+        if (f.StageMarkers(i, &start, &end))
+            m_precedingStageTimes[i].Append(f.Elapsed(start, end));
+    }
+}
+
+float LossAnalysis::Span(const Frame& a, const Frame& b, MarkerId marker) const
+{
+    auto span = std::chrono::duration_cast<Microseconds>(b.Time(marker) - a.Time(marker));
+    return (float)span.count() / m_frameInterval.count();
+}
+
+bool LossAnalysis::ConsumerBehind(const Frame& frame) const
+{
+    if (frame.FramesInFlight() && frame.FramesInFlight() > m_typicalFramesInFlight + 1)
+        return true;
+    if (!frame.Recorded(MARKER_SCANOUT_START) || !frame.Recorded(m_receivedMarker))
+        return false;
+    auto delay = frame.Time(m_receivedMarker) - frame.Time(MARKER_SCANOUT_START);
+    return delay >= m_typicalDelay + m_frameInterval / 2;
+}
+
+LossCause LossAnalysis::SkipCause(const Frame& previous, const Frame& next) const
+{
+    if (!previous.Recorded(MARKER_SCANOUT_START) || !next.Recorded(MARKER_SCANOUT_START))
+        return LOSS_CAUSE_UNKNOWN;
+
+    // Each of the skipped frames should have had its own vsync between the
+    // frames on either side. If not, the producer replaced them before they
+    // were ever scanned out.
+    float expected = next.Number() - previous.Number();
+    if (Span(previous, next, MARKER_SCANOUT_START) < expected - 0.5f)
+        return LOSS_CAUSE_PRODUCER;
+
+    // The frames were scanned out, so they were either lost by a consumer that
+    // was too far behind to keep a buffer queued for them, or lost in transit.
+    if (ConsumerBehind(previous) || ConsumerBehind(next))
+        return LOSS_CAUSE_CONSUMER;
+    return LOSS_CAUSE_WIRE;
+}
+
+LossCause LossAnalysis::RepeatCause(const Frame& frame, const Frame* next) const
+{
+    if (!next || !frame.Recorded(MARKER_SCANOUT_START) || !next->Recorded(MARKER_SCANOUT_START))
+        return LOSS_CAUSE_UNKNOWN;
+
+    // A frame that stays on the output for an extra vsync for each repeat means
+    // the producer missed the vsync of the next frame.
+    float expected = next->Number() - frame.Number() + frame.DuplicateReceives();
+    if (Span(frame, *next, MARKER_SCANOUT_START) >= expected - 0.5f)
+        return LOSS_CAUSE_PRODUCER;
+
+    // Otherwise the frame was scanned out once but captured more than once,
+    // which a consumer queue that is behind does not cause.
+    return LOSS_CAUSE_WIRE;
+}
+
+void LossAnalysis::WriteEvents(std::ostream& o) const
+{
+    if (m_frames.empty())
+        return;
+
+    StageExport::WriteStageComment(o);
+    o << "Frame,Type,Frames,Cause,Interval";
+    StageExport::WriteStageLabels(o);
+    o << std::endl;
+
+    auto firstFrame = m_frames[0]->Number();
+    for (const auto& event : m_events)
+    {
+        const Frame& f = *m_frames[event.preceding];
+        o << (f.Number() - firstFrame) << ","
+          << (event.repeat ? "repeat" : "skip") << ","
+          << event.frames << ","
+          << LossCauseName(event.cause) << ","
+          << event.interval.count();
+        StageExport::WriteStageTimes(o, f);
+        o << std::endl;
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "Frame.h"
+
+// The point at which a loss event is attributed to have occurred.
+enum LossCause
+{
+    // The markers needed to attribute the event were not recorded.
+    LOSS_CAUSE_UNKNOWN,
+
+    // The producer did not scan out the frames at the expected vsync cadence:
+    // skipped frames were replaced before they reached a vsync, or a repeated
+    // frame stayed on the output because the next frame missed its vsync.
+    LOSS_CAUSE_PRODUCER,
+
+    // The producer scanned out the frames on time and the consumer was keeping
+    // up, but the frames were lost or repeated between the two.
+    LOSS_CAUSE_WIRE,
+
+    // The consumer had fallen behind (its capture queue was backed up) when the
+    // frames were lost, so they were likely dropped by an overflowing queue.
+    LOSS_CAUSE_CONSUMER,
+
+    LOSS_CAUSE_COUNT
+};
+
+const char* LossCauseName(LossCause cause);
+
+// A burst of frames that were either never received (skipped) or received
+// more than once (repeated).
+struct LossEvent
+{
+    bool repeat;
+    LossCause cause;
+
+    // The number of frames that were skipped or the number of extra times the
+    // frame was received.
+    size_t frames;
+
+    // The index (in the received frames) of the last frame received before
+    // the event. For a repeat this is the frame that was repeated.
+    size_t preceding;
+
+    // The time since the previous event, or zero for the first event.
+    Microseconds interval;
+};
+
+// Finds the bursts of skipped and repeated frames in the received frames and
+// attributes each of them to the producer, the wire or the consumer using
+// the scanout cadence and the consumer backlog around the event.
+class LossAnalysis
+{
+public:
+
+    LossAnalysis(const std::vector<std::shared_ptr<Frame>>& frames, const Microseconds& frameInterval);
+
+    const std::vector<LossEvent>& Events() const { return m_events; }
+
+    size_t SkippedFrames() const { return m_skippedFrames; }
+    size_t RepeatedFrames() const { return m_repeatedFrames; }
+
+    // The number of bursts of each length, indexed by length - 1, with the
+    // last entry counting every longer burst.
+    static constexpr size_t MAX_BURST_LENGTH = 8;
+    const std::vector<size_t>& SkipBursts() const { return m_skipBursts; }
+    const std::vector<size_t>& RepeatBursts() const { return m_repeatBursts; }
+    size_t LongestBurst() const { return m_longestBurst; }
+
+    // The number of events attributed to the given cause.
+    size_t Events(LossCause cause) const { return m_causes[cause]; }
+
+    // The times between successive events.
+    const DurationList& Intervals() const { return m_intervals; }
+
+    // The times of each stage (indexed as StageRegistry::Markers) for the frames
+    // received immediately before each event, and for all of the frames.
+    const std::vector<DurationList>& PrecedingStageTimes() const { return m_precedingStageTimes; }
+    const std::vector<DurationList>& StageTimes() const { return m_stageTimes; }
+
+    // Writes a CSV row for each event, followed by the stage times of the
+    // frame received immediately before it.
+    void WriteEvents(std::ostream& o) const;
+
+private:
+
+    void AddEvent(bool repeat, LossCause cause, size_t frames, size_t preceding);
+
+    LossCause SkipCause(const Frame& previous, const Frame& next) const;
+    LossCause RepeatCause(const Frame& frame, const Frame* next) const;
+
+    // Whether the consumer was behind when the given frame was received.
+    bool ConsumerBehind(const Frame& frame) const;
+
+    // The time between the same marker of two frames in frame intervals.
+    float Span(const Frame& a, const Frame& b, MarkerId marker) const;
+
+    const std::vector<std::shared_ptr<Frame>>& m_frames;
+    Microseconds m_frameInterval;
+
+    // The marker used as the time a frame was received. The frame received
+    // marker is not recorded when the instrumentation is off.
+    MarkerId m_receivedMarker;
+
+    // The median time from scanout until a frame is received, and the median
+    // number of frames in flight, while the consumer is keeping up.
+    Microseconds m_typicalDelay;
+    size_t m_typicalFramesInFlight;
+
+    std::vector<LossEvent> m_events;
+    size_t m_skippedFrames;
+    size_t m_repeatedFrames;
+    std::vector<size_t> m_skipBursts;
+    std::vector<size_t> m_repeatBursts;
+    size_t m_longestBurst;
+    size_t m_causes[LOSS_CAUSE_COUNT];
+    TimePoint m_lastEventTime;
+    DurationList m_intervals;
+    std::vector<DurationList> m_precedingStageTimes;
+    std::vector<DurationList> m_stageTimes;
+};
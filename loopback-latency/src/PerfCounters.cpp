@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iomanip>
+#include <sstream>
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "PerfCounters.h"
+
+namespace
+{
+
+struct CounterConfig
+{
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t CacheReadMiss(uint64_t cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const CounterConfig COUNTERS[PERF_COUNTER_COUNT] =
+{
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc-misses",    PERF_TYPE_HW_CACHE, CacheReadMiss(PERF_COUNT_HW_CACHE_LL) },
+    { "dtlb-misses",   PERF_TYPE_HW_CACHE, CacheReadMiss(PERF_COUNT_HW_CACHE_DTLB) },
+    { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+bool s_enabled = false;
+uint32_t s_probedCounters = 0;
+
+int OpenCounter(const CounterConfig& counter, int groupFd, bool excludeKernel)
+{
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = excludeKernel;
+    attr.exclude_hv = 1;
+    attr.pinned = (groupFd == -1);
+    return syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+// The counter group of a single thread, which is opened on first use and
+// closed when the thread exits.
+class CounterGroup
+{
+public:
+
+    CounterGroup()
+        : m_available(0)
+        , m_numOpen(0)
+    {
+        // Kernel time is included if permitted (e.g. to count the work done
+        // by a driver during a DMA ioctl), otherwise only user time is counted.
+        bool excludeKernel = false;
+        int leader = OpenCounter(COUNTERS[0], -1, excludeKernel);
+        if (leader < 0 && (errno == EACCES || errno == EPERM))
+        {
+            excludeKernel = true;
+            leader = OpenCounter(COUNTERS[0], -1, excludeKernel);
+        }
+        if (leader < 0)
+            return;
+
+        m_fds[m_numOpen] = leader;
+        m_counters[m_numOpen++] = PERF_CYCLES;
+        m_available |= 1u << PERF_CYCLES;
+        for (int i = 1; i < PERF_COUNTER_COUNT; i++)
+        {
+            int fd = OpenCounter(COUNTERS[i], leader, excludeKernel);
+            if (fd >= 0)
+            {
+                m_fds[m_numOpen] = fd;
+                m_counters[m_numOpen++] = (PerfCounter)i;
+                m_available |= 1u << i;
+            }
+        }
+    }
+
+    ~CounterGroup()
+    {
+        for (int i = 0; i < m_numOpen; i++)
+            close(m_fds[i]);
+    }
+
+    uint32_t Available() const { return m_available; }
+
+    bool Read(PerfSample* sample)
+    {
+        if (m_numOpen == 0)
+            return false;
+
+        // With PERF_FORMAT_GROUP, a read of the leader returns the number of
+        // counters followed by each value in the order the counters were opened.
+        uint64_t data[1 + PERF_COUNTER_COUNT];
+        ssize_t size = sizeof(uint64_t) * (1 + m_numOpen);
+        if (read(m_fds[0], data, size) != size)
+            return false;
+
+        for (int i = 0; i < m_numOpen; i++)
+            sample->values[m_counters[i]] = data[1 + i];
+        sample->available = m_available;
+        return true;
+    }
+
+private:
+
+    uint32_t m_available;
+    int m_numOpen;
+    int m_fds[PERF_COUNTER_COUNT];
+    PerfCounter m_counters[PERF_COUNTER_COUNT];
+};
+
+CounterGroup& ThreadCounterGroup()
+{
+    thread_local CounterGroup group;
+    return group;
+}
+
+} // anonymous namespace
+
+PerfSample PerfSample::Now()
+{
+    PerfSample sample;
+    if (s_enabled)
+        sample.valid = ThreadCounterGroup().Read(&sample);
+    return sample;
+}
+
+bool PerfSample::Enable(bool enable)
+{
+    s_enabled = enable;
+    if (enable)
+        s_probedCounters = ThreadCounterGroup().Available();
+    return !enable || s_probedCounters != 0;
+}
+
+bool PerfSample::Enabled()
+{
+    return s_enabled;
+}
+
+std::string PerfSample::AvailableCounters()
+{
+    std::ostringstream ss;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        if (s_probedCounters & (1u << i))
+            ss << (ss.tellp() ? ", " : "") << COUNTERS[i].name;
+    }
+    return ss.str();
+}
+
+const char* PerfSample::Name(PerfCounter counter)
+{
+    return COUNTERS[counter].name;
+}
+
+void PerfStatsList::Append(const PerfSample& start, const PerfSample& end)
+{
+    if (!start.valid || !end.valid)
+        return;
+
+    m_available &= start.available & end.available;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        m_totals[i] += end.values[i] - start.values[i];
+    m_count++;
+}
+
+uint64_t PerfStatsList::Avg(PerfCounter counter) const
+{
+    return m_count ? m_totals[counter] / m_count : 0;
+}
+
+float PerfStatsList::InstructionsPerCycle() const
+{
+    if (!Has(PERF_CYCLES) || !Has(PERF_INSTRUCTIONS) || m_totals[PERF_CYCLES] == 0)
+        return 0.0f;
+    return (float)m_totals[PERF_INSTRUCTIONS] / m_totals[PERF_CYCLES];
+}
+
+float PerfStatsList::MissesPerKiloInstruction(PerfCounter counter) const
+{
+    if (!Has(counter) || !Has(PERF_INSTRUCTIONS) || m_totals[PERF_INSTRUCTIONS] == 0)
+        return 0.0f;
+    return m_totals[counter] * 1000.0f / m_totals[PERF_INSTRUCTIONS];
+}
+
+std::string PerfStatsList::Summary(const std::string& indent) const
+{
+    if (m_count == 0)
+        return indent + "No counter samples\n";
+
+    std::ostringstream ss;
+    ss << indent << "Counters: cycles = " << Avg(PERF_CYCLES);
+    if (Has(PERF_INSTRUCTIONS))
+    {
+        ss << ", instructions = " << Avg(PERF_INSTRUCTIONS)
+           << std::fixed << std::setprecision(2) << ", IPC = " << InstructionsPerCycle();
+    }
+    ss << " per frame" << std::endl;
+
+    ss << indent << "Misses:   ";
+    bool first = true;
+    for (PerfCounter counter : { PERF_LLC_MISSES, PERF_DTLB_MISSES, PERF_BRANCH_MISSES })
+    {
+        if (!Has(counter))
+            continue;
+        ss << (first ? "" : ", ") << PerfSample::Name(counter) << " = " << Avg(counter);
+        if (Has(PERF_INSTRUCTIONS))
+            ss << " (" << std::fixed << std::setprecision(2) << MissesPerKiloInstruction(counter) << " MPKI)";
+        first = false;
+    }
+    if (first)
+        ss << "unavailable";
+    ss << std::endl;
+    return ss.str();
+}
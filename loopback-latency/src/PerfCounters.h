@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// The hardware counters that are sampled as a single group on each thread.
+enum PerfCounter
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+// A sample of the hardware performance counters of the calling thread.
+// The counters are opened with perf_event_open the first time each thread
+// is sampled; any counter that the CPU or kernel does not support is left
+// unavailable rather than failing the whole group.
+struct PerfSample
+{
+    PerfSample()
+        : valid(false)
+        , available(0)
+        , values()
+    {}
+
+    // Samples the calling thread. Returns an invalid sample if sampling is
+    // disabled or if no counters could be opened on this thread.
+    static PerfSample Now();
+
+    // Enables sampling and probes the counters on the calling thread.
+    // Returns false if none of the counters are available.
+    static bool Enable(bool enable);
+    static bool Enabled();
+
+    // The names of the counters that were available when probed.
+    static std::string AvailableCounters();
+
+    static const char* Name(PerfCounter counter);
+
+    bool Has(PerfCounter counter) const { return valid && (available & (1u << counter)); }
+
+    bool valid;
+    uint32_t available;
+    uint64_t values[PERF_COUNTER_COUNT];
+};
+
+// Accumulates the hardware counter deltas of a stage that starts and ends
+// on the same thread.
+class PerfStatsList
+{
+public:
+
+    PerfStatsList()
+        : m_count(0)
+        , m_available(~0u)
+        , m_totals()
+    {}
+
+    void Append(const PerfSample& start, const PerfSample& end);
+
+    size_t Size() const { return m_count; }
+    bool Has(PerfCounter counter) const { return m_count && (m_available & (1u << counter)); }
+
+    // The average counter value per stage instance.
+    uint64_t Avg(PerfCounter counter) const;
+
+    // Instructions per cycle, and misses per thousand instructions.
+    float InstructionsPerCycle() const;
+    float MissesPerKiloInstruction(PerfCounter counter) const;
+
+    std::string Summary(const std::string& indent) const;
+
+private:
+
+    size_t m_count;
+    uint32_t m_available;
+    uint64_t m_totals[PERF_COUNTER_COUNT];
+};
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iomanip>
+#include <sstream>
+
+#include "PhaseTimer.h"
+
+void PhaseTimer::Resume()
+{
+    m_last = Clock::now();
+}
+
+void PhaseTimer::Record(const std::string& name)
+{
+    TimePoint now = Clock::now();
+    m_phases.push_back({name, std::chrono::duration_cast<Microseconds>(now - m_last)});
+    m_last = now;
+}
+
+const std::vector<PhaseTimer::Phase>& PhaseTimer::Phases() const
+{
+    return m_phases;
+}
+
+Microseconds PhaseTimer::Total() const
+{
+    Microseconds total(0);
+    for (const auto& phase : m_phases)
+        total += phase.duration;
+    return total;
+}
+
+std::string PhaseTimer::Summary(const std::string& indent) const
+{
+    std::ostringstream ss;
+    for (const auto& phase : m_phases)
+    {
+        ss << indent << std::left << std::setw(28) << (phase.name + ":")
+           << std::right << std::setw(9) << phase.duration.count() << std::endl;
+    }
+    return ss.str();
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DurationList.h"
+
+// Measures the time taken by a sequence of named phases, such as the steps
+// taken by a producer or consumer during initialization.
+class PhaseTimer
+{
+public:
+
+    struct Phase
+    {
+        std::string name;
+        Microseconds duration;
+    };
+
+    // Starts (or continues) timing from now, such that any time since the
+    // last recorded phase is not included in the next phase.
+    void Resume();
+
+    // Ends the current phase and starts the next one.
+    void Record(const std::string& name);
+
+    const std::vector<Phase>& Phases() const;
+    Microseconds Total() const;
+    std::string Summary(const std::string& indent) const;
+
+private:
+
+    TimePoint m_last;
+    std::vector<Phase> m_phases;
+};
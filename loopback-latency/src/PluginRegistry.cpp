@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <dirent.h>
+#include <dlfcn.h>
+
+#include "PluginRegistry.h"
+#include "Console.h"
+
+namespace
+{
+
+std::vector<ProducerBackend> s_producers;
+std::vector<ConsumerBackend> s_consumers;
+
+template <typename Backend>
+void Register(std::vector<Backend>* backends, const Backend& backend, const char* kind)
+{
+    for (const auto& b : *backends)
+    {
+        if (b.name == backend.name)
+        {
+            Warning("Ignoring the " << kind << " '" << backend.name << "' that is already registered by another plugin.");
+            return;
+        }
+    }
+    backends->push_back(backend);
+}
+
+template <typename Backend>
+const Backend* Find(const std::vector<Backend>& backends, const std::string& name)
+{
+    auto it = std::find_if(backends.begin(), backends.end(),
+                           [&name](const Backend& b) { return b.name == name; });
+    return it != backends.end() ? &(*it) : nullptr;
+}
+
+void LoadPlugin(const std::string& path)
+{
+    // Plugins stay loaded for the lifetime of the process since the backends
+    // that they create may be used until exit.
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        Warning("Failed to load plugin " << path << ": " << dlerror());
+        return;
+    }
+
+    using VersionFunction = uint32_t (*)();
+    using RegisterFunction = void (*)();
+    auto version = (VersionFunction)dlsym(handle, "LoopbackLatencyPluginVersion");
+    auto registerBackends = (RegisterFunction)dlsym(handle, "LoopbackLatencyPluginRegister");
+    if (!version || !registerBackends)
+    {
+        Warning("Ignoring " << path << ", which is not a loopback-latency plugin.");
+        dlclose(handle);
+        return;
+    }
+    if (version() != PLUGIN_API_VERSION)
+    {
+        Warning("Ignoring plugin " << path << ", which was built for plugin API version " << version() <<
+                " (expected " << PLUGIN_API_VERSION << ").");
+        dlclose(handle);
+        return;
+    }
+
+    registerBackends();
+}
+
+} // anonymous namespace
+
+void PluginRegistry::Load(const std::string& searchPath)
+{
+    std::istringstream paths(searchPath);
+    std::string directory;
+    while (std::getline(paths, directory, ':'))
+    {
+        if (directory.empty())
+            continue;
+        DIR* dir = opendir(directory.c_str());
+        if (!dir)
+            continue;
+
+        // Load the plugins in a consistent order so that the first of any
+        // backends with the same name is always the one that is kept.
+        std::vector<std::string> files;
+        while (dirent* entry = readdir(dir))
+        {
+            std::string name(entry->d_name);
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".so") == 0)
+                files.push_back(directory + "/" + name);
+        }
+        closedir(dir);
+
+        std::sort(files.begin(), files.end());
+        for (const auto& file : files)
+            LoadPlugin(file);
+    }
+}
+
+void PluginRegistry::RegisterProducer(const ProducerBackend& backend)
+{
+    Register(&s_producers, backend, "producer");
+}
+
+void PluginRegistry::RegisterConsumer(const ConsumerBackend& backend)
+{
+    Register(&s_consumers, backend, "consumer");
+}
+
+const ProducerBackend* PluginRegistry::FindProducer(const std::string& name)
+{
+    return Find(s_producers, name);
+}
+
+const ConsumerBackend* PluginRegistry::FindConsumer(const std::string& name)
+{
+    return Find(s_consumers, name);
+}
+
+const std::vector<ProducerBackend>& PluginRegistry::Producers()
+{
+    return s_producers;
+}
+
+const std::vector<ConsumerBackend>& PluginRegistry::Consumers()
+{
+    return s_consumers;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Consumer.h"
+#include "Producer.h"
+
+// The version of the plugin interface. This is incremented whenever the
+// Producer, Consumer or plugin declarations change such that plugins built
+// against an earlier version can no longer be loaded.
+constexpr uint32_t PLUGIN_API_VERSION = 6;
+
+// An option of a plugin backend, given as -p.{name} or -c.{name} (or as the
+// name in the [producer] or [consumer] section of a scenario file).
+struct PluginOption
+{
+    std::string name;
+    std::string description;
+    std::string defaultValue;
+};
+
+// The parameters that a plugin backend is created with. The common options
+// are the same as those of the built-in backends, and the options map holds
+// the value (or default) of each option that the backend declares.
+struct PluginParams
+{
+    PluginParams()
+        : format(FORMAT_UNKNOWN)
+        , simulatedProcessing(0)
+        , rdma(false)
+    {}
+
+    TestFormat format;
+    size_t simulatedProcessing;
+    std::string device;
+    std::string channel;
+    bool rdma;
+    std::map<std::string, std::string> options;
+};
+
+struct ProducerBackend
+{
+    std::string name;
+    std::string description;
+    std::vector<PluginOption> options;
+
+    // The names of the interrupts used by the backend, whose affinities are
+    // included in the system audit (see SystemAudit).
+    std::vector<std::string> irqDevices;
+
+    std::function<Producer*(const PluginParams& params)> create;
+};
+
+struct ConsumerBackend
+{
+    std::string name;
+    std::string description;
+    std::vector<PluginOption> options;
+    std::vector<std::string> irqDevices;
+
+    std::function<Consumer*(std::shared_ptr<Producer> producer, const PluginParams& params)> create;
+};
+
+// The producer and consumer backends that are loaded from plugins. A plugin is
+// a shared object that is built against these headers and defines its entry
+// points with LOOPBACK_LATENCY_PLUGIN, which registers its backends when it is
+// loaded. Plugin backends are created and measured exactly like the built-in
+// backends, so they must follow the same Producer and Consumer contracts
+// (e.g. recording the core markers of each frame at the same points).
+class PluginRegistry
+{
+public:
+
+    // Loads every plugin (*.so) in the directories of the given colon-separated
+    // search path. Plugins that cannot be loaded are reported and skipped.
+    static void Load(const std::string& searchPath);
+
+    // Called by the plugin entry points.
+    static void RegisterProducer(const ProducerBackend& backend);
+    static void RegisterConsumer(const ConsumerBackend& backend);
+
+    // Returns the backend with the given name, or null if there is none.
+    static const ProducerBackend* FindProducer(const std::string& name);
+    static const ConsumerBackend* FindConsumer(const std::string& name);
+
+    static const std::vector<ProducerBackend>& Producers();
+    static const std::vector<ConsumerBackend>& Consumers();
+};
+
+// Defines the entry points of a plugin, where the given function registers
+// the backends of the plugin with PluginRegistry.
+#define LOOPBACK_LATENCY_PLUGIN(registerBackends) \
+    extern "C" uint32_t LoopbackLatencyPluginVersion() { return PLUGIN_API_VERSION; } \
+    extern "C" void LoopbackLatencyPluginRegister() { registerBackends(); }
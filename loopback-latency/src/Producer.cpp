@@ -21,15 +21,18 @@
  */
 
 #include "Producer.h"
-#include "Console.h"
-
-#define DEBUG_FRAMES 0
+#include "AsyncLog.h"
+#include "CudaUtils.h"
 
 Producer::Producer(const TestFormat& format, size_t simulatedProcessing)
     : m_format(format)
     , m_simulatedProcessing(simulatedProcessing)
+    , m_codec(GetFrameCodec(format.pixelFormat))
     , m_streaming(false)
+    , m_vsync(true)
     , m_currentFrame(0)
+    , m_keepProducedFrames(false)
+    , m_firstScanout(0)
 {
 }
 
@@ -46,6 +49,11 @@ const TestFormat& Producer::Format() const
 
 bool Producer::StartStreaming()
 {
+    m_framesMutex.lock();
+    m_lastFrame.reset();
+    m_framesMutex.unlock();
+    m_firstScanout = 0;
+
     m_streaming = true;
     m_streamThread = std::thread(StreamThreadStatic, this);
 
@@ -63,41 +71,89 @@ bool Producer::IsStreaming() const
     return m_streaming;
 }
 
+const PhaseTimer& Producer::StartupPhases() const
+{
+    return m_startupPhases;
+}
+
+TimePoint Producer::FirstFrameTime() const
+{
+    Clock::rep firstScanout = m_firstScanout;
+    return firstScanout ? TimePoint(Clock::duration(firstScanout)) : TimePoint();
+}
+
+size_t Producer::FramesInFlight() const
+{
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    return m_frames.size();
+}
+
+void Producer::SetVsync(bool vsync)
+{
+    m_vsync = vsync;
+}
+
+bool Producer::Vsync() const
+{
+    return m_vsync || !CanDisableVsync();
+}
+
+bool Producer::CanDisableVsync() const
+{
+    return false;
+}
+
+void Producer::SetKeepProducedFrames(bool keep)
+{
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    m_keepProducedFrames = keep;
+    if (keep)
+        m_producedFrames.clear();
+}
+
+std::vector<std::shared_ptr<Frame>> Producer::ProducedFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    return m_producedFrames;
+}
+
+std::shared_ptr<Frame> Producer::IdentifyCapture(const void* ptr, const DriverCapture& driver)
+{
+    return GetFrame(ptr);
+}
+
+FrameId Producer::ReadFrameId(const void* ptr) const
+{
+    // The frame is a solid color, so the ID is read from the first pixel (and
+    // for subsampled formats, the chroma values that apply to it).
+    return m_codec.decode((const uint8_t*)ptr, m_format);
+}
+
 std::shared_ptr<Frame> Producer::GetFrame(const void* ptr)
 {
-    // Determine the color of the buffer being looked up.
-    uint8_t r = ((uint8_t*)ptr)[0];
-    uint8_t g = ((uint8_t*)ptr)[1];
-    uint8_t b = ((uint8_t*)ptr)[2];
+    FrameId id(ReadFrameId(ptr));
 
     std::lock_guard<std::mutex> lock(m_framesMutex);
-#if DEBUG_FRAMES
-    Log("Received frame: " << (int)r << ", " << (int)g << ", " << (int)b);
-#endif
-    for (auto it = m_frames.begin(); it != m_frames.end();)
+    if constexpr (INSTRUMENTATION >= INSTRUMENTATION_TRACE)
+    {
+        LogAsync("Received frame: ", (int)id[0], ", ", (int)id[1], ", ", (int)id[2]);
+    }
+    for (auto it = m_frames.begin(); it != m_frames.end(); ++it)
     {
         // Allow a fuzzy compare of the color to account for minor color differences.
-        if (FuzzyMatch(*it, r, g, b, 1))
-        {
-            // Return the frame if it matches.
-            return *it;
-        }
-        else
+        if (FuzzyMatch((*it)->Id(m_format.pixelFormat), id, 1))
         {
-            // If it doesn't match, we assume that we received a later frame so
-            // we remove this frame from the list so its color can be reused.
-            it = m_frames.erase(it);
+            // Since a later frame was received, the frames before it will never
+            // be received, so they are removed from the list so that their colors
+            // can be reused. Nothing is removed if no frame matches, so that a
+            // buffer that does not identify a frame (e.g. a black frame during a
+            // mode switch) does not discard the frames that are still in flight.
+            auto frame = *it;
+            m_frames.erase(m_frames.begin(), it);
+            return frame;
         }
     }
 
-    Error("Could not find frame color (" << (int)r << "," << (int)g << "," << (int)b <<
-          ") in producer records." << std::endl <<
-          "This means that the consumer received a frame color that was never" << std::endl <<
-          "generated by the producer. This could be caused by a general producer" << std::endl <<
-          "and/or consumer error, but it could also be caused by the loopback" << std::endl <<
-          "cable not being connected properly to the required device ports." << std::endl <<
-          "Please check the cable connections and try again.");
-
     return std::shared_ptr<Frame>(nullptr);
 }
 
@@ -105,19 +161,81 @@ std::shared_ptr<Frame> Producer::StartFrame()
 {
     auto frame(std::make_shared<Frame>(m_currentFrame++));
     std::lock_guard<std::mutex> lock(m_framesMutex);
-#if DEBUG_FRAMES
-    Log("Starting frame: " << (int)frame->R() << ", " << (int)frame->G() << ", " << (int)frame->B());
-#endif
+    if constexpr (INSTRUMENTATION >= INSTRUMENTATION_TRACE)
+    {
+        FrameId id(frame->Id(m_format.pixelFormat));
+        LogAsync("Starting frame: ", (int)id[0], ", ", (int)id[1], ", ", (int)id[2]);
+    }
+    if (m_frames.size() == MAX_FRAMES_IN_FLIGHT)
+        m_frames.pop_front();
     m_frames.push_back(frame);
+    if (m_keepProducedFrames && m_lastFrame && m_producedFrames.size() < MAX_PRODUCED_FRAMES)
+        m_producedFrames.push_back(m_lastFrame);
+    m_lastFrame = frame;
     return frame;
 }
 
-bool Producer::FuzzyMatch(const std::shared_ptr<Frame>& frame,
-        uint8_t r, uint8_t g, uint8_t b, uint8_t threshold)
+void Producer::RecordScanout(Frame& frame)
+{
+    frame.Record(MARKER_SCANOUT_START);
+    Clock::rep none = 0;
+    m_firstScanout.compare_exchange_strong(none, frame.Time(MARKER_SCANOUT_START).time_since_epoch().count());
+}
+
+FramePattern Producer::Pattern(const Frame& frame) const
+{
+    return m_codec.encode(frame.Id(m_format.pixelFormat), m_format);
+}
+
+void Producer::SetContent(ContentType type, uint32_t seed, const std::string& tileFilename)
+{
+    m_content.Configure(type, seed, tileFilename);
+}
+
+ContentType Producer::Content() const
+{
+    return m_content.Type();
+}
+
+void Producer::SetLoadSchedule(const LoadSchedule& schedule)
+{
+    m_loadSchedule = schedule;
+}
+
+const LoadSchedule& Producer::Schedule() const
+{
+    return m_loadSchedule;
+}
+
+size_t Producer::SimulatedProcessing(const Frame& frame) const
+{
+    if (m_loadSchedule.Empty())
+        return m_simulatedProcessing;
+    return m_loadSchedule.Loops(frame.Number());
+}
+
+bool Producer::InitializeContent(bool host)
+{
+    return m_content.Initialize(m_format, host);
+}
+
+void Producer::RenderFrame(const Frame& frame, void* cudaBuffer) const
+{
+    CudaWritePattern(cudaBuffer, m_content.IdPattern(Pattern(frame)));
+    m_content.WriteDevice(cudaBuffer, frame.Number());
+}
+
+void Producer::RenderFrameHost(const Frame& frame, void* buffer)
+{
+    WritePattern(buffer, m_content.IdPattern(Pattern(frame)));
+    m_content.WriteHost(buffer, frame.Number());
+}
+
+bool Producer::FuzzyMatch(const FrameId& a, const FrameId& b, uint8_t threshold)
 {
-    return (std::abs(frame->R() - r) <= threshold &&
-            std::abs(frame->G() - g) <= threshold &&
-            std::abs(frame->B() - b) <= threshold);
+    return (std::abs(a[0] - b[0]) <= threshold &&
+            std::abs(a[1] - b[1]) <= threshold &&
+            std::abs(a[2] - b[2]) <= threshold);
 }
 
 void Producer::StreamThreadStatic(Producer* producer)
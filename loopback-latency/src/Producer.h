@@ -22,14 +22,37 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "TestFormat.h"
 #include "Frame.h"
+#include "FrameContent.h"
+#include "LoadSchedule.h"
+#include "PhaseTimer.h"
+
+// What the capture driver reported about a captured buffer, if anything.
+struct DriverCapture
+{
+    DriverCapture()
+        : hasSequence(false)
+        , sequence(0)
+    {}
+
+    // The sequence number that the driver gave the buffer, which skips the
+    // numbers of any frames that it dropped.
+    bool hasSequence;
+    uint64_t sequence;
+
+    // The time that the driver captured the buffer, or a default TimePoint if
+    // the driver does not give a timestamp on the steady clock.
+    TimePoint time;
+};
 
 class Producer
 {
@@ -45,33 +68,129 @@ public:
     virtual void StopStreaming();
 
     bool IsStreaming() const;
+
+    // Returns the produced frame that the captured buffer identifies, or null
+    // if the buffer does not identify a frame that is in flight.
     std::shared_ptr<Frame> GetFrame(const void* ptr);
 
+    // Returns the frame that a captured buffer holds, given what the capture
+    // driver reported about it. This is the produced frame that the buffer
+    // identifies (see GetFrame), other than for an external source.
+    virtual std::shared_ptr<Frame> IdentifyCapture(const void* ptr, const DriverCapture& driver);
+
+    // The ID read from the first pixel of a captured buffer.
+    FrameId ReadFrameId(const void* ptr) const;
+
+    // The contents of the given frame in the producer format, without any
+    // content other than the frame color.
+    FramePattern Pattern(const Frame& frame) const;
+
+    // Sets the content that is written to each frame (see FrameContent). This
+    // must be set before the producer is initialized.
+    void SetContent(ContentType type, uint32_t seed, const std::string& tileFilename);
+    ContentType Content() const;
+
+    // Sets the schedule that varies the simulated processing of each frame,
+    // replacing the constant amount that the producer was created with. This
+    // must be set before streaming is started.
+    void SetLoadSchedule(const LoadSchedule& schedule);
+    const LoadSchedule& Schedule() const;
+
+    // Writes the complete frame (the frame color and content) to a GPU buffer.
+    void RenderFrame(const Frame& frame, void* cudaBuffer) const;
+
+    // The time taken by each phase of the producer startup.
+    const PhaseTimer& StartupPhases() const;
+
+    // The scanout time of the first frame produced since streaming was last
+    // started, or a default TimePoint if no frame has been scanned out yet.
+    TimePoint FirstFrameTime() const;
+
+    // The number of frames that have been produced but not yet received.
+    size_t FramesInFlight() const;
+
+    // Sets whether the producer waits for the vsync of its output between
+    // frames. Producers that are paced by their output always wait (see
+    // CanDisableVsync). This must be set before streaming is started.
+    void SetVsync(bool vsync);
+    bool Vsync() const;
+    virtual bool CanDisableVsync() const;
+
+    // Keeps the frames that the producer completes, up to MAX_PRODUCED_FRAMES,
+    // so that the producer can be measured without a consumer. Keeping the
+    // frames again clears those kept before.
+    void SetKeepProducedFrames(bool keep);
+
+    // The frames completed while they were kept, in the order produced. A
+    // frame is complete once the producer starts the next one.
+    std::vector<std::shared_ptr<Frame>> ProducedFrames() const;
+
 protected:
 
     Producer(const TestFormat& format, size_t simulatedProcessing);
 
     std::shared_ptr<Frame> StartFrame();
 
+    // Records the scanout marker of a frame, which also publishes the time of
+    // the first scanout since streaming was started (see FirstFrameTime).
+    void RecordScanout(Frame& frame);
+
+    // Initializes the frame content, which also starts the threads that write
+    // the content of host buffers if host is true. Called by the producers
+    // during initialization.
+    bool InitializeContent(bool host);
+
+    // Writes the complete frame to a host buffer. This requires the content to
+    // be initialized for host buffers.
+    void RenderFrameHost(const Frame& frame, void* buffer);
+
+    // The amount of simulated processing (in CUDA loops) to add to the frame.
+    size_t SimulatedProcessing(const Frame& frame) const;
+
     virtual void StreamThread() = 0;
     virtual std::ostream& Dump(std::ostream& o) const = 0;
 
     TestFormat m_format;
     size_t m_simulatedProcessing;
 
+    PhaseTimer m_startupPhases;
+
 private:
 
-    static bool FuzzyMatch(const std::shared_ptr<Frame>& frame,
-            uint8_t r, uint8_t g, uint8_t b, uint8_t threshold);
+    FrameContent m_content;
+    LoadSchedule m_loadSchedule;
+
+    // The encode and decode functions of the producer format.
+    const FrameCodec m_codec;
+
+    static bool FuzzyMatch(const FrameId& a, const FrameId& b, uint8_t threshold);
+
+    // The number of distinct frame IDs (see Frame), which bounds the frames
+    // that are kept in flight when none are received (e.g. with no consumer,
+    // or between the runs of the daemon mode) since older frames could no
+    // longer be told apart from newer ones with the same ID.
+    static constexpr size_t MAX_FRAMES_IN_FLIGHT = 4096;
+
+    // The most frames that are kept by SetKeepProducedFrames, which bounds
+    // the memory used when the vsync is disabled.
+    static constexpr size_t MAX_PRODUCED_FRAMES = 65536;
 
     static void StreamThreadStatic(Producer* producer);
 
     bool m_streaming;
+    bool m_vsync;
     std::thread m_streamThread;
 
     uint32_t m_currentFrame;
     std::list<std::shared_ptr<Frame>> m_frames;
-    std::mutex m_framesMutex;
+    std::shared_ptr<Frame> m_lastFrame;
+    bool m_keepProducedFrames;
+    std::vector<std::shared_ptr<Frame>> m_producedFrames;
+    mutable std::mutex m_framesMutex;
+
+    // The first scanout time as a count of Clock ticks (0 if none), which is
+    // written by the stream thread and polled from other threads.
+    std::atomic<Clock::rep> m_firstScanout;
 
     friend std::ostream& operator<<(std::ostream& o, const Producer& p);
 };
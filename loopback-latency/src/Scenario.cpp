@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+
+#include "Scenario.h"
+#include "Console.h"
+
+namespace
+{
+
+// The prefix of a threshold that is the minimum rather than the maximum value
+// of its metric.
+const std::string MIN_PREFIX = "min.";
+
+// Maps the "section.key" names that can be used in a scenario file to
+// their equivalent command line options.
+const std::vector<std::pair<std::string, std::string>> SCENARIO_OPTIONS =
+{
+    { "run.format",             "-f" },
+    { "run.frames",             "-n" },
+    { "run.warmup",             "-w" },
+    { "run.simulated",          "-s" },
+    { "run.load",               "--load" },
+    { "run.load-budget",        "--load-budget" },
+    { "run.load-output",        "--load-output" },
+    { "run.output",             "-o" },
+    { "run.trace",              "--trace" },
+    { "run.loss-events",        "--loss-events" },
+    { "run.restarts",           "--restarts" },
+    { "run.tune",               "--tune" },
+    { "run.cpu-stats",          "--cpu-stats" },
+    { "run.perf-counters",      "--perf-counters" },
+    { "run.flight-recorder",    "--flight-recorder" },
+    { "run.flight-threshold",   "--flight-threshold" },
+    { "run.flight-window",      "--flight-window" },
+    { "run.plugin-path",        "--plugin-path" },
+    { "run.ramp",               "--ramp" },
+    { "run.ramp-predict",       "--ramp-predict" },
+    { "run.ramp-output",        "--ramp-output" },
+    { "producer.type",          "-p" },
+    { "producer.device",        "-p.device" },
+    { "producer.channel",       "-p.channel" },
+    { "producer.rdma",          "-p.rdma" },
+    { "producer.time",          "-p.time" },
+    { "producer.content",       "-p.content" },
+    { "producer.content-seed",  "-p.content-seed" },
+    { "producer.content-tile",  "-p.content-tile" },
+    { "producer.decode-id",     "-p.decode-id" },
+    { "consumer.type",          "-c" },
+    { "consumer.device",        "-c.device" },
+    { "consumer.channel",       "-c.channel" },
+    { "consumer.rdma",          "-c.rdma" },
+    { "consumer.convert",       "-c.convert" },
+    { "consumer.verify",        "-c.verify" },
+    { "consumer.resilient",     "-c.resilient" },
+    { "consumer.max-glitch",    "-c.max-glitch" },
+    { "consumer.snapshots",     "-c.snapshots" },
+};
+
+std::string Trim(const std::string& str)
+{
+    const char* whitespace = " \t\r\n";
+    size_t first = str.find_first_not_of(whitespace);
+    if (first == std::string::npos)
+        return "";
+    size_t last = str.find_last_not_of(whitespace);
+    return str.substr(first, last - first + 1);
+}
+
+// Returns the position of the comment in a line, or npos if there is none. A
+// comment starts with # or ; at the start of the line or after whitespace,
+// so that values may contain these characters (e.g. paths or pipelines).
+size_t CommentStart(const std::string& line)
+{
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        if ((line[i] == '#' || line[i] == ';') && (i == 0 || isspace((unsigned char)line[i - 1])))
+            return i;
+    }
+    return std::string::npos;
+}
+
+}
+
+bool Scenario::Load(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        Error("Could not open scenario file: " << filename);
+        return false;
+    }
+
+    // A scenario replaces any that was loaded before (e.g. by the options of
+    // the daemon that a request is parsed on top of).
+    m_filename = filename;
+    m_name.clear();
+    m_arguments.clear();
+    m_thresholds.clear();
+
+    std::string section;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        // Strip comments and whitespace, skipping empty lines.
+        size_t comment = CommentStart(line);
+        if (comment != std::string::npos)
+            line.erase(comment);
+        line = Trim(line);
+        if (line.empty())
+            continue;
+
+        // Section headers.
+        if (line.front() == '[')
+        {
+            if (line.back() != ']')
+            {
+                Error(filename << ":" << lineNumber << ": Invalid section header: " << line);
+                return false;
+            }
+            section = Trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        // Key/value pairs, where the value may optionally be quoted.
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            Error(filename << ":" << lineNumber << ": Expected 'key = value': " << line);
+            return false;
+        }
+        std::string key = Trim(line.substr(0, equals));
+        std::string value = Trim(line.substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            value = value.substr(1, value.size() - 2);
+
+        if (!SetValue(section, key, value))
+        {
+            Error(filename << ":" << lineNumber << ": Invalid entry '" << key <<
+                  "' in section [" << section << "]");
+            return false;
+        }
+    }
+
+    // Default the name to the file name without its path or extension.
+    if (m_name.empty())
+    {
+        m_name = filename.substr(filename.find_last_of('/') + 1);
+        m_name = m_name.substr(0, m_name.find_last_of('.'));
+    }
+
+    return true;
+}
+
+bool Scenario::SetValue(const std::string& section, const std::string& key, const std::string& value)
+{
+    if (section == "scenario")
+    {
+        if (key != "name")
+            return false;
+        m_name = value;
+        return true;
+    }
+
+    if (section == "thresholds")
+    {
+        char* end = nullptr;
+        int64_t limit = strtoll(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0')
+            return false;
+        m_thresholds[key] = limit;
+        return true;
+    }
+
+    const std::string name(section + "." + key);
+    for (const auto& option : SCENARIO_OPTIONS)
+    {
+        if (option.first == name)
+        {
+            m_arguments.push_back(option.second);
+            m_arguments.push_back(value);
+            return true;
+        }
+    }
+
+    // Any other producer or consumer entry is an option of a plugin backend,
+    // which is checked once the plugins have been loaded.
+    if (section == "producer" || section == "consumer")
+    {
+        m_arguments.push_back(std::string(section == "producer" ? "-p." : "-c.") + key);
+        m_arguments.push_back(value);
+        return true;
+    }
+
+    return false;
+}
+
+const std::string& Scenario::Name() const
+{
+    return m_name;
+}
+
+const std::string& Scenario::Filename() const
+{
+    return m_filename;
+}
+
+const std::vector<std::string>& Scenario::Arguments() const
+{
+    return m_arguments;
+}
+
+bool Scenario::HasThresholds() const
+{
+    return !m_thresholds.empty();
+}
+
+bool Scenario::CheckThresholds(const Metrics& metrics) const
+{
+    Log("Scenario Thresholds (" << m_name << ")" << std::endl <<
+        "=========================================================");
+
+    bool passed = true;
+    for (const auto& threshold : m_thresholds)
+    {
+        bool minimum = threshold.first.compare(0, MIN_PREFIX.size(), MIN_PREFIX) == 0;
+        auto metric = metrics.find(minimum ? threshold.first.substr(MIN_PREFIX.size()) : threshold.first);
+        if (metric == metrics.end())
+        {
+            Log(ErrorColor("   FAIL  " << std::left << std::setw(22) << threshold.first <<
+                           "(metric was not measured)"));
+            passed = false;
+        }
+        else if (minimum ? metric->second < threshold.second : metric->second > threshold.second)
+        {
+            Log(ErrorColor("   FAIL  " << std::left << std::setw(22) << threshold.first <<
+                           std::right << std::setw(8) << metric->second << (minimum ? " < " : " > ") <<
+                           threshold.second));
+            passed = false;
+        }
+        else
+        {
+            Log(SuccessColor("   PASS  " << std::left << std::setw(22) << threshold.first <<
+                             std::right << std::setw(8) << metric->second << (minimum ? " >= " : " <= ") <<
+                             threshold.second));
+        }
+    }
+    Log("");
+
+    return passed;
+}
+
+uint64_t Scenario::Hash(const std::string& str)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : str)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void Scenario::Usage(std::ostream& o)
+{
+    o << "  [scenario]   name" << std::endl;
+    for (const auto& option : SCENARIO_OPTIONS)
+    {
+        size_t dot = option.first.find('.');
+        o << "  [" << option.first.substr(0, dot) << "]" <<
+             std::string(11 - dot, ' ') << std::left << std::setw(16) <<
+             option.first.substr(dot + 1) << "(" << option.second << ")" << std::endl;
+    }
+    o << "  [producer]   {plugin option} (-p.{option})" << std::endl;
+    o << "  [consumer]   {plugin option} (-c.{option})" << std::endl;
+    o << std::right << "  [thresholds] {metric} = {max value}" << std::endl;
+    o << "  [thresholds] min.{metric} = {min value}" << std::endl;
+}
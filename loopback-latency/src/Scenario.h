@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Named values produced by a measurement (e.g. "total.max") that can be
+// checked against the thresholds given by a scenario.
+using Metrics = std::map<std::string, int64_t>;
+
+// A scenario is an INI-style file that describes a complete measurement
+// (producer, consumer, format, workload, frame counts) along with the
+// pass/fail thresholds that the results must meet. For example:
+//
+//   [scenario]
+//   name = aja-1080-rdma
+//
+//   [run]
+//   format = 1080
+//   frames = 600
+//
+//   [producer]
+//   type = aja
+//   rdma = 1
+//
+//   [consumer]
+//   type = aja
+//
+//   [thresholds]
+//   total.max = 40000
+//   skipped = 0
+//   min.capture.decoded = 600
+//
+// A threshold is the maximum value of the metric, or its minimum value if the
+// metric is given with a "min." prefix (for metrics where higher is better,
+// such as frame rates). Every key outside of the [scenario] and [thresholds] sections maps to a
+// command line option, so a scenario is simply a version-controllable form
+// of the command line that also knows how to judge its results.
+class Scenario
+{
+public:
+
+    bool Load(const std::string& filename);
+
+    const std::string& Name() const;
+    const std::string& Filename() const;
+
+    // Returns the command line arguments that are equivalent to the file.
+    const std::vector<std::string>& Arguments() const;
+
+    bool HasThresholds() const;
+    bool CheckThresholds(const Metrics& metrics) const;
+
+    // Returns the 64-bit FNV-1a hash of the given string.
+    static uint64_t Hash(const std::string& str);
+
+    static void Usage(std::ostream& o);
+
+private:
+
+    bool SetValue(const std::string& section, const std::string& key, const std::string& value);
+
+    std::string m_filename;
+    std::string m_name;
+    std::vector<std::string> m_arguments;
+    std::map<std::string, int64_t> m_thresholds;
+};
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <fstream>
+
+#include "StageExport.h"
+#include "Console.h"
+
+namespace StageExport
+{
+
+void WriteStageComment(std::ostream& o)
+{
+    const auto& markers = StageRegistry::Markers();
+    o << "# stages=";
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        o << (i > 1 ? "," : "") << markers[i].metric << ":" << StageRegistry::SideName(markers[i].side);
+    }
+    o << std::endl;
+}
+
+void WriteStageLabels(std::ostream& o)
+{
+    const auto& markers = StageRegistry::Markers();
+    for (size_t i = 1; i < markers.size(); i++)
+        o << "," << markers[i].label;
+}
+
+void WriteStageTimes(std::ostream& o, const Frame& frame)
+{
+    const auto& markers = StageRegistry::Markers();
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        MarkerId start, end;
+        o << ",";
+        if (frame.StageMarkers(i, &start, &end))
+            o << frame.Elapsed(start, end).count();
+    }
+}
+
+bool WriteTrace(const std::string& filename, const std::vector<std::shared_ptr<Frame>>& frames)
+{
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+        Error("Could not open trace file: " << filename);
+        return false;
+    }
+
+    // Each side is shown as a separate track.
+    file << "{\"traceEvents\":[" << std::endl;
+    for (StageSide side : { STAGE_PRODUCER, STAGE_OUTPUT, STAGE_TRANSFER, STAGE_CONSUMER, STAGE_TOOL })
+    {
+        file << (side == STAGE_PRODUCER ? "" : ",\n")
+             << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << side << ",\"name\":\"thread_name\","
+             << "\"args\":{\"name\":\"" << StageRegistry::SideName(side) << "\"}}";
+    }
+
+    const auto& markers = StageRegistry::Markers();
+    for (const auto& f : frames)
+    {
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (!f->StageMarkers(i, &start, &end))
+                continue;
+
+            auto ts = std::chrono::duration_cast<Microseconds>(f->Time(start).time_since_epoch());
+            file << ",\n"
+                 << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << markers[i].side
+                 << ",\"name\":\"" << markers[i].label << "\""
+                 << ",\"ts\":" << ts.count()
+                 << ",\"dur\":" << f->Elapsed(start, end).count()
+                 << ",\"args\":{\"frame\":" << f->Number() << "}}";
+        }
+    }
+    file << std::endl << "]}" << std::endl;
+    return true;
+}
+
+} // namespace StageExport
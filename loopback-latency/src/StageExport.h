@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Frame.h"
+
+// Writes the stages of each frame as derived from the StageRegistry.
+namespace StageExport
+{
+
+// Writes a "# stages=" comment line that gives the metric name and side of
+// each stage column, in column order, for tools that process the CSV output.
+void WriteStageComment(std::ostream& o);
+
+// Writes a comma followed by the label of each stage.
+void WriteStageLabels(std::ostream& o);
+
+// Writes a comma followed by the duration of each stage in microseconds,
+// or an empty value if the stage was not recorded for the frame.
+void WriteStageTimes(std::ostream& o, const Frame& frame);
+
+// Writes the stages of every frame to a Chrome trace event (JSON) file,
+// which can be viewed with chrome://tracing or https://ui.perfetto.dev.
+bool WriteTrace(const std::string& filename, const std::vector<std::shared_ptr<Frame>>& frames);
+
+} // namespace StageExport
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <mutex>
+
+#include "StageRegistry.h"
+
+namespace
+{
+
+std::vector<Marker> s_markers =
+{
+    { MARKER_PROCESSING_START, "processing-start", "",                "",             STAGE_PRODUCER },
+    { MARKER_RENDER_START,     "render-start",     "CUDA Processing", "process",      STAGE_PRODUCER },
+    { MARKER_RENDER_END,       "render-end",       "Render on GPU",   "render",       STAGE_PRODUCER },
+    { MARKER_COPIED_FROM_GPU,  "copied-from-gpu",  "Copy To Host",    "copy-to-host", STAGE_PRODUCER },
+    { MARKER_WRITE_END,        "write-end",        "Write To HW",     "write",        STAGE_PRODUCER },
+    { MARKER_SCANOUT_START,    "scanout-start",    "Vsync Wait",      "vsync",        STAGE_OUTPUT },
+    { MARKER_FRAME_RECEIVED,   "frame-received",   "Wire Time",       "wire",         STAGE_TRANSFER },
+    { MARKER_READ_END,         "read-end",         "Read From HW",    "read",         STAGE_CONSUMER },
+    { MARKER_COPIED_TO_GPU,    "copied-to-gpu",    "Copy To GPU",     "copy-to-gpu",  STAGE_CONSUMER },
+};
+
+// The producer and consumer may be initialized at the same time.
+std::mutex s_mutex;
+
+} // anonymous namespace
+
+MarkerId StageRegistry::Register(const std::string& name, const std::string& label,
+                                 const std::string& metric, StageSide side, MarkerId after)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (const auto& marker : s_markers)
+    {
+        if (marker.name == name)
+            return marker.id;
+    }
+
+    if (s_markers.size() == MAX_MARKERS)
+        return MAX_MARKERS;
+
+    auto it = std::find_if(s_markers.begin(), s_markers.end(),
+                           [after](const Marker& m) { return m.id == after; });
+    if (it != s_markers.end())
+        it++;
+
+    MarkerId id = s_markers.size();
+    s_markers.insert(it, { id, name, label, metric, side });
+    return id;
+}
+
+const std::vector<Marker>& StageRegistry::Markers()
+{
+    return s_markers;
+}
+
+const char* StageRegistry::SideName(StageSide side)
+{
+    switch (side)
+    {
+        case STAGE_PRODUCER: return "producer";
+        case STAGE_CONSUMER: return "consumer";
+        case STAGE_OUTPUT:   return "output";
+        case STAGE_TRANSFER: return "transfer";
+        case STAGE_TOOL:     return "tool";
+        default:             return "unknown";
+    }
+}
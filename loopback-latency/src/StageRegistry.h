@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using MarkerId = uint8_t;
+
+// The maximum number of markers, which is the number of timestamp slots
+// that are allocated for each frame.
+constexpr size_t MAX_MARKERS = 16;
+
+// The markers that are recorded by every producer and consumer.
+enum CoreMarker : MarkerId
+{
+    MARKER_PROCESSING_START,
+    MARKER_RENDER_START,
+    MARKER_RENDER_END,
+    MARKER_COPIED_FROM_GPU,
+    MARKER_WRITE_END,
+    MARKER_SCANOUT_START,
+    MARKER_FRAME_RECEIVED,
+    MARKER_READ_END,
+    MARKER_COPIED_TO_GPU,
+    MARKER_CORE_COUNT
+};
+
+// Where the time of a stage is spent, which determines how it is summarized.
+enum StageSide
+{
+    STAGE_PRODUCER, // Producer work (part of the estimated application time).
+    STAGE_CONSUMER, // Consumer work (part of the estimated application time).
+    STAGE_OUTPUT,   // Waiting for the output on the producer thread (e.g. vsync).
+    STAGE_TRANSFER, // Transfer between the producer and consumer (e.g. wire time).
+    STAGE_TOOL,     // Work done by this tool itself (e.g. identifying frames).
+};
+
+// A marker is a named point in time that is recorded for each frame, and it
+// describes the stage that ends at that point. A stage starts at the closest
+// earlier marker (in pipeline order) that was recorded for the frame.
+struct Marker
+{
+    MarkerId id;
+    std::string name;   // The marker name (e.g. "render-end").
+    std::string label;  // The display label of the stage (e.g. "Render on GPU").
+    std::string metric; // The metric name of the stage (e.g. "render").
+    StageSide side;
+};
+
+// The registry of markers, which initially holds the core markers. Backends
+// may register additional markers when they are initialized, and the stage
+// summaries, CSV columns and traces are all derived from the registry.
+class StageRegistry
+{
+public:
+
+    // Registers a marker that is recorded after the given marker in pipeline
+    // order, such that the label describes the stage that ends at the new
+    // marker (which splits the stage that previously followed it). If a
+    // marker with the same name is already registered then its ID is
+    // returned, such that a backend can be initialized more than once.
+    // Returns MAX_MARKERS if there are no free marker slots, in which case
+    // the marker is never recorded (see MarkerEnabled).
+    static MarkerId Register(const std::string& name, const std::string& label,
+                             const std::string& metric, StageSide side, MarkerId after);
+
+    // The registered markers in pipeline order. The first marker only starts
+    // the first stage. This must not be used while markers are being registered.
+    static const std::vector<Marker>& Markers();
+
+    static const char* SideName(StageSide side);
+};
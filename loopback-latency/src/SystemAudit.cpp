@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "SystemAudit.h"
+
+namespace
+{
+
+const std::string CPU_ROOT("/sys/devices/system/cpu");
+
+// Returns the first line of the given file, or an empty string if it can't be read.
+std::string ReadLine(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Returns the selected value (in brackets) from a sysfs option list,
+// e.g. "always [madvise] never" returns "madvise".
+std::string SelectedOption(const std::string& options)
+{
+    size_t start = options.find('[');
+    size_t end = options.find(']');
+    if (start == std::string::npos || end == std::string::npos || end < start)
+        return options;
+    return options.substr(start + 1, end - start - 1);
+}
+
+// Formats a list of CPU indices as ranges, e.g. "0-3,6".
+std::string FormatCpuList(const std::vector<int>& cpus)
+{
+    std::ostringstream ss;
+    for (size_t i = 0; i < cpus.size(); i++)
+    {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            j++;
+        if (i > 0)
+            ss << ",";
+        ss << cpus[i];
+        if (j > i)
+            ss << "-" << cpus[j];
+        i = j;
+    }
+    return ss.str();
+}
+
+}
+
+std::vector<int> SystemAudit::OnlineCpus()
+{
+    // The list is given as ranges (e.g. "0-3,6"), since CPUs in the middle
+    // may be offline.
+    std::vector<int> cpus;
+    std::istringstream ss(ReadLine(CPU_ROOT + "/online"));
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        int first, last;
+        int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (fields < 1)
+            continue;
+        if (fields == 1)
+            last = first;
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+
+    // Fall back to the online CPU count if the list can't be read.
+    if (cpus.empty())
+    {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long i = 0; i < count; i++)
+            cpus.push_back(i);
+    }
+    return cpus;
+}
+
+void SystemAudit::Collect(const std::vector<std::string>& irqDevices)
+{
+    m_entries.clear();
+    CollectKernel();
+    CollectCpus();
+    CollectMemory();
+    CollectScheduler();
+    CollectIrqs(irqDevices);
+}
+
+const std::vector<std::pair<std::string, std::string>>& SystemAudit::Entries() const
+{
+    return m_entries;
+}
+
+void SystemAudit::Add(const std::string& key, const std::string& value)
+{
+    m_entries.push_back(std::make_pair(key, value.empty() ? "unknown" : value));
+}
+
+void SystemAudit::CollectKernel()
+{
+    utsname name;
+    if (uname(&name) == 0)
+    {
+        Add("kernel.release", name.release);
+
+        // The preemption model is part of the kernel version string.
+        const std::string version(name.version);
+        std::string preempt("none/voluntary");
+        if (version.find("PREEMPT_RT") != std::string::npos || ReadLine("/sys/kernel/realtime") == "1")
+            preempt = "rt";
+        else if (version.find("PREEMPT_DYNAMIC") != std::string::npos)
+            preempt = "dynamic";
+        else if (version.find("PREEMPT") != std::string::npos)
+            preempt = "full";
+        Add("kernel.preempt", preempt);
+    }
+
+    // The dynamic preemption model is only visible through debugfs, in which
+    // the selected model is given in parentheses, e.g. "none voluntary (full)".
+    std::string dynamicPreempt = ReadLine("/sys/kernel/debug/sched/preempt");
+    size_t start = dynamicPreempt.find('(');
+    size_t end = dynamicPreempt.find(')');
+    if (start != std::string::npos && end != std::string::npos && end > start)
+        Add("kernel.preempt.dynamic", dynamicPreempt.substr(start + 1, end - start - 1));
+
+    // Report only the command line parameters that affect latency.
+    const std::vector<std::string> params = {
+        "isolcpus", "nohz_full", "rcu_nocbs", "irqaffinity", "threadirqs", "idle",
+        "processor.max_cstate", "intel_idle.max_cstate", "mitigations", "transparent_hugepage"
+    };
+    std::istringstream cmdline(ReadLine("/proc/cmdline"));
+    std::string param;
+    while (cmdline >> param)
+    {
+        std::string key(param.substr(0, param.find('=')));
+        for (const auto& p : params)
+        {
+            if (key == p)
+                Add("cmdline." + key, param.find('=') == std::string::npos ? "1" : param.substr(key.size() + 1));
+        }
+    }
+}
+
+void SystemAudit::CollectCpus()
+{
+    std::vector<int> cpus = OnlineCpus();
+    Add("cpu.online", FormatCpuList(cpus));
+    Add("cpu.isolated", ReadLine(CPU_ROOT + "/isolated").empty() ? "none" : ReadLine(CPU_ROOT + "/isolated"));
+    Add("cpu.nohz_full", ReadLine(CPU_ROOT + "/nohz_full").empty() ? "none" : ReadLine(CPU_ROOT + "/nohz_full"));
+
+    // Group the CPUs by their frequency governor.
+    std::map<std::string, std::vector<int>> governors;
+    for (int cpu : cpus)
+    {
+        std::string governor = ReadLine(CPU_ROOT + "/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor");
+        governors[governor.empty() ? "none" : governor].push_back(cpu);
+    }
+    std::ostringstream ss;
+    for (const auto& governor : governors)
+        ss << (ss.tellp() > 0 ? ", " : "") << governor.first << " (" << FormatCpuList(governor.second) << ")";
+    Add("cpu.governor", ss.str());
+
+    // Report the idle states (and their exit latencies) of the first online CPU.
+    Add("cpu.idle.driver", ReadLine(CPU_ROOT + "/cpuidle/current_driver"));
+    const std::string firstCpu(CPU_ROOT + "/cpu" + std::to_string(cpus.empty() ? 0 : cpus.front()));
+    std::ostringstream states;
+    for (int i = 0; ; i++)
+    {
+        const std::string state(firstCpu + "/cpuidle/state" + std::to_string(i));
+        std::string name = ReadLine(state + "/name");
+        if (name.empty())
+            break;
+        states << (i > 0 ? " " : "") << name << ":" << ReadLine(state + "/latency") << "us";
+        if (ReadLine(state + "/disable") == "1")
+            states << "(disabled)";
+    }
+    Add("cpu.idle.states", states.str().empty() ? "none" : states.str());
+
+    // The PM QoS CPU latency request is read as a binary 32-bit value.
+    int fd = open("/dev/cpu_dma_latency", O_RDONLY);
+    if (fd >= 0)
+    {
+        int32_t latency;
+        if (read(fd, &latency, sizeof(latency)) == sizeof(latency))
+            Add("cpu.dma_latency", std::to_string(latency));
+        close(fd);
+    }
+    else
+    {
+        Add("cpu.dma_latency", "");
+    }
+}
+
+void SystemAudit::CollectMemory()
+{
+    Add("mm.thp.enabled", SelectedOption(ReadLine("/sys/kernel/mm/transparent_hugepage/enabled")));
+    Add("mm.thp.defrag", SelectedOption(ReadLine("/sys/kernel/mm/transparent_hugepage/defrag")));
+}
+
+void SystemAudit::CollectScheduler()
+{
+    Add("sched.rt_runtime_us", ReadLine("/proc/sys/kernel/sched_rt_runtime_us"));
+    Add("sched.rt_period_us", ReadLine("/proc/sys/kernel/sched_rt_period_us"));
+}
+
+void SystemAudit::CollectIrqs(const std::vector<std::string>& irqDevices)
+{
+    std::ifstream interrupts("/proc/interrupts");
+    std::string line;
+    while (std::getline(interrupts, line))
+    {
+        // Lines are of the form "  123:  {counts per CPU}  {type}  {names}".
+        std::istringstream ss(line);
+        std::string irq;
+        ss >> irq;
+        if (irq.empty() || irq.back() != ':')
+            continue;
+        irq.pop_back();
+
+        for (const auto& device : irqDevices)
+        {
+            if (device.empty() || line.find(device) == std::string::npos)
+                continue;
+
+            std::string name(line.substr(line.find_last_of(" \t") + 1));
+            std::string affinity = ReadLine("/proc/irq/" + irq + "/smp_affinity_list");
+            std::string effective = ReadLine("/proc/irq/" + irq + "/effective_affinity_list");
+            Add("irq." + irq, name + " -> cpus " + (affinity.empty() ? "unknown" : affinity) +
+                (effective.empty() ? "" : " (effective " + effective + ")"));
+            break;
+        }
+    }
+}
+
+std::string SystemAudit::V4L2DriverName(const std::string& device)
+{
+    // Resolve the device node (e.g. /dev/video0) to its sysfs driver link.
+    char path[PATH_MAX];
+    if (!realpath(device.c_str(), path))
+        return "";
+    std::string node(path);
+    node = node.substr(node.find_last_of('/') + 1);
+
+    char driver[PATH_MAX];
+    ssize_t length = readlink(("/sys/class/video4linux/" + node + "/device/driver").c_str(), driver, sizeof(driver) - 1);
+    if (length <= 0)
+        return "";
+    driver[length] = '\0';
+    std::string name(driver);
+    return name.substr(name.find_last_of('/') + 1);
+}
+
+std::ostream& operator<<(std::ostream& o, const SystemAudit& a)
+{
+    for (const auto& entry : a.m_entries)
+        o << "   " << entry.first << std::string(entry.first.size() < 24 ? 24 - entry.first.size() : 1, ' ')
+          << entry.second << std::endl;
+    return o;
+}
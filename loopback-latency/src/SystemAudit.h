@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Collects the system settings that are known to affect latency measurements
+// (CPU frequency governors, idle states, CPU isolation, IRQ affinities, THP
+// and RT throttling) so that they can be reported alongside the results.
+class SystemAudit
+{
+public:
+
+    // Collects the settings. The IRQ affinity is reported for every interrupt
+    // whose name in /proc/interrupts contains one of the given device names.
+    void Collect(const std::vector<std::string>& irqDevices);
+
+    const std::vector<std::pair<std::string, std::string>>& Entries() const;
+
+    // Returns the name of the kernel driver used by a V4L2 device (e.g. /dev/video0).
+    static std::string V4L2DriverName(const std::string& device);
+
+    // Returns the CPUs that are online, from /sys/devices/system/cpu/online.
+    static std::vector<int> OnlineCpus();
+
+private:
+
+    void Add(const std::string& key, const std::string& value);
+
+    void CollectKernel();
+    void CollectCpus();
+    void CollectMemory();
+    void CollectScheduler();
+    void CollectIrqs(const std::vector<std::string>& irqDevices);
+
+    std::vector<std::pair<std::string, std::string>> m_entries;
+
+    friend std::ostream& operator<<(std::ostream& o, const SystemAudit& a);
+};
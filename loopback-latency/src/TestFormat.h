@@ -22,42 +22,212 @@
 
 #pragma once
 
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <ostream>
+#include <strings.h>
 
 enum PixelFormat
 {
     PIXEL_FORMAT_UNKNOWN,
     PIXEL_FORMAT_RGBA,
+    PIXEL_FORMAT_UYVY,  // Packed 4:2:2 (U0 Y0 V0 Y1)
+    PIXEL_FORMAT_YUYV,  // Packed 4:2:2 (Y0 U0 Y1 V0)
+    PIXEL_FORMAT_NV12,  // Semi-planar 4:2:0 (Y plane followed by an interleaved UV plane)
+
+    // 10-bit formats. Each 8-bit frame color is written as the 10-bit value
+    // (color << 2) so that it survives quantization (see DecodeSample10).
+    PIXEL_FORMAT_RGB10A2, // 32-bit words with R in bits 0-9, G in 10-19, B in 20-29 and A in 30-31
+    PIXEL_FORMAT_V210,    // Packed 4:2:2, 6 pixels per 16 bytes with lines padded to 128 bytes
+    PIXEL_FORMAT_P010,    // As NV12, with 16-bit samples holding the value in the upper 10 bits
+
+    PIXEL_FORMAT_COUNT,
 };
 
+inline const char* PixelFormatName(PixelFormat format)
+{
+    switch (format)
+    {
+        case PIXEL_FORMAT_RGBA:    return "RGBA";
+        case PIXEL_FORMAT_UYVY:    return "UYVY";
+        case PIXEL_FORMAT_YUYV:    return "YUYV";
+        case PIXEL_FORMAT_NV12:    return "NV12";
+        case PIXEL_FORMAT_RGB10A2: return "RGB10A2";
+        case PIXEL_FORMAT_V210:    return "v210";
+        case PIXEL_FORMAT_P010:    return "P010";
+        default:                   return "Unknown";
+    }
+}
+
+// Returns the pixel format with the given (case insensitive) name, or
+// PIXEL_FORMAT_UNKNOWN if there is no such format.
+inline PixelFormat ParsePixelFormat(const char* name)
+{
+    for (int i = PIXEL_FORMAT_RGBA; i < PIXEL_FORMAT_COUNT; i++)
+    {
+        if (!strcasecmp(name, PixelFormatName((PixelFormat)i)))
+            return (PixelFormat)i;
+    }
+    return PIXEL_FORMAT_UNKNOWN;
+}
+
+constexpr bool IsYUVFormat(PixelFormat format)
+{
+    return format == PIXEL_FORMAT_UYVY ||
+           format == PIXEL_FORMAT_YUYV ||
+           format == PIXEL_FORMAT_NV12 ||
+           format == PIXEL_FORMAT_V210 ||
+           format == PIXEL_FORMAT_P010;
+}
+
+// Whether the chroma values are in a separate plane following the luma plane.
+constexpr bool IsSemiPlanarFormat(PixelFormat format)
+{
+    return format == PIXEL_FORMAT_NV12 || format == PIXEL_FORMAT_P010;
+}
+
+// Encodes an 8-bit frame color as a 10-bit sample.
+constexpr uint16_t EncodeSample10(uint8_t value)
+{
+    return value << 2;
+}
+
+// Decodes a 10-bit sample to the 8-bit frame color, rounding to the nearest
+// value so that an error of +/-1 in the 10-bit sample does not change it.
+constexpr uint8_t DecodeSample10(uint16_t sample)
+{
+    return sample >= 0x3FE ? 0xFF : (sample + 2) >> 2;
+}
+
+// A frame rate given as a fraction of frames per second, such that the
+// fractional broadcast rates are exact (e.g. 59.94Hz is 60000/1001).
+struct FrameRate
+{
+    constexpr FrameRate(uint32_t _num = 0, uint32_t _den = 1)
+        : num(_num)
+        , den(_den) {}
+
+    constexpr double Hz() const { return den ? (double)num / den : 0.0; }
+
+    // The rate rounded to the nearest whole Hz, which is how some APIs
+    // (e.g. GLFW video modes) report the display refresh rate.
+    constexpr uint32_t RoundedHz() const { return den ? (num + den / 2) / den : 0; }
+
+    // The exact time between frames.
+    constexpr std::chrono::nanoseconds Interval() const
+    {
+        return std::chrono::nanoseconds(num ? (uint64_t)1000000000 * den / num : 0);
+    }
+
+    // The time between frames rounded to the nearest microsecond.
+    constexpr std::chrono::microseconds IntervalMicroseconds() const
+    {
+        return std::chrono::microseconds(num ? ((uint64_t)1000000 * den + num / 2) / num : 0);
+    }
+
+    // Rates are equal if their fractions are, e.g. 60/1 == 120/2.
+    constexpr bool operator==(const FrameRate& other) const
+    {
+        return (uint64_t)num * other.den == (uint64_t)other.num * den;
+    }
+    constexpr bool operator!=(const FrameRate& other) const { return !(*this == other); }
+
+    uint32_t num;
+    uint32_t den;
+};
+
+inline std::ostream& operator<<(std::ostream& o, const FrameRate& r)
+{
+    // Fractional rates are shown to two decimals (e.g. 59.94 or 23.98).
+    if (r.den == 1 || (r.den && r.num % r.den == 0))
+        o << r.RoundedHz();
+    else
+        o << std::round(r.Hz() * 100.0) / 100.0;
+    return o;
+}
+
 struct TestFormat
 {
-    constexpr TestFormat(size_t _width, size_t _height, PixelFormat _pixelFormat, uint32_t _frameRate)
+    constexpr TestFormat(size_t _width, size_t _height, PixelFormat _pixelFormat, FrameRate _frameRate)
         : width(_width)
         , height(_height)
         , pixelFormat(_pixelFormat)
         , bytesPerPixel(GetBytesPerPixel(pixelFormat))
-        , totalBytes(width * height * bytesPerPixel)
+        , stride(GetStride(width, pixelFormat))
+        , chromaOffset(IsSemiPlanarFormat(pixelFormat) ? stride * height : 0)
+        , totalBytes(GetTotalBytes(stride, height, pixelFormat))
         , frameRate(_frameRate) {}
 
+    // The bytes of each line that are sent over the link, without the line
+    // padding. For v210 this is only the complete blocks of 6 pixels, since
+    // a partial last block is not sent.
+    constexpr size_t ActiveLineBytes() const
+    {
+        if (pixelFormat == PIXEL_FORMAT_V210)
+            return width / 6 * 16;
+        return width * bytesPerPixel;
+    }
+
+    // Returns this format with a different pixel format.
+    constexpr TestFormat WithPixelFormat(PixelFormat format) const
+    {
+        return TestFormat(width, height, format, frameRate);
+    }
+
     size_t width;
     size_t height;
     PixelFormat pixelFormat;
+
+    // The bytes per pixel of the first (or only) plane, or 0 for formats that
+    // pack pixels into blocks that are not a whole number of bytes per pixel.
     size_t bytesPerPixel;
+
+    // The bytes per line of the first (or only) plane, including any padding.
+    // The chroma plane of semi-planar formats has the same stride.
+    size_t stride;
+
+    // The offset of the chroma plane of semi-planar formats, or 0.
+    size_t chromaOffset;
+
     size_t totalBytes;
-    uint32_t frameRate;
+    FrameRate frameRate;
 
 private:
 
-    constexpr size_t GetBytesPerPixel(PixelFormat format)
+    static constexpr size_t GetBytesPerPixel(PixelFormat format)
     {
-        switch (pixelFormat)
+        switch (format)
         {
             case PIXEL_FORMAT_RGBA: return 4;
+            case PIXEL_FORMAT_UYVY: return 2;
+            case PIXEL_FORMAT_YUYV: return 2;
+            case PIXEL_FORMAT_NV12: return 1;
+            case PIXEL_FORMAT_RGB10A2: return 4;
+            case PIXEL_FORMAT_P010: return 2;
             default: return 0;
         }
     }
 
+    static constexpr size_t GetStride(size_t width, PixelFormat format)
+    {
+        // v210 packs 6 pixels into each 16 byte block, and lines are padded
+        // to a multiple of 48 pixels (128 bytes).
+        if (format == PIXEL_FORMAT_V210)
+            return (width + 47) / 48 * 128;
+        return width * GetBytesPerPixel(format);
+    }
+
+    static constexpr size_t GetTotalBytes(size_t stride, size_t height, PixelFormat format)
+    {
+        // The 4:2:0 chroma plane has a U and V value for every 2x2 pixels,
+        // which is half the lines of the luma plane at the same stride.
+        if (IsSemiPlanarFormat(format))
+            return stride * height + stride * height / 2;
+        return stride * height;
+    }
+
 };
 
 inline bool operator==(const TestFormat& a, const TestFormat& b)
@@ -67,11 +237,7 @@ inline bool operator==(const TestFormat& a, const TestFormat& b)
 
 inline std::ostream& operator<<(std::ostream& o, const TestFormat& f)
 {
-    o << f.width << "x" << f.height << " ";
-    switch (f.pixelFormat)
-    {
-        case PIXEL_FORMAT_RGBA: o << "RGBA"; break;
-    }
+    o << f.width << "x" << f.height << " " << PixelFormatName(f.pixelFormat);
     o << " @ " << f.frameRate << "Hz";
     return o;
 }
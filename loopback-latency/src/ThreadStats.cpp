@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "ThreadStats.h"
+
+static bool s_enabled = false;
+
+ThreadSample ThreadSample::Now()
+{
+    ThreadSample sample;
+    sample.perf = PerfSample::Now();
+    if (!s_enabled)
+        return sample;
+
+    timespec ts;
+    rusage usage;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0 &&
+        getrusage(RUSAGE_THREAD, &usage) == 0)
+    {
+        sample.valid = true;
+        sample.cpuTime = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        sample.voluntarySwitches = usage.ru_nvcsw;
+        sample.involuntarySwitches = usage.ru_nivcsw;
+    }
+    return sample;
+}
+
+void ThreadSample::Enable(bool enable)
+{
+    s_enabled = enable;
+}
+
+bool ThreadSample::Enabled()
+{
+    return s_enabled;
+}
+
+static Microseconds ToMicroseconds(const timeval& tv)
+{
+    return std::chrono::seconds(tv.tv_sec) + Microseconds(tv.tv_usec);
+}
+
+ProcessSample ProcessSample::Now()
+{
+    ProcessSample sample = {};
+    rusage usage;
+    sample.time = Clock::now();
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        sample.userTime = ToMicroseconds(usage.ru_utime);
+        sample.systemTime = ToMicroseconds(usage.ru_stime);
+    }
+    return sample;
+}
+
+CpuUtilization::CpuUtilization(const ProcessSample& start, const ProcessSample& end)
+    : user(0.0)
+    , system(0.0)
+{
+    double wall = std::chrono::duration_cast<Microseconds>(end.time - start.time).count();
+    if (wall > 0.0)
+    {
+        user = (end.userTime - start.userTime).count() * 100.0 / wall;
+        system = (end.systemTime - start.systemTime).count() * 100.0 / wall;
+    }
+}
+
+void ThreadStatsList::Append(const TimePoint& startTime, const ThreadSample& start,
+                             const TimePoint& endTime, const ThreadSample& end)
+{
+    m_perf.Append(start.perf, end.perf);
+
+    if (!start.valid || !end.valid)
+        return;
+
+    // The wall and CPU clocks are sampled at slightly different times, so
+    // clamp the on-CPU time to the wall time of the stage.
+    Microseconds wall = std::chrono::duration_cast<Microseconds>(endTime - startTime);
+    Microseconds onCpu = std::min(wall, std::chrono::duration_cast<Microseconds>(end.cpuTime - start.cpuTime));
+    Microseconds offCpu = wall - onCpu;
+    if (Size() == 0 || wall > m_slowestOnCpu + m_slowestOffCpu)
+    {
+        m_slowestOnCpu = onCpu;
+        m_slowestOffCpu = offCpu;
+    }
+
+    m_onCpu.Append(onCpu);
+    m_offCpu.Append(offCpu);
+
+    long involuntary = end.involuntarySwitches - start.involuntarySwitches;
+    m_voluntarySwitches += end.voluntarySwitches - start.voluntarySwitches;
+    m_involuntarySwitches += involuntary;
+    if (involuntary > 0)
+        m_preemptedCount++;
+}
+
+std::string ThreadStatsList::Summary(const std::string& indent) const
+{
+    if (Size() == 0 && m_perf.Size() == 0)
+        return indent + "No samples\n";
+
+    std::ostringstream ss;
+    if (m_perf.Size())
+        ss << m_perf.Summary(indent);
+    if (Size() == 0)
+        return ss.str();
+
+    ss << indent << "On CPU:   " << m_onCpu.Summary() << std::endl
+       << indent << "Off CPU:  " << m_offCpu.Summary() << std::endl
+       << indent << "Slowest:  " << std::setw(6) << (m_slowestOnCpu + m_slowestOffCpu).count()
+       << " = " << m_slowestOnCpu.count() << " on + " << m_slowestOffCpu.count() << " off" << std::endl
+       << std::setprecision(3)
+       << indent << "Switches: voluntary = " << (float)m_voluntarySwitches / Size()
+       << ", involuntary = " << (float)m_involuntarySwitches / Size()
+       << " per frame (" << m_preemptedCount << " frames preempted)" << std::endl;
+    return ss.str();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "DurationList.h"
+#include "PerfCounters.h"
+
+// A sample of the CPU time used by the calling thread and the number of
+// context switches it has made, taken alongside a frame timestamp so that the
+// time spent in a stage can be split into time on and off the CPU. The
+// hardware counters of the thread are also sampled if they are enabled.
+struct ThreadSample
+{
+    ThreadSample()
+        : valid(false)
+        , cpuTime(0)
+        , voluntarySwitches(0)
+        , involuntarySwitches(0)
+    {}
+
+    // Samples the calling thread. Returns an invalid sample if sampling is
+    // disabled, since each sample costs two system calls (the hardware counters
+    // are enabled separately; see PerfSample::Enable).
+    static ThreadSample Now();
+
+    static void Enable(bool enable);
+    static bool Enabled();
+
+    bool valid;
+    std::chrono::nanoseconds cpuTime;
+    long voluntarySwitches;
+    long involuntarySwitches;
+    PerfSample perf;
+};
+
+// A sample of the CPU time used by every thread of the process, from which the
+// CPU utilization over a period is taken. Unlike ThreadSample, this is always
+// sampled.
+struct ProcessSample
+{
+    static ProcessSample Now();
+
+    TimePoint time;
+    Microseconds userTime;
+    Microseconds systemTime;
+};
+
+// The user and system CPU time used between two samples, as percentages of
+// the wall time (so 100% is one fully used core).
+struct CpuUtilization
+{
+    CpuUtilization()
+        : user(0.0)
+        , system(0.0)
+    {}
+    CpuUtilization(const ProcessSample& start, const ProcessSample& end);
+
+    double user;
+    double system;
+    double Total() const { return user + system; }
+};
+
+// Accumulates the on-CPU time, off-CPU time, context switches and hardware
+// counters of a stage that starts and ends on the same thread.
+class ThreadStatsList
+{
+public:
+
+    ThreadStatsList()
+        : m_voluntarySwitches(0)
+        , m_involuntarySwitches(0)
+        , m_preemptedCount(0)
+        , m_slowestOnCpu(0)
+        , m_slowestOffCpu(0)
+    {}
+
+    void Append(const TimePoint& startTime, const ThreadSample& start,
+                const TimePoint& endTime, const ThreadSample& end);
+
+    size_t Size() const { return m_onCpu.Size(); }
+    const DurationList& OnCpu() const { return m_onCpu; }
+    const DurationList& OffCpu() const { return m_offCpu; }
+
+    // The number of instances of the stage that were involuntarily switched out.
+    size_t PreemptedCount() const { return m_preemptedCount; }
+
+    const PerfStatsList& Perf() const { return m_perf; }
+
+    std::string Summary(const std::string& indent) const;
+
+private:
+
+    DurationList m_onCpu;
+    DurationList m_offCpu;
+    uint64_t m_voluntarySwitches;
+    uint64_t m_involuntarySwitches;
+    size_t m_preemptedCount;
+
+    // The split of the slowest instance of the stage.
+    Microseconds m_slowestOnCpu;
+    Microseconds m_slowestOffCpu;
+
+    PerfStatsList m_perf;
+};
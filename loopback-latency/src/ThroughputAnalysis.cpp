@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ThroughputAnalysis.h"
+
+ThroughputAnalysis::ThroughputAnalysis(const std::vector<std::shared_ptr<Frame>>& frames,
+                                       const Microseconds& frameInterval)
+    : m_frames(frames.size())
+    , m_duration(0)
+    , m_stageTimes(StageRegistry::Markers().size())
+    , m_missedVsyncs(0)
+    , m_lateFrames(0)
+{
+    if (frames.empty())
+        return;
+
+    m_duration = std::chrono::duration_cast<Microseconds>(
+        frames.back()->Time(MARKER_PROCESSING_START) - frames.front()->Time(MARKER_PROCESSING_START));
+
+    const auto& markers = StageRegistry::Markers();
+    const Frame* previous = nullptr;
+    for (const auto& f : frames)
+    {
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (f->StageMarkers(i, &start, &end))
+                m_stageTimes[i].Append(f->Elapsed(start, end));
+        }
+
+        // A scanout interval of n frame intervals (rounded to the nearest) means
+        // that n - 1 vsyncs passed with the previous frame still on the output.
+        if (previous && previous->Recorded(MARKER_SCANOUT_START) && f->Recorded(MARKER_SCANOUT_START))
+        {
+            Microseconds interval = std::chrono::duration_cast<Microseconds>(
+                f->Time(MARKER_SCANOUT_START) - previous->Time(MARKER_SCANOUT_START));
+            m_scanoutIntervals.Append(interval);
+            if (frameInterval.count() > 0)
+            {
+                size_t vsyncs = (interval + frameInterval / 2) / frameInterval;
+                if (vsyncs > 1)
+                {
+                    m_missedVsyncs += vsyncs - 1;
+                    m_lateFrames++;
+                }
+            }
+        }
+        previous = f.get();
+    }
+}
+
+double ThroughputAnalysis::FrameRate() const
+{
+    if (m_frames < 2 || m_duration.count() <= 0)
+        return 0.0;
+    return (m_frames - 1) * 1000000.0 / m_duration.count();
+}
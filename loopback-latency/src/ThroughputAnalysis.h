@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Frame.h"
+
+// Measures the frames produced without a consumer: the sustained rate that
+// they were produced at, the time of each producer stage and, when the
+// producer waits for the vsync, how many vsyncs passed without a new frame.
+class ThroughputAnalysis
+{
+public:
+
+    // The frames are in the order produced (see Producer::ProducedFrames).
+    ThroughputAnalysis(const std::vector<std::shared_ptr<Frame>>& frames, const Microseconds& frameInterval);
+
+    size_t Frames() const { return m_frames; }
+
+    // The time from the start of the first frame to the start of the last.
+    Microseconds Duration() const { return m_duration; }
+
+    // The frames started per second over the duration.
+    double FrameRate() const;
+
+    // The times of each stage, indexed as StageRegistry::Markers.
+    const std::vector<DurationList>& StageTimes() const { return m_stageTimes; }
+
+    // The times between the scanouts of successive frames.
+    const DurationList& ScanoutIntervals() const { return m_scanoutIntervals; }
+
+    // The vsyncs that passed without a new frame being scanned out (judged by
+    // the scanout intervals), and the frames that were late by one or more.
+    size_t MissedVsyncs() const { return m_missedVsyncs; }
+    size_t LateFrames() const { return m_lateFrames; }
+
+private:
+
+    size_t m_frames;
+    Microseconds m_duration;
+    std::vector<DurationList> m_stageTimes;
+    DurationList m_scanoutIntervals;
+    size_t m_missedVsyncs;
+    size_t m_lateFrames;
+};
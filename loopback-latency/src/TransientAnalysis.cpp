@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "TransientAnalysis.h"
+
+template <typename T>
+static T Median(std::vector<T> values)
+{
+    if (values.empty())
+        return T();
+    auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+TransientAnalysis::TransientAnalysis(const std::vector<std::shared_ptr<Frame>>& frames, const LoadSchedule& schedule,
+                                     const Microseconds& frameInterval, const Microseconds& budget)
+{
+    if (frames.empty() || schedule.Empty())
+        return;
+
+    // Only the transitions with measured frames on both sides are analyzed, so
+    // those during the warmup frames are skipped.
+    uint32_t firstFrame = frames.front()->Number();
+    uint32_t endFrame = frames.back()->Number() + 1;
+    Microseconds tolerance(int64_t(frameInterval.count() * SETTLING_TOLERANCE));
+    auto next = frames.begin();
+    uint32_t previousStart = 0;
+    for (const auto& transition : schedule.Transitions(endFrame))
+    {
+        uint32_t baselineStart = std::max(previousStart, transition.frame - std::min<uint32_t>(transition.frame, BASELINE_FRAMES));
+        previousStart = transition.frame;
+        if (transition.frame <= firstFrame)
+            continue;
+
+        // The frames are in the order received, with increasing numbers.
+        auto compare = [](const std::shared_ptr<Frame>& f, uint32_t number) { return f->Number() < number; };
+        auto baselineBegin = std::lower_bound(next, frames.end(), baselineStart, compare);
+        auto begin = std::lower_bound(baselineBegin, frames.end(), transition.frame, compare);
+        auto end = std::lower_bound(begin, frames.end(), transition.end, compare);
+        next = begin;
+        if (baselineBegin == begin || begin == end)
+            continue;
+
+        LoadTransient t;
+        t.transition = transition;
+
+        std::vector<Microseconds> baselineLatencies;
+        std::vector<size_t> baselineFramesInFlight;
+        for (auto f = baselineBegin; f != begin; f++)
+        {
+            baselineLatencies.push_back(Latency(**f));
+            baselineFramesInFlight.push_back((*f)->FramesInFlight());
+        }
+        t.baselineLatency = Median(baselineLatencies);
+        t.baselineFramesInFlight = Median(baselineFramesInFlight);
+        t.budget = budget.count() > 0 ? budget : t.baselineLatency + frameInterval;
+
+        t.peakLatency = Microseconds(0);
+        t.queueBuildUp = 0;
+        t.framesReceived = end - begin;
+        t.framesOverBudget = 0;
+        for (auto f = begin; f != end; f++)
+        {
+            Microseconds latency = Latency(**f);
+            t.peakLatency = std::max(t.peakLatency, latency);
+            if (latency > t.budget)
+                t.framesOverBudget++;
+            if ((*f)->FramesInFlight() > t.baselineFramesInFlight)
+                t.queueBuildUp = std::max(t.queueBuildUp, (*f)->FramesInFlight() - t.baselineFramesInFlight);
+        }
+        uint32_t lastFrame = (*(end - 1))->Number() + 1;
+        t.framesSkipped = (lastFrame - transition.frame) - t.framesReceived;
+
+        // The new steady state is taken from the last quarter of the segment,
+        // and the latency has settled if it stays within the tolerance of it
+        // from some frame before then until the end of the segment.
+        size_t steadyFrames = std::max<size_t>(1, t.framesReceived / 4);
+        std::vector<Microseconds> steadyLatencies;
+        for (auto f = end - steadyFrames; f != end; f++)
+            steadyLatencies.push_back(Latency(**f));
+        t.settledLatency = Median(steadyLatencies);
+
+        auto settledFrame = end;
+        while (settledFrame != begin)
+        {
+            Microseconds latency = Latency(**(settledFrame - 1));
+            if (latency > t.settledLatency + tolerance || latency + tolerance < t.settledLatency)
+                break;
+            settledFrame--;
+        }
+        t.settled = settledFrame <= end - steadyFrames;
+        if (t.settled)
+        {
+            t.settlingTime = std::chrono::duration_cast<Microseconds>(
+                (*settledFrame)->Time(MARKER_PROCESSING_START) - (*begin)->Time(MARKER_PROCESSING_START));
+            t.settlingFrames = (*settledFrame)->Number() - transition.frame;
+        }
+        else
+        {
+            t.settlingTime = Microseconds(0);
+            t.settlingFrames = 0;
+        }
+
+        m_transients.push_back(t);
+    }
+}
+
+Microseconds TransientAnalysis::Latency(const Frame& frame)
+{
+    return frame.Elapsed(MARKER_PROCESSING_START, MARKER_COPIED_TO_GPU);
+}
+
+void TransientAnalysis::WriteTransients(std::ostream& o) const
+{
+    o << "Frame,From,To,Ramp,Baseline,Budget,Peak,Queue,Received,Over Budget,Skipped,"
+      << "Settled Latency,Settled,Settling Time,Settling Frames" << std::endl;
+    for (const auto& t : m_transients)
+    {
+        o << t.transition.frame << ","
+          << t.transition.from << ","
+          << t.transition.to << ","
+          << t.transition.ramp << ","
+          << t.baselineLatency.count() << ","
+          << t.budget.count() << ","
+          << t.peakLatency.count() << ","
+          << t.queueBuildUp << ","
+          << t.framesReceived << ","
+          << t.framesOverBudget << ","
+          << t.framesSkipped << ","
+          << t.settledLatency.count() << ","
+          << t.settled << ","
+          << t.settlingTime.count() << ","
+          << t.settlingFrames << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "Frame.h"
+#include "LoadSchedule.h"
+
+// The response of the pipeline to a change in the load of a load schedule,
+// measured over the frames from the transition until the next one.
+struct LoadTransient
+{
+    LoadSchedule::Transition transition;
+
+    // The median latency and frames in flight of the frames received before
+    // the transition (the steady state of the previous load).
+    Microseconds baselineLatency;
+    size_t baselineFramesInFlight;
+
+    // The latency above which a frame is over budget.
+    Microseconds budget;
+
+    Microseconds peakLatency;
+
+    // The most frames that were in flight above the baseline, which is the
+    // number of frames queued up by the change in load.
+    size_t queueBuildUp;
+
+    size_t framesReceived;
+    size_t framesOverBudget;
+
+    // The frames that were never received.
+    size_t framesSkipped;
+
+    // The median latency of the end of the segment (the steady state of the
+    // new load), and the time and frames until the latency settled within
+    // the tolerance of it for the rest of the segment.
+    Microseconds settledLatency;
+    bool settled;
+    Microseconds settlingTime;
+    uint32_t settlingFrames;
+};
+
+// Measures the latency of the frames around each transition of a load
+// schedule: how far the frames queue up and the latency peaks when the load
+// changes, how many frames go over the latency budget, and how long the
+// latency takes to settle at the steady state of the new load.
+class TransientAnalysis
+{
+public:
+
+    // The fraction of the frame interval that the latency must stay within
+    // (either side of the new steady state) for it to be settled.
+    static constexpr double SETTLING_TOLERANCE = 0.25;
+
+    // The most frames before a transition that its baseline is taken from.
+    static constexpr size_t BASELINE_FRAMES = 60;
+
+    // The budget is the given latency, or the baseline plus a frame interval
+    // for each transition if it is zero.
+    TransientAnalysis(const std::vector<std::shared_ptr<Frame>>& frames, const LoadSchedule& schedule,
+                      const Microseconds& frameInterval, const Microseconds& budget);
+
+    const std::vector<LoadTransient>& Transients() const { return m_transients; }
+
+    // Writes a CSV row for each transition.
+    void WriteTransients(std::ostream& o) const;
+
+private:
+
+    static Microseconds Latency(const Frame& frame);
+
+    std::vector<LoadTransient> m_transients;
+};
@@ -21,12 +21,14 @@
  */
 
 #include <fcntl.h>
+#include <string.h>
 #include <linux/videodev2.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
 #include "V4L2Consumer.h"
+#include "AsyncLog.h"
 #include "Console.h"
 #include "CudaUtils.h"
 
@@ -34,6 +36,7 @@ V4L2Consumer::V4L2Consumer(std::shared_ptr<Producer> producer, const std::string
     : Consumer(producer)
     , m_device(device.size() == 0 ? "/dev/video0" : device)
     , m_fd(-1)
+    , m_bytesPerLine(0)
     , m_cudaBuffer(nullptr)
 {
 }
@@ -47,6 +50,8 @@ V4L2Consumer::~V4L2Consumer()
 
 bool V4L2Consumer::Initialize()
 {
+    m_startupPhases.Resume();
+
     // Open the device.
     m_fd = open(m_device.c_str(), O_RDWR);
     if (m_fd < 0)
@@ -72,6 +77,7 @@ bool V4L2Consumer::Initialize()
         Error(m_device << " does not support streaming I/O.");
         return false;
     }
+    m_startupPhases.Record("Open device");
 
     // Set the image format.
     v4l2_format fmt = {0};
@@ -93,6 +99,38 @@ bool V4L2Consumer::Initialize()
         Error("Format not supported by V4L2 consumer.");
         return false;
     }
+    if (fmt.fmt.pix.bytesperline < m_producer->Format().stride)
+    {
+        Error("Unexpected line stride on " << m_device << " (" << fmt.fmt.pix.bytesperline <<
+              " bytes, expected at least " << m_producer->Format().stride << ")");
+        return false;
+    }
+
+    // Devices may pad each line, in which case the lines are packed to the
+    // stride of the format as each frame is read.
+    m_bytesPerLine = fmt.fmt.pix.bytesperline;
+    m_packedBuffer.clear();
+    if (m_bytesPerLine != m_producer->Format().stride)
+        m_packedBuffer.resize(m_producer->Format().totalBytes);
+
+    // Request the frame rate if the device supports it. Devices that are locked
+    // to the incoming signal (such as the onboard HDMI capture card) do not.
+    const FrameRate& frameRate = m_producer->Format().frameRate;
+    v4l2_streamparm parm = {0};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(m_fd, VIDIOC_G_PARM, &parm) == 0 && (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME))
+    {
+        parm.parm.capture.timeperframe.numerator = frameRate.den;
+        parm.parm.capture.timeperframe.denominator = frameRate.num;
+        if (ioctl(m_fd, VIDIOC_S_PARM, &parm) < 0 ||
+            FrameRate(parm.parm.capture.timeperframe.denominator,
+                      parm.parm.capture.timeperframe.numerator) != frameRate)
+        {
+            Error("Failed to set the frame rate on " << m_device << " (" << frameRate << "Hz)");
+            return false;
+        }
+    }
+    m_startupPhases.Record("Set format");
 
     // Request buffers.
     v4l2_requestbuffers req = {0};
@@ -132,6 +170,7 @@ bool V4L2Consumer::Initialize()
 
         m_buffers.push_back(Buffer(ptr, buf.length));
     }
+    m_startupPhases.Record("Map buffers");
 
     // Allocate the CUDA buffer.
     m_cudaBuffer = CudaAlloc(m_producer->Format().totalBytes);
@@ -140,6 +179,12 @@ bool V4L2Consumer::Initialize()
         Error("Failed to allocate CUDA memory.");
         return false;
     }
+    if (!AllocateBuffers())
+    {
+        Error("Failed to allocate the frame conversion and verification buffers.");
+        return false;
+    }
+    m_startupPhases.Record("Allocate CUDA buffer");
 
     return true;
 }
@@ -166,6 +211,8 @@ void V4L2Consumer::Close()
 
 bool V4L2Consumer::StartStreaming()
 {
+    m_startupPhases.Resume();
+
     // Queue all buffers.
     for (int i = 0; i < m_buffers.size(); i++)
     {
@@ -179,6 +226,7 @@ bool V4L2Consumer::StartStreaming()
             return false;
         }
     }
+    m_startupPhases.Record("Queue buffers");
 
     // Start streaming.
     v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -187,6 +235,7 @@ bool V4L2Consumer::StartStreaming()
         Error("Failed to start streaming on " << m_device);
         return false;
     }
+    m_startupPhases.Record("Stream on");
 
     return true;
 }
@@ -226,6 +275,15 @@ bool V4L2Consumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
                 Error("Select failure on " << m_device << std::endl << failureMessage);
                 return false;
             }
+            if (ret == 0 && Resilient())
+            {
+                // Keep waiting for the signal to return (e.g. after a hot-plug),
+                // but not for longer than the maximum glitch duration.
+                RecordGlitch(Clock::now(), nullptr);
+                if (!SkipGlitch())
+                    return false;
+                continue;
+            }
             if (ret == 0)
             {
                 Error("Select timeout on " << m_device << std::endl << failureMessage);
@@ -240,10 +298,10 @@ bool V4L2Consumer::CaptureFrames(size_t numFrames, size_t warmupFrames)
         }
         if ((frame > warmupFrames) && (frame - warmupFrames) % 100 == 0)
         {
-            Log((frame - warmupFrames) << " / " << numFrames);
+            LogAsync(frame - warmupFrames, " / ", numFrames);
         }
     }
-    Log(numFrames << " / " << numFrames);
+    LogAsync(numFrames, " / ", numFrames);
 
     return true;
 }
@@ -267,38 +325,55 @@ bool V4L2Consumer::ReadFrame(bool* retry, bool warmupFrame)
         return false;
     }
 
-    TimePoint receiveTime = Clock::now();
+    Timestamp receiveTime = Timestamp::Now();
+    RecordCapture(receiveTime.time);
 
     if (!warmupFrame)
     {
         Buffer& buffer = m_buffers[buf.index];
+        void* frameData = buffer.ptr;
+        if (!m_packedBuffer.empty())
+        {
+            PackLines(buffer.ptr);
+            frameData = m_packedBuffer.data();
+        }
 
-        TimePoint readEnd = Clock::now();
+        Timestamp readEnd = Timestamp::Now(MARKER_READ_END);
 
         // Copy the buffer to GPU.
-        CudaMemcpyHtoD(m_cudaBuffer, buffer.ptr, m_producer->Format().totalBytes);
+        CudaMemcpyHtoD(m_cudaBuffer, frameData, m_producer->Format().totalBytes);
 
-        TimePoint copiedToGPU = Clock::now();
+        Timestamp copiedToGPU = Timestamp::Now(MARKER_COPIED_TO_GPU);
 
-        // Get the frame pointer from the producer.
-        auto frame = m_producer->GetFrame(buffer.ptr);
-        if (!frame)
+        Timestamp converted = ConvertToRGBA(m_cudaBuffer);
+
+        // The sequence number skips the frames dropped by the driver, and the
+        // timestamp is when the driver captured the frame if it was taken on
+        // the monotonic clock (which is the steady clock used for markers).
+        DriverCapture driver;
+        driver.hasSequence = true;
+        driver.sequence = buf.sequence;
+        if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
         {
-            return false;
+            driver.time = TimePoint(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::seconds(buf.timestamp.tv_sec) + std::chrono::microseconds(buf.timestamp.tv_usec)));
         }
 
-        if (m_frames.size() && m_frames.back()->Number() == frame->Number())
+        // Get the frame pointer from the producer. Frames that cannot be
+        // identified are skipped in the resilient mode, and the next buffer is
+        // read in their place.
+        auto frame = IdentifyFrame(frameData, m_cudaBuffer, receiveTime, driver);
+        if (frame)
         {
-            // If this frame has already been received, increment the duplicate count.
-            frame->RecordDuplicateReceive();
+            ReceiveFrame(frame, m_cudaBuffer, receiveTime, readEnd, copiedToGPU, converted);
+        }
+        else if (!SkipGlitch())
+        {
+            return false;
         }
         else
         {
-            // Otherwise, record the times and add it to the consumer list.
-            frame->RecordFrameReceived(receiveTime);
-            frame->RecordReadEnd(readEnd);
-            frame->RecordCopiedToGPU(copiedToGPU);
-            m_frames.push_back(frame);
+            *retry = true;
         }
     }
 
@@ -320,11 +395,28 @@ std::ostream& V4L2Consumer::Dump(std::ostream& o) const
     return o;
 }
 
+void V4L2Consumer::PackLines(const void* ptr)
+{
+    // The lines of the chroma plane of semi-planar formats follow those of
+    // the luma plane at the same stride, so every line is packed the same way.
+    const TestFormat& format = m_producer->Format();
+    const uint8_t* src = static_cast<const uint8_t*>(ptr);
+    uint8_t* dst = m_packedBuffer.data();
+    for (size_t line = 0; line < format.totalBytes / format.stride; line++)
+        memcpy(dst + line * format.stride, src + line * m_bytesPerLine, format.stride);
+}
+
 uint32_t V4L2Consumer::GetV4L2PixelFormat(PixelFormat format)
 {
     switch (format)
     {
         case PIXEL_FORMAT_RGBA: return V4L2_PIX_FMT_ABGR32;
+        case PIXEL_FORMAT_UYVY: return V4L2_PIX_FMT_UYVY;
+        case PIXEL_FORMAT_YUYV: return V4L2_PIX_FMT_YUYV;
+        case PIXEL_FORMAT_NV12: return V4L2_PIX_FMT_NV12;
+#ifdef V4L2_PIX_FMT_P010
+        case PIXEL_FORMAT_P010: return V4L2_PIX_FMT_P010;
+#endif
         default: return 0;
     }
 }
@@ -50,11 +50,17 @@ private:
 
     bool ReadFrame(bool* retry, bool warmupFrame);
 
+    // Copies the lines of a captured buffer whose lines are padded by the
+    // driver to m_packedBuffer, without the padding.
+    void PackLines(const void* ptr);
+
     static uint32_t GetV4L2PixelFormat(PixelFormat format);
 
     std::string m_device;
     int m_fd;
     std::vector<Buffer> m_buffers;
+    size_t m_bytesPerLine;
+    std::vector<uint8_t> m_packedBuffer;
 
     void* m_cudaBuffer;
 };
@@ -20,8 +20,13 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <limits.h>
+#include <unistd.h>
 
 #include "Console.h"
 
@@ -37,7 +42,23 @@
 #include "GStreamerConsumer.h"
 #include "V4L2Consumer.h"
 
+#include "AsyncLog.h"
+#include "BandwidthModel.h"
+#include "CaptureAnalysis.h"
 #include "CudaUtils.h"
+#include "Daemon.h"
+#include "ExternalSource.h"
+#include "FlightRecorder.h"
+#include "LatencyTuning.h"
+#include "LoadSchedule.h"
+#include "LossAnalysis.h"
+#include "PluginRegistry.h"
+#include "Scenario.h"
+#include "StageExport.h"
+#include "SystemAudit.h"
+#include "ThroughputAnalysis.h"
+#include "TransientAnalysis.h"
+#include "ThreadStats.h"
 
 constexpr TestFormat DEFAULT_FORMAT = FORMAT_1080_RGBA_60;
 constexpr size_t DEFAULT_NUM_FRAMES = 600;
@@ -45,6 +66,12 @@ constexpr size_t DEFAULT_WARMUP_FRAMES = 60;
 constexpr size_t DEFAULT_PRODUCER_TIME = 10;
 constexpr size_t DEFAULT_SIMULATED_PROCESSING = 0;
 constexpr int    DEFAULT_USE_RDMA = 1;
+constexpr size_t DEFAULT_RESTARTS = 0;
+constexpr size_t DEFAULT_FLIGHT_WINDOW = 10;
+constexpr size_t DEFAULT_MAX_GLITCH = 10;
+
+// The environment variable that gives additional plugin directories.
+constexpr const char* PLUGIN_PATH_VARIABLE = "LOOPBACK_LATENCY_PLUGIN_PATH";
 
 enum ProducerType
 {
@@ -52,6 +79,8 @@ enum ProducerType
     PRODUCER_GL,
     PRODUCER_AJA,
     PRODUCER_GSTREAMER,
+    PRODUCER_PLUGIN,
+    PRODUCER_NONE
 };
 
 enum ConsumerType
@@ -60,41 +89,220 @@ enum ConsumerType
     CONSUMER_V4L2,
     CONSUMER_AJA,
     CONSUMER_GSTREAMER,
+    CONSUMER_PLUGIN,
     CONSUMER_NONE
 };
 
 struct ProgramOptions
 {
     ProgramOptions()
-        : producerType(PRODUCER_UNKNOWN)
+        : help(false)
+        , producerType(PRODUCER_UNKNOWN)
         , consumerType(CONSUMER_UNKNOWN)
         , format(DEFAULT_FORMAT)
         , numFrames(DEFAULT_NUM_FRAMES)
         , warmupFrames(DEFAULT_WARMUP_FRAMES)
         , simulatedProcessing(DEFAULT_SIMULATED_PROCESSING)
+        , loadBudget(0)
         , producerRDMA(DEFAULT_USE_RDMA)
         , producerTime(DEFAULT_PRODUCER_TIME)
+        , producerContent(CONTENT_SOLID)
+        , producerContentSeed(0)
+        , producerDecodeIds(false)
         , consumerRDMA(DEFAULT_USE_RDMA)
+        , consumerConvert(false)
+        , consumerVerify(false)
+        , consumerResilient(false)
+        , consumerMaxGlitch(DEFAULT_MAX_GLITCH)
+        , restarts(DEFAULT_RESTARTS)
+        , serialInitialize(false)
+        , tune(false)
+        , cpuStats(false)
+        , perfCounters(false)
+        , flightThreshold(0)
+        , flightWindow(DEFAULT_FLIGHT_WINDOW)
     {}
 
+    bool help;
+    std::string pluginPath;
+    std::string daemonSocket;
     ProducerType producerType;
     ConsumerType consumerType;
     TestFormat format;
     size_t numFrames;
     size_t warmupFrames;
     size_t simulatedProcessing;
+    LoadSchedule loadSchedule;
+    size_t loadBudget;
+    std::string loadOutputFilename;
     std::string outputFilename;
+    std::string traceFilename;
+    std::string lossEventsFilename;
+    std::vector<TestFormat> rampFormats;
+    std::vector<TestFormat> rampPredictFormats;
+    std::string rampOutputFilename;
 
     std::string producerDevice;
     std::string producerChannel;
     bool producerRDMA;
     size_t producerTime;
+    ContentType producerContent;
+    uint32_t producerContentSeed;
+    std::string producerContentTile;
+    bool producerDecodeIds;
+    std::string producerPlugin;
+    std::map<std::string, std::string> producerPluginOptions;
 
     std::string consumerDevice;
     std::string consumerChannel;
     bool consumerRDMA;
+    bool consumerConvert;
+    bool consumerVerify;
+    bool consumerResilient;
+    size_t consumerMaxGlitch;
+    std::string consumerSnapshots;
+    std::string consumerPlugin;
+    std::map<std::string, std::string> consumerPluginOptions;
+
+    size_t restarts;
+    bool serialInitialize;
+    bool tune;
+    bool cpuStats;
+    bool perfCounters;
+    std::string flightRecorderFilename;
+    size_t flightThreshold;
+    size_t flightWindow;
+    Scenario scenario;
 };
 
+static std::string ProducerName(const ProgramOptions& opts)
+{
+    ProducerType type = opts.producerType;
+    if (type == PRODUCER_PLUGIN)
+        return opts.producerPlugin;
+    switch (type)
+    {
+        case PRODUCER_GL: return "gl";
+        case PRODUCER_AJA: return "aja";
+        case PRODUCER_GSTREAMER: return "gst";
+        case PRODUCER_NONE: return "none";
+        default: return "unknown";
+    }
+}
+
+static std::string ConsumerName(const ProgramOptions& opts)
+{
+    ConsumerType type = opts.consumerType;
+    if (type == CONSUMER_PLUGIN)
+        return opts.consumerPlugin;
+    switch (type)
+    {
+        case CONSUMER_V4L2: return "v4l2";
+        case CONSUMER_AJA: return "aja";
+        case CONSUMER_GSTREAMER: return "gst";
+        case CONSUMER_NONE: return "none";
+        default: return "unknown";
+    }
+}
+
+// Returns a canonical description of every option that affects the measurement.
+// This is hashed to tag the results so that runs using the exact same resolved
+// configuration can be identified, regardless of how the options were given.
+static std::string ResolvedConfiguration(const ProgramOptions& opts)
+{
+    std::ostringstream ss;
+    ss << "format=" << opts.format << std::endl
+       << "frames=" << opts.numFrames << std::endl
+       << "warmup=" << opts.warmupFrames << std::endl
+       << "simulated=" << opts.simulatedProcessing << std::endl
+       << "producer.type=" << ProducerName(opts) << std::endl
+       << "producer.device=" << opts.producerDevice << std::endl
+       << "producer.channel=" << opts.producerChannel << std::endl
+       << "producer.rdma=" << opts.producerRDMA << std::endl
+       << "producer.time=" << opts.producerTime << std::endl
+       << "producer.content=" << ContentTypeName(opts.producerContent) << std::endl
+       << "producer.content-seed=" << opts.producerContentSeed << std::endl
+       << "producer.content-tile=" << opts.producerContentTile << std::endl
+       << "producer.decode-id=" << opts.producerDecodeIds << std::endl
+       << "consumer.type=" << ConsumerName(opts) << std::endl
+       << "consumer.device=" << opts.consumerDevice << std::endl
+       << "consumer.channel=" << opts.consumerChannel << std::endl
+       << "consumer.rdma=" << opts.consumerRDMA << std::endl
+       << "consumer.convert=" << opts.consumerConvert << std::endl
+       << "consumer.verify=" << opts.consumerVerify << std::endl
+       << "consumer.resilient=" << opts.consumerResilient << std::endl;
+    for (const auto& option : opts.producerPluginOptions)
+        ss << "producer." << option.first << "=" << option.second << std::endl;
+    for (const auto& option : opts.consumerPluginOptions)
+        ss << "consumer." << option.first << "=" << option.second << std::endl;
+    if (!opts.loadSchedule.Empty())
+        ss << "load=" << opts.loadSchedule << std::endl;
+    ss << "restarts=" << opts.restarts << std::endl
+       << "instrumentation=" << InstrumentationName(INSTRUMENTATION) << std::endl
+       << "tune=" << opts.tune << std::endl
+       << "cpu-stats=" << opts.cpuStats << std::endl
+       << "perf-counters=" << opts.perfCounters << std::endl;
+    return ss.str();
+}
+
+static std::string ConfigurationHash(const ProgramOptions& opts)
+{
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << Scenario::Hash(ResolvedConfiguration(opts));
+    return ss.str();
+}
+
+// Returns the names of the interrupts whose affinities should be audited,
+// which are those of the GPU and the devices used by the producer and consumer.
+static std::vector<std::string> AuditIrqDevices(const ProgramOptions& opts)
+{
+    std::vector<std::string> devices = { "nvidia", "nvgpu" };
+    if (opts.producerType == PRODUCER_AJA || opts.consumerType == CONSUMER_AJA)
+        devices.push_back("ajantv2");
+    if (opts.consumerType == CONSUMER_V4L2 || opts.consumerType == CONSUMER_GSTREAMER)
+        devices.push_back(SystemAudit::V4L2DriverName(opts.consumerDevice.empty() ? "/dev/video0" : opts.consumerDevice));
+    if (opts.producerType == PRODUCER_PLUGIN)
+    {
+        const auto& irqs = PluginRegistry::FindProducer(opts.producerPlugin)->irqDevices;
+        devices.insert(devices.end(), irqs.begin(), irqs.end());
+    }
+    if (opts.consumerType == CONSUMER_PLUGIN)
+    {
+        const auto& irqs = PluginRegistry::FindConsumer(opts.consumerPlugin)->irqDevices;
+        devices.insert(devices.end(), irqs.begin(), irqs.end());
+    }
+    return devices;
+}
+
+// Lists the backends loaded from plugins along with their options.
+static void PluginUsage()
+{
+    std::ostringstream ss;
+    ss << std::left;
+    for (const auto& backend : PluginRegistry::Producers())
+    {
+        ss << "  -p " << std::setw(13) << backend.name << backend.description << std::endl;
+        for (const auto& option : backend.options)
+        {
+            ss << "    -p." << std::setw(12) << option.name << option.description
+               << " (default: " << option.defaultValue << ")" << std::endl;
+        }
+    }
+    for (const auto& backend : PluginRegistry::Consumers())
+    {
+        ss << "  -c " << std::setw(13) << backend.name << backend.description << std::endl;
+        for (const auto& option : backend.options)
+        {
+            ss << "    -c." << std::setw(12) << option.name << option.description
+               << " (default: " << option.defaultValue << ")" << std::endl;
+        }
+    }
+    if (ss.tellp() > 0)
+        Log(std::endl << "Plugin backends:" << std::endl << ss.str());
+    else
+        Log("");
+}
+
 void Usage()
 {
     Log("Usage:" << std::endl << std::endl <<
@@ -118,15 +326,21 @@ void Usage()
 #ifdef ENABLE_AJA
         "                     aja:  AJA playback device" << std::endl <<
 #endif
+        "                     none: Capture from an external source, and instead" << std::endl <<
+        "                           measure the arrival jitter, dropped frames and" << std::endl <<
+        "                           capture stage times of the consumer (see" << std::endl <<
+        "                           -p.decode-id)." << std::endl <<
         "  -c | --consumer  The consumer type. Options include:" << std::endl <<
         "                     v4l2: V4L2 consumer (e.g. CSI HDMI input)" << std::endl <<
         "                     gst:  GStreamer V4L2-based consumer (e.g. CSI HDMI input)" << std::endl <<
 #ifdef ENABLE_AJA
         "                     aja:  AJA capture device" << std::endl <<
 #endif
-        "                     none: Don't consume frames. This allows the application" << std::endl <<
-        "                           to just render the produced frames, which can be" << std::endl <<
-        "                           useful for debugging." << std::endl <<
+        "                     none: Don't consume frames, and instead measure the" << std::endl <<
+        "                           frame rate, stage times and CPU utilization of the" << std::endl <<
+        "                           producer with and without the vsync (see -p.time)." << std::endl <<
+        "                   Other producers and consumers are loaded from plugins" << std::endl <<
+        "                   (see --plugin-path), which are listed below." << std::endl <<
         "  -f | --format    The format to use. Options include:" << std::endl <<
         "                     720:    " << FORMAT_720_RGBA_60 << std::endl <<
         "                     1080:   " << FORMAT_1080_RGBA_60 << std::endl <<
@@ -134,40 +348,216 @@ void Usage()
         "                     uhd:    " << FORMAT_UHD_RGBA_60 << std::endl <<
         "                     4k-24:  " << FORMAT_4K_RGBA_24 << std::endl <<
         "                     4k:     " << FORMAT_4K_RGBA_60 << std::endl <<
+        "                     {w}x{h}@{rate}: Any other mode, where the rate may be" << std::endl <<
+        "                             a fraction (e.g. 1920x1080@60000/1001)" << std::endl <<
         "                     (Default: " << DEFAULT_FORMAT << ")" << std::endl <<
+        "                   Append :{pixfmt} to use a pixel format other than RGBA:" << std::endl <<
+        "                     8-bit:  rgba, uyvy, yuyv (4:2:2) or nv12 (4:2:0)" << std::endl <<
+        "                     10-bit: rgb10a2, v210 (4:2:2) or p010 (4:2:0)" << std::endl <<
+        "                   e.g. 1080:uyvy. Formats other than RGBA are only supported" << std::endl <<
+        "                   by the AJA producer." << std::endl <<
         "  -n {frames}      The number of frames to measure (default: " << DEFAULT_NUM_FRAMES << ")" << std::endl <<
         "  -w {frames}      The number of warmup frames to skip (default: " << DEFAULT_WARMUP_FRAMES << ")" << std::endl <<
         "  -s {loops}       The amount of simulated processing to add each frame (default: " << DEFAULT_SIMULATED_PROCESSING << ")" << std::endl <<
         "                   This value corresponds directly to a loop counter that is used in" << std::endl <<
         "                   a CUDA kernel to add some amount of GPU processing to each frame" << std::endl <<
         "                   before the actual frame color is written." << std::endl <<
+        "  --load {schedule}" << std::endl <<
+        "                   Vary the simulated processing (see -s) with a schedule of" << std::endl <<
+        "                   comma-separated segments, counted in frames from the start of" << std::endl <<
+        "                   streaming (including the warmup frames), and report how the" << std::endl <<
+        "                   latency responds to each change in load:" << std::endl <<
+        "                     {loops}:{frames}       Hold the load (a step or burst)" << std::endl <<
+        "                     {from}-{to}:{frames}   Ramp the load linearly" << std::endl <<
+        "                     repeat                 Repeat the schedule (last entry only)" << std::endl <<
+        "                   e.g. 0:300,20000:120,0:300 or 0:120,30000:3,repeat" << std::endl <<
+        "  --load-budget {us}" << std::endl <<
+        "                   The latency above which a frame counts as over budget after a" << std::endl <<
+        "                   change in load (default: the latency before it plus one frame)" << std::endl <<
+        "  --load-output {filename}" << std::endl <<
+        "                   The path to write the response to each change in load as a" << std::endl <<
+        "                   CSV file." << std::endl <<
         "  -o {filename}    The path to write the output results as a CSV file." << std::endl <<
+        "  --trace {filename}" << std::endl <<
+        "                   The path to write the stages of each frame as a Chrome trace" << std::endl <<
+        "                   (JSON) file, which can be viewed with chrome://tracing or Perfetto." << std::endl <<
+        "  --loss-events {filename}" << std::endl <<
+        "                   The path to write each burst of skipped or repeated frames, its" << std::endl <<
+        "                   cause and the stages of the frame received before it as a CSV file." << std::endl <<
+        "  --restarts {n}   After measuring, stop and restart streaming the given number" << std::endl <<
+        "                   of times to measure the time taken to recover (default: " << DEFAULT_RESTARTS << ")" << std::endl <<
+        "  --tune {x}       Whether to apply the recommended low-latency system settings" << std::endl <<
+        "                   for the duration of the run (requires root, default: 0)" << std::endl <<
+        "  --cpu-stats {x}  Whether to sample the thread CPU time and context switches at" << std::endl <<
+        "                   each stage to report the time spent on and off the CPU (default: 0)" << std::endl <<
+        "  --perf-counters {x}" << std::endl <<
+        "                   Whether to sample the hardware performance counters (cycles," << std::endl <<
+        "                   instructions, cache, TLB and branch misses) at each stage (default: 0)" << std::endl <<
+        "  --flight-recorder {filename}" << std::endl <<
+        "                   Keep detailed records of the most recently received frames and" << std::endl <<
+        "                   write the records around each frame whose latency exceeds the" << std::endl <<
+        "                   --flight-threshold to the given file." << std::endl <<
+        "  --flight-threshold {us}" << std::endl <<
+        "                   The latency (in microseconds) that triggers a flight recorder dump." << std::endl <<
+        "  --flight-window {seconds}" << std::endl <<
+        "                   The number of seconds of records kept by the flight recorder" << std::endl <<
+        "                   (default: " << DEFAULT_FLIGHT_WINDOW << ")" << std::endl <<
+        "  --serial-init    Initialize the producer and consumer one after the other" << std::endl <<
+        "                   rather than at the same time." << std::endl <<
+        "  --ramp {formats} Measure each of the given comma-separated formats (see -f) in" << std::endl <<
+        "                   turn, then fit the time of each stage to a fixed time plus" << std::endl <<
+        "                   the frame size divided by a bandwidth, with 95% confidence" << std::endl <<
+        "                   intervals (e.g. --ramp 720,1080,uhd or 1080:uyvy,1080)." << std::endl <<
+        "  --ramp-predict {formats}" << std::endl <<
+        "                   The comma-separated formats to predict the stage times of" << std::endl <<
+        "                   from the fitted ramp model." << std::endl <<
+        "  --ramp-output {filename}" << std::endl <<
+        "                   The path to write the average stage times of each ramp step" << std::endl <<
+        "                   and the fitted model as a CSV file." << std::endl <<
+        "  --daemon {socket}" << std::endl <<
+        "                   Initialize the producer and consumer once and keep them open," << std::endl <<
+        "                   running the measurements that are requested over the given" << std::endl <<
+        "                   Unix domain socket (see --connect) until it receives --shutdown" << std::endl <<
+        "                   or SIGTERM." << std::endl <<
+        "  --connect {socket} [run options]" << std::endl <<
+        "                   Request a run from the daemon listening on the given socket" << std::endl <<
+        "                   and print its results. The other options are those of the run" << std::endl <<
+        "                   (e.g. -n, -o or --scenario), which may not change the producer" << std::endl <<
+        "                   or consumer configuration of the daemon." << std::endl <<
+        "  --plugin-path {dirs}" << std::endl <<
+        "                   The colon-separated directories to load producer and consumer" << std::endl <<
+        "                   plugins from, before those in " << PLUGIN_PATH_VARIABLE << std::endl <<
+        "                   and the plugins directory next to the executable." << std::endl <<
+        "  --scenario {file}" << std::endl <<
+        "                   Load the options and pass/fail thresholds from a scenario" << std::endl <<
+        "                   file. Options given after this one override the file." << std::endl <<
         std::endl << "Producer options:" << std::endl <<
         "  -p.device {x}    The device to use" << std::endl <<
         "  -p.channel {x}   The channel to use" << std::endl <<
         "  -p.rdma {x}      Whether to use RDMA (default: " << DEFAULT_USE_RDMA << ")" << std::endl <<
-        "  -p.time {x}      The amount of time to produce frames" << std::endl <<
-        "                   (only used when consumer = none)" << std::endl <<
+        "  -p.time {x}      The number of seconds to measure the producer for, with" << std::endl <<
+        "                   and without the vsync (only used when consumer = none," << std::endl <<
+        "                   default: " << DEFAULT_PRODUCER_TIME << ")" << std::endl <<
+        "  -p.content {x}   The content of each frame below the lines that identify it:" << std::endl <<
+        "                   solid, gradient, zoneplate, bars, noise or tile (default: solid)" << std::endl <<
+        "  -p.content-seed {x}" << std::endl <<
+        "                   The seed of the noise content (default: 0)" << std::endl <<
+        "  -p.content-tile {file}" << std::endl <<
+        "                   The binary PPM image that is tiled by the tile content" << std::endl <<
+        "  -p.decode-id {x} Whether to decode the frame ID embedded by a loopback-latency" << std::endl <<
+        "                   producer in each frame captured from an external source, to" << std::endl <<
+        "                   tell the frames that the source skipped or repeated apart" << std::endl <<
+        "                   from those dropped by the capture (only used when producer =" << std::endl <<
+        "                   none, default: 0)" << std::endl <<
         std::endl << "Consumer options:" << std::endl <<
         "  -c.device {x}    The device to use" << std::endl <<
         "  -c.channel {x}   The channel to use" << std::endl <<
-        "  -c.rdma {x}      Whether to use RDMA (default: " << DEFAULT_USE_RDMA << ")" << std::endl);
+        "  -c.rdma {x}      Whether to use RDMA (default: " << DEFAULT_USE_RDMA << ")" << std::endl <<
+        "  -c.convert {x}   Whether to convert captured YUV frames to RGBA on the GPU," << std::endl <<
+        "                   which is measured as an additional stage (default: 0)" << std::endl <<
+        "  -c.verify {x}    Whether to verify every line of the captured frames on the" << std::endl <<
+        "                   GPU, which is measured as an additional stage (default: 0)" << std::endl <<
+        "  -c.resilient {x} Whether to skip captured frames that cannot be identified" << std::endl <<
+        "                   (e.g. during a hot-plug) and report them as glitches rather" << std::endl <<
+        "                   than stopping the run (default: 0)" << std::endl <<
+        "  -c.max-glitch {s}" << std::endl <<
+        "                   The longest glitch, in seconds, to wait for the signal to" << std::endl <<
+        "                   return in the resilient mode before the run fails" << std::endl <<
+        "                   (default: " << DEFAULT_MAX_GLITCH << ")" << std::endl <<
+        "  -c.snapshots {dir}" << std::endl <<
+        "                   The directory to write the first frame of each glitch to" << std::endl <<
+        "                   in the resilient mode" << std::endl);
+    PluginUsage();
+    Log("Scenario file entries:");
+    Scenario::Usage(std::cout);
+}
+
+// Parses a video mode given as {width}x{height}@{num}[/{den}], e.g.
+// 2560x1440@144 or 1920x1080@60000/1001.
+static bool ParseVideoMode(const std::string& mode, TestFormat* format)
+{
+    unsigned long width, height, num, den = 1;
+    int length = 0;
+    int fields = sscanf(mode.c_str(), "%lux%lu@%lu%n/%lu%n", &width, &height, &num, &length, &den, &length);
+    if (fields < 3 || length != (int)mode.size() || !width || !height || !num || !den)
+        return false;
+
+    *format = TestFormat(width, height, PIXEL_FORMAT_RGBA, FrameRate(num, den));
+    return true;
 }
 
 #define USAGE_ERROR(x) \
 { \
     Error(x); \
-    exit(1); \
+    return false; \
+}
+
+// Parses a format as given to the -f option (see Usage), logging an error that
+// names the given option if it is invalid.
+static bool ParseFormat(const std::string& value, const char* option, TestFormat* format)
+{
+    // The pixel format is given by an optional ":{pixfmt}" suffix.
+    std::string mode(value);
+    PixelFormat pixelFormat = PIXEL_FORMAT_RGBA;
+    size_t separator = mode.find(':');
+    if (separator != std::string::npos)
+    {
+        pixelFormat = ParsePixelFormat(mode.substr(separator + 1).c_str());
+        if (pixelFormat == PIXEL_FORMAT_UNKNOWN)
+            USAGE_ERROR("Invalid pixel format for " << option << " option: " << value)
+        mode.resize(separator);
+    }
+
+    if (mode == "720")
+        *format = FORMAT_720_RGBA_60;
+    else if (mode == "1080")
+        *format = FORMAT_1080_RGBA_60;
+    else if (mode == "uhd-24")
+        *format = FORMAT_UHD_RGBA_24;
+    else if (mode == "uhd")
+        *format = FORMAT_UHD_RGBA_60;
+    else if (mode == "4k-24")
+        *format = FORMAT_4K_RGBA_24;
+    else if (mode == "4k")
+        *format = FORMAT_4K_RGBA_60;
+    else if (!ParseVideoMode(mode, format))
+        USAGE_ERROR("Invalid value for " << option << " option: " << value)
+    *format = format->WithPixelFormat(pixelFormat);
+
+    // Subsampled formats need whole chroma samples.
+    if (IsYUVFormat(pixelFormat) && format->width % 2)
+        USAGE_ERROR("YUV formats require an even width: " << value)
+    if (IsSemiPlanarFormat(pixelFormat) && format->height % 2)
+        USAGE_ERROR("4:2:0 formats require an even height: " << value)
+    return true;
+}
+
+// Parses a comma-separated list of formats (see ParseFormat).
+static bool ParseFormats(const std::string& value, const char* option, std::vector<TestFormat>* formats)
+{
+    formats->clear();
+    std::istringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        TestFormat format(FORMAT_UNKNOWN);
+        if (!ParseFormat(item, option, &format))
+            return false;
+        formats->push_back(format);
+    }
+    return true;
 }
 
-void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
+// Parses the arguments into the given options, returning false (after logging
+// the error) if they are invalid.
+bool ParseArguments(int argc, char* argv[], ProgramOptions* opts)
 {
     for (int i = 1; i < argc; ++i)
     {
         if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
         {
-            Usage();
-            exit(0);
+            // The usage is shown once the plugins have been loaded.
+            opts->help = true;
         }
         else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--producer"))
         {
@@ -183,8 +573,14 @@ void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
 #endif
             else if (!strcmp(argv[i], "gst") || !strcmp(argv[i], "gstreamer"))
                 opts->producerType = PRODUCER_GSTREAMER;
+            else if (!strcmp(argv[i], "none"))
+                opts->producerType = PRODUCER_NONE;
             else
-                USAGE_ERROR("Invalid value for -p (producer) option: " << argv[i])
+            {
+                // Any other producer must be loaded from a plugin (see ResolvePlugins).
+                opts->producerType = PRODUCER_PLUGIN;
+                opts->producerPlugin = argv[i];
+            }
         }
         else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--consumer"))
         {
@@ -203,26 +599,17 @@ void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
             else if (!strcmp(argv[i], "none"))
                 opts->consumerType = CONSUMER_NONE;
             else
-                USAGE_ERROR("Invalid value for -c (consumer) option: " << argv[i])
+            {
+                opts->consumerType = CONSUMER_PLUGIN;
+                opts->consumerPlugin = argv[i];
+            }
         }
         else if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--format"))
         {
             if (++i == argc)
                 USAGE_ERROR("Missing value for -f (format) option.")
-            if (!strcmp(argv[i], "720"))
-                opts->format = FORMAT_720_RGBA_60;
-            else if (!strcmp(argv[i], "1080"))
-                opts->format = FORMAT_1080_RGBA_60;
-            else if (!strcmp(argv[i], "uhd-24"))
-                opts->format = FORMAT_UHD_RGBA_24;
-            else if (!strcmp(argv[i], "uhd"))
-                opts->format = FORMAT_UHD_RGBA_60;
-            else if (!strcmp(argv[i], "4k-24"))
-                opts->format = FORMAT_4K_RGBA_24;
-            else if (!strcmp(argv[i], "4k"))
-                opts->format = FORMAT_4K_RGBA_60;
-            else
-                USAGE_ERROR("Invalid value for -f (format) option: " << argv[i])
+            if (!ParseFormat(argv[i], "-f (format)", &opts->format))
+                return false;
         }
         else if (!strcmp(argv[i], "-n"))
         {
@@ -242,12 +629,103 @@ void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
                 USAGE_ERROR("Missing value for -s (simulated CUDA workload) option.")
             opts->simulatedProcessing = strtol(argv[i], nullptr, 10);
         }
+        else if (!strcmp(argv[i], "--load"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --load (load schedule) option.")
+            if (!opts->loadSchedule.Parse(argv[i]))
+                return false;
+        }
+        else if (!strcmp(argv[i], "--load-budget"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --load-budget (latency budget) option.")
+            opts->loadBudget = strtol(argv[i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--load-output"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --load-output (load transitions file) option.")
+            opts->loadOutputFilename = argv[i];
+        }
         else if (!strcmp(argv[i], "-o"))
         {
             if (++i == argc)
                 USAGE_ERROR("Missing value for -o (output CSV file) option.")
             opts->outputFilename = argv[i];
         }
+        else if (!strcmp(argv[i], "--trace"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --trace (trace file) option.")
+            opts->traceFilename = argv[i];
+        }
+        else if (!strcmp(argv[i], "--loss-events"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --loss-events (loss events file) option.")
+            opts->lossEventsFilename = argv[i];
+        }
+        else if (!strcmp(argv[i], "--restarts"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --restarts (restart count) option.")
+            opts->restarts = strtol(argv[i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--tune"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --tune (latency tuning) option.")
+            opts->tune = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "--cpu-stats"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --cpu-stats (thread CPU stats) option.")
+            opts->cpuStats = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "--perf-counters"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --perf-counters (performance counters) option.")
+            opts->perfCounters = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "--flight-recorder"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --flight-recorder (flight recorder file) option.")
+            opts->flightRecorderFilename = argv[i];
+        }
+        else if (!strcmp(argv[i], "--flight-threshold"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --flight-threshold (flight recorder threshold) option.")
+            opts->flightThreshold = strtol(argv[i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--flight-window"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --flight-window (flight recorder window) option.")
+            opts->flightWindow = strtol(argv[i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--serial-init"))
+        {
+            opts->serialInitialize = true;
+        }
+        else if (!strcmp(argv[i], "--scenario"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --scenario (scenario file) option.")
+            if (!opts->scenario.Load(argv[i]))
+                return false;
+
+            // Parse the scenario options as if they were given in place of this option.
+            std::vector<char*> args(1, argv[0]);
+            for (const auto& arg : opts->scenario.Arguments())
+                args.push_back(const_cast<char*>(arg.c_str()));
+            if (!ParseArguments(args.size(), args.data(), opts))
+                return false;
+        }
         else if (!strcmp(argv[i], "-p.device"))
         {
             if (++i == argc)
@@ -272,6 +750,32 @@ void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
                 USAGE_ERROR("Missing value for -p.time (producer runtime) option.")
             opts->producerTime = strtol(argv[i], nullptr, 10);
         }
+        else if (!strcmp(argv[i], "-p.content"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -p.content (producer content) option.")
+            opts->producerContent = ParseContentType(argv[i]);
+            if (opts->producerContent == CONTENT_TYPE_COUNT)
+                USAGE_ERROR("Invalid value for -p.content (producer content) option: " << argv[i])
+        }
+        else if (!strcmp(argv[i], "-p.content-seed"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -p.content-seed (producer content seed) option.")
+            opts->producerContentSeed = strtoul(argv[i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "-p.content-tile"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -p.content-tile (producer content tile) option.")
+            opts->producerContentTile = argv[i];
+        }
+        else if (!strcmp(argv[i], "-p.decode-id"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -p.decode-id (external source frame ID decoding) option.")
+            opts->producerDecodeIds = strtol(argv[i], nullptr, 10) != 0;
+        }
         else if (!strcmp(argv[i], "-c.device"))
         {
             if (++i == argc)
@@ -290,7 +794,187 @@ void ParseArguments(int argc, char* argv[], ProgramOptions* opts)
                 USAGE_ERROR("Missing value for -c.rdma (consumer RDMA) option.")
             opts->consumerRDMA = strtol(argv[i], nullptr, 10) != 0;
         }
+        else if (!strcmp(argv[i], "-c.convert"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -c.convert (consumer RGBA conversion) option.")
+            opts->consumerConvert = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "-c.verify"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -c.verify (consumer frame verification) option.")
+            opts->consumerVerify = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "-c.resilient"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -c.resilient (consumer resilient capture) option.")
+            opts->consumerResilient = strtol(argv[i], nullptr, 10) != 0;
+        }
+        else if (!strcmp(argv[i], "-c.max-glitch"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -c.max-glitch (consumer maximum glitch duration) option.")
+            char* end = nullptr;
+            opts->consumerMaxGlitch = strtoul(argv[i], &end, 10);
+            if (*end || opts->consumerMaxGlitch == 0)
+                USAGE_ERROR("Invalid value for -c.max-glitch (consumer maximum glitch duration) option: " << argv[i])
+        }
+        else if (!strcmp(argv[i], "-c.snapshots"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for -c.snapshots (consumer glitch snapshot directory) option.")
+            opts->consumerSnapshots = argv[i];
+        }
+        else if (!strcmp(argv[i], "--ramp"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --ramp (ramp formats) option.")
+            if (!ParseFormats(argv[i], "--ramp (ramp formats)", &opts->rampFormats))
+                return false;
+        }
+        else if (!strcmp(argv[i], "--ramp-predict"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --ramp-predict (predicted formats) option.")
+            if (!ParseFormats(argv[i], "--ramp-predict (predicted formats)", &opts->rampPredictFormats))
+                return false;
+        }
+        else if (!strcmp(argv[i], "--ramp-output"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --ramp-output (ramp output file) option.")
+            opts->rampOutputFilename = argv[i];
+        }
+        else if (!strcmp(argv[i], "--daemon"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --daemon (daemon socket) option.")
+            opts->daemonSocket = argv[i];
+        }
+        else if (!strcmp(argv[i], "--plugin-path"))
+        {
+            if (++i == argc)
+                USAGE_ERROR("Missing value for --plugin-path (plugin search path) option.")
+            opts->pluginPath = argv[i];
+        }
+        else if (!strncmp(argv[i], "-p.", 3) || !strncmp(argv[i], "-c.", 3))
+        {
+            // The options of plugin backends, which are checked once the
+            // plugins have been loaded (see ResolvePlugins).
+            const char* option = argv[i];
+            if (++i == argc)
+                USAGE_ERROR("Missing value for " << option << " option.")
+            auto& options = option[1] == 'p' ? opts->producerPluginOptions : opts->consumerPluginOptions;
+            options[option + 3] = argv[i];
+        }
+    }
+    return true;
+}
+
+// Returns the plugin search path, which is the --plugin-path directories
+// followed by those in the environment and the plugins directory next to the
+// executable.
+static std::string PluginSearchPath(const ProgramOptions& opts)
+{
+    std::string path(opts.pluginPath);
+    const char* env = getenv(PLUGIN_PATH_VARIABLE);
+    if (env)
+        path += std::string(":") + env;
+
+    char exe[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length > 0)
+    {
+        std::string exePath(exe, length);
+        path += ":" + exePath.substr(0, exePath.find_last_of('/')) + "/plugins";
+    }
+    return path;
+}
+
+// Checks that every option given for a backend is declared by it (only plugin
+// backends declare options), then fills in the defaults of the others.
+template <typename Backend>
+static bool ResolvePluginOptions(const Backend* backend, const char* kind, char prefix,
+                                 std::map<std::string, std::string>* options)
+{
+    for (const auto& option : *options)
+    {
+        bool declared = backend && std::any_of(backend->options.begin(), backend->options.end(),
+            [&option](const PluginOption& o) { return o.name == option.first; });
+        if (!declared)
+        {
+            Error("Unknown option -" << prefix << "." << option.first << " for the " << kind << ".");
+            return false;
+        }
+    }
+    if (backend)
+    {
+        for (const auto& option : backend->options)
+            options->insert({ option.name, option.defaultValue });
+    }
+    return true;
+}
+
+// Looks up the plugin backends named by the -p and -c options and resolves
+// their options.
+static bool ResolvePlugins(ProgramOptions* opts)
+{
+    const ProducerBackend* producer = nullptr;
+    const ConsumerBackend* consumer = nullptr;
+    if (opts->producerType == PRODUCER_PLUGIN)
+    {
+        producer = PluginRegistry::FindProducer(opts->producerPlugin);
+        if (!producer)
+        {
+            Error("Invalid value for -p (producer) option: " << opts->producerPlugin);
+            return false;
+        }
     }
+    if (opts->consumerType == CONSUMER_PLUGIN)
+    {
+        consumer = PluginRegistry::FindConsumer(opts->consumerPlugin);
+        if (!consumer)
+        {
+            Error("Invalid value for -c (consumer) option: " << opts->consumerPlugin);
+            return false;
+        }
+    }
+    return ResolvePluginOptions(producer, "producer", 'p', &opts->producerPluginOptions) &&
+           ResolvePluginOptions(consumer, "consumer", 'c', &opts->consumerPluginOptions);
+}
+
+// Checks that the options do not rely on the frames being produced by the tool
+// when they are captured from an external source (-p none).
+static bool CheckExternalSource(const ProgramOptions& opts)
+{
+    if (opts.consumerType == CONSUMER_NONE)
+        USAGE_ERROR("The -p none option requires a consumer other than none.")
+    if (opts.consumerVerify)
+        USAGE_ERROR("The -c.verify option cannot be used with -p none since the frame contents are unknown.")
+    if (!opts.loadSchedule.Empty())
+        USAGE_ERROR("The --load option cannot be used with -p none.")
+    if (!opts.rampFormats.empty())
+        USAGE_ERROR("The --ramp option cannot be used with -p none.")
+    if (opts.restarts > 0)
+        USAGE_ERROR("The --restarts option cannot be used with -p none.")
+    if (opts.flightRecorderFilename.size() > 0)
+        USAGE_ERROR("The --flight-recorder option cannot be used with -p none.")
+    return true;
+}
+
+// Returns the parameters that a plugin backend is created with.
+static PluginParams MakePluginParams(const ProgramOptions& opts, bool producer)
+{
+    PluginParams params;
+    params.format = opts.format;
+    params.simulatedProcessing = opts.simulatedProcessing;
+    params.device = producer ? opts.producerDevice : opts.consumerDevice;
+    params.channel = producer ? opts.producerChannel : opts.consumerChannel;
+    params.rdma = producer ? opts.producerRDMA : opts.consumerRDMA;
+    params.options = producer ? opts.producerPluginOptions : opts.consumerPluginOptions;
+    return params;
 }
 
 static int RunSimulatedProcessing(size_t loops, const TestFormat& format)
@@ -310,7 +994,7 @@ static int RunSimulatedProcessing(size_t loops, const TestFormat& format)
     for (size_t i = 0; i < iterations; i++)
     {
         auto start = Clock::now();
-        CudaSimulateProcessing((uint32_t*)buf, format.width * format.height, loops);
+        CudaSimulateProcessing((uint32_t*)buf, format.totalBytes / sizeof(uint32_t), loops);
         auto end = Clock::now();
         durations.Append(start, end);
     }
@@ -321,47 +1005,219 @@ static int RunSimulatedProcessing(size_t loops, const TestFormat& format)
     return 0;
 }
 
-static void PrintLatencyResults(const ProgramOptions& opts, const std::vector<std::shared_ptr<Frame>>& frames)
+// Returns the console color used for the stages on the given side.
+static const std::string& StageColor(StageSide side)
+{
+    static const std::string none;
+    switch (side)
+    {
+        case STAGE_PRODUCER: return ConsoleColors::Cyan;
+        case STAGE_CONSUMER: return ConsoleColors::Magenta;
+        default:             return none;
+    }
+}
+
+static void AddMetrics(Metrics* metrics, const std::string& name, const DurationList& durations)
+{
+    (*metrics)[name + ".avg"] = durations.Avg().count();
+    (*metrics)[name + ".min"] = durations.Min().count();
+    (*metrics)[name + ".max"] = durations.Max().count();
+}
+
+// Returns the number of bursts of each length as "length x count" pairs.
+static std::string BurstSummary(const std::vector<size_t>& bursts)
+{
+    std::ostringstream ss;
+    for (size_t i = 0; i < bursts.size(); i++)
+    {
+        if (!bursts[i])
+            continue;
+        if (ss.tellp() > 0)
+            ss << ", ";
+        ss << (i + 1) << (i + 1 == bursts.size() ? "+" : "") << " x" << bursts[i];
+    }
+    return ss.tellp() > 0 ? ss.str() : "none";
+}
+
+static void PrintLossEvents(const LossAnalysis& loss, const Microseconds& frameInterval, Metrics* metrics)
+{
+    size_t skipBursts = 0;
+    size_t repeatBursts = 0;
+    for (const auto& event : loss.Events())
+        (event.repeat ? repeatBursts : skipBursts)++;
+
+    (*metrics)["loss.events"] = loss.Events().size();
+    (*metrics)["loss.skip-bursts"] = skipBursts;
+    (*metrics)["loss.repeat-bursts"] = repeatBursts;
+    (*metrics)["loss.longest-burst"] = loss.LongestBurst();
+    for (size_t c = 0; c < LOSS_CAUSE_COUNT; c++)
+        (*metrics)[std::string("loss.") + LossCauseName((LossCause)c)] = loss.Events((LossCause)c);
+    if (loss.Events().empty())
+        return;
+
+    Log(WarningColor(
+        "Loss Events (Bursts of Skipped or Repeated Frames)" << std::endl <<
+        "=========================================================" << std::endl <<
+        "Skip bursts:     " << skipBursts << " (" << loss.SkippedFrames() << " frames), lengths: " <<
+                               BurstSummary(loss.SkipBursts()) << std::endl <<
+        "Repeat bursts:   " << repeatBursts << " (" << loss.RepeatedFrames() << " frames), lengths: " <<
+                               BurstSummary(loss.RepeatBursts()) << std::endl <<
+        "Causes:          " <<
+        "producer = " << loss.Events(LOSS_CAUSE_PRODUCER) << ", " <<
+        "wire = " << loss.Events(LOSS_CAUSE_WIRE) << ", " <<
+        "consumer = " << loss.Events(LOSS_CAUSE_CONSUMER) << ", " <<
+        "unknown = " << loss.Events(LOSS_CAUSE_UNKNOWN)));
+    if (loss.Intervals().Size())
+    {
+        Log(WarningColor(
+            "Interval:        " << loss.Intervals().Summary() << std::endl <<
+            "  (Frames)       " << loss.Intervals().SummaryInFrameIntervals(frameInterval)));
+        AddMetrics(metrics, "loss-interval", loss.Intervals());
+    }
+
+    // Compare the stages of the frames received just before each event with
+    // those of every frame to show which stage was running long.
+    const auto& markers = StageRegistry::Markers();
+    bool header = false;
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        const DurationList& preceding = loss.PrecedingStageTimes()[i];
+        if (!preceding.Size())
+            continue;
+        if (!header)
+        {
+            Log(std::endl << "Stages Before Loss (Average Microseconds, All Frames)" << std::endl <<
+                "=========================================================");
+            header = true;
+        }
+        Log(StageColor(markers[i].side) << std::left << std::setw(17) << (markers[i].label + ":")
+            << std::right << "before = " << std::setw(6) << preceding.Avg().count() << ", "
+            << "all = " << std::setw(6) << loss.StageTimes()[i].Avg().count() << ", "
+            << "max = " << std::setw(6) << preceding.Max().count() << ConsoleColors::Reset);
+        (*metrics)[std::string("loss-") + markers[i].metric + ".avg"] = preceding.Avg().count();
+    }
+    Log("");
+}
+
+// Prints the response of the latency to each transition of the load schedule
+// and writes it to the --load-output file.
+static void PrintLoadTransients(const ProgramOptions& opts, const std::vector<std::shared_ptr<Frame>>& frames,
+                                Metrics* metrics)
+{
+    TransientAnalysis analysis(frames, opts.loadSchedule, Microseconds(opts.format.frameRate.IntervalMicroseconds()),
+                               Microseconds(opts.loadBudget));
+    const auto& transients = analysis.Transients();
+    (*metrics)["load.transitions"] = transients.size();
+    if (transients.empty())
+    {
+        Warning("No load schedule transitions were measured; the schedule is counted from" << std::endl <<
+                "the start of streaming, so the transitions must come after the warmup frames." << std::endl);
+        return;
+    }
+
+    Log("Load Transitions (Microseconds)" << std::endl <<
+        "=========================================================");
+    int64_t peakLatency = 0;
+    int64_t settlingTime = 0;
+    size_t queueBuildUp = 0;
+    size_t overBudget = 0;
+    size_t skipped = 0;
+    size_t unsettled = 0;
+    for (const auto& t : transients)
+    {
+        std::ostringstream settling;
+        if (t.settled)
+            settling << t.settlingTime.count() << " (" << t.settlingFrames << " frames)";
+        else
+            settling << "not settled by the end of the segment";
+
+        Log("Frame " << t.transition.frame << ": " << t.transition.from << " -> " << t.transition.to <<
+            " loops" << (t.transition.ramp ? " (ramp)" : "") << std::endl <<
+            "  Latency:       baseline = " << t.baselineLatency.count() << ", peak = " << t.peakLatency.count() <<
+            ", settled = " << t.settledLatency.count() << std::endl <<
+            "  Over budget:   " << t.framesOverBudget << " / " << t.framesReceived << " frames over " <<
+            t.budget.count() << ", " << t.framesSkipped << " skipped" << std::endl <<
+            "  Queue:         " << t.queueBuildUp << " frames above " << t.baselineFramesInFlight << " in flight");
+        if (t.settled)
+            Log("  Settling:      " << settling.str());
+        else
+            Log(WarningColor("  Settling:      " << settling.str()));
+
+        peakLatency = std::max<int64_t>(peakLatency, t.peakLatency.count());
+        settlingTime = std::max<int64_t>(settlingTime, t.settlingTime.count());
+        queueBuildUp = std::max(queueBuildUp, t.queueBuildUp);
+        overBudget += t.framesOverBudget;
+        skipped += t.framesSkipped;
+        unsettled += t.settled ? 0 : 1;
+    }
+    Log("");
+
+    (*metrics)["load.peak-latency.max"] = peakLatency;
+    (*metrics)["load.settling.max"] = settlingTime;
+    (*metrics)["load.queue.max"] = queueBuildUp;
+    (*metrics)["load.over-budget"] = overBudget;
+    (*metrics)["load.skipped"] = skipped;
+    (*metrics)["load.unsettled"] = unsettled;
+
+    if (opts.loadOutputFilename.size() > 0)
+    {
+        std::ofstream loadFile(opts.loadOutputFilename);
+        if (loadFile.is_open())
+        {
+            analysis.WriteTransients(loadFile);
+            Log("Load transitions written to '" << opts.loadOutputFilename << "'" << std::endl);
+        }
+        else
+        {
+            Error("Could not open load transitions file: " << opts.loadOutputFilename);
+        }
+    }
+}
+
+static void PrintLatencyResults(const ProgramOptions& opts, const std::vector<std::shared_ptr<Frame>>& frames,
+                                const LossAnalysis& loss, Metrics* metrics)
 {
     if (frames.size() == 0)
         return;
 
-    uint32_t expectedFrame = frames[0]->Number();
-    size_t skippedFrames = 0;
-    size_t duplicateReceives = 0;
-    DurationList processingTimes;
-    DurationList renderTimes;
-    DurationList fromGpuTimes;
-    DurationList writeTimes;
-    DurationList vsyncTimes;
-    DurationList wireTimes;
-    DurationList readTimes;
-    DurationList toGpuTimes;
+    // The stages are derived from the registered markers, and the times of
+    // each side are the sums of the stages on that side.
+    const auto& markers = StageRegistry::Markers();
+    std::vector<DurationList> stageTimes(markers.size());
     DurationList producerTimes;
+    DurationList outputTimes;
+    DurationList transferTimes;
     DurationList consumerTimes;
     DurationList totalTimes;
     DurationList estimatedAppTimes;
+
+    uint32_t expectedFrame = frames[0]->Number();
+    size_t skippedFrames = 0;
+    size_t duplicateReceives = 0;
+    size_t corruptedFrames = 0;
     for (const auto& f : frames)
     {
         skippedFrames += f->Number() - expectedFrame;
         duplicateReceives += f->DuplicateReceives();
+        corruptedFrames += f->MismatchedLines() ? 1 : 0;
         expectedFrame = f->Number() + 1;
 
-        processingTimes.Append(f->ProcessingStart(), f->RenderStart());
-        renderTimes.Append(f->RenderStart(), f->RenderEnd());
-        fromGpuTimes.Append(f->RenderEnd(), f->CopiedFromGPU());
-        writeTimes.Append(f->CopiedFromGPU(), f->WriteEnd());
-        vsyncTimes.Append(f->WriteEnd(), f->ScanoutStart());
-        wireTimes.Append(f->ScanoutStart(), f->FrameReceived());
-        readTimes.Append(f->FrameReceived(), f->ReadEnd());
-        toGpuTimes.Append(f->ReadEnd(), f->CopiedToGPU());
-        producerTimes.Append(f->ProcessingStart(), f->WriteEnd());
-        consumerTimes.Append(f->FrameReceived(), f->CopiedToGPU());
-        totalTimes.Append(f->ProcessingStart(), f->CopiedToGPU());
-
-        Microseconds consumerTime = std::chrono::duration_cast<Microseconds>(f->CopiedToGPU() - f->FrameReceived());
-        Microseconds producerTime = std::chrono::duration_cast<Microseconds>(f->WriteEnd() - f->ProcessingStart());
-        estimatedAppTimes.Append(consumerTime + producerTime);
+        Microseconds sideTimes[STAGE_TOOL + 1] = {};
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (f->StageMarkers(i, &start, &end))
+            {
+                stageTimes[i].Append(f->Elapsed(start, end));
+                sideTimes[markers[i].side] += f->Elapsed(start, end);
+            }
+        }
+        producerTimes.Append(sideTimes[STAGE_PRODUCER]);
+        outputTimes.Append(sideTimes[STAGE_OUTPUT]);
+        transferTimes.Append(sideTimes[STAGE_TRANSFER]);
+        consumerTimes.Append(sideTimes[STAGE_CONSUMER]);
+        totalTimes.Append(f->Elapsed(MARKER_PROCESSING_START, MARKER_COPIED_TO_GPU));
+        estimatedAppTimes.Append(sideTimes[STAGE_CONSUMER] + sideTimes[STAGE_PRODUCER]);
     }
     if (skippedFrames || duplicateReceives)
     {
@@ -370,19 +1226,38 @@ static void PrintLatencyResults(const ProgramOptions& opts, const std::vector<st
                 "Frames skipped:  " << skippedFrames << std::endl <<
                 "Frames repeated: " << duplicateReceives << std::endl);
     }
+    PrintLossEvents(loss, Microseconds(opts.format.frameRate.IntervalMicroseconds()), metrics);
+    if (corruptedFrames)
+    {
+        Warning("Frames did not match the expected contents!" << std::endl <<
+                "Frames received:  " << frames.size() << std::endl <<
+                "Frames corrupted: " << corruptedFrames << std::endl);
+    }
+
+    if constexpr (INSTRUMENTATION == INSTRUMENTATION_OFF)
+    {
+        Log("Total:           " << totalTimes.Summary() << std::endl);
+        Log("The stage times are not recorded with INSTRUMENTATION_LEVEL=off." << std::endl);
+        AddMetrics(metrics, "total", totalTimes);
+        (*metrics)["skipped"] = skippedFrames;
+        (*metrics)["repeated"] = duplicateReceives;
+        if (opts.consumerVerify)
+            (*metrics)["corrupted"] = corruptedFrames;
+        return;
+    }
 
-    Log(ProducerColor("CUDA Processing: " << processingTimes.Summary()));
-    Log(ProducerColor("Render on GPU:   " << renderTimes.Summary()));
-    Log(ProducerColor("Copy To Host:    " << fromGpuTimes.Summary()));
-    Log(ProducerColor("Write To HW:     " << writeTimes.Summary()));
-    Log("Vsync Wait:      " << vsyncTimes.Summary());
-    Log("Wire Time:       " << wireTimes.Summary());
-    Log(ConsumerColor("Read From HW:    " << readTimes.Summary()));
-    Log(ConsumerColor("Copy To GPU:     " << toGpuTimes.Summary()));
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        if (stageTimes[i].Size())
+        {
+            Log(StageColor(markers[i].side) << std::left << std::setw(17) << (markers[i].label + ":")
+                << std::right << stageTimes[i].Summary() << ConsoleColors::Reset);
+        }
+    }
     Log("=========================================================");
     Log("Total:           " << totalTimes.Summary() << std::endl << std::endl);
 
-    Microseconds frameInterval(1000000 / opts.format.frameRate);
+    Microseconds frameInterval(opts.format.frameRate.IntervalMicroseconds());
 
     Log(ProducerColor(
         "Producer (Process and Write to HW)" << std::endl <<
@@ -412,9 +1287,9 @@ static void PrintLatencyResults(const ProgramOptions& opts, const std::vector<st
         // The exact GStreamer producer wire time is unknown, but we know that the nveglglessink
         // component adds a fair amount of latency that is included in the "wire" times, so we'll
         // add that to the processing times to guess the overall latency.
-        avgFrames += (wireTimes.Avg() + frameInterval).count() / frameInterval.count();
-        minFrames += (wireTimes.Min() + frameInterval).count() / frameInterval.count();
-        maxFrames += (wireTimes.Max() + frameInterval).count() / frameInterval.count();
+        avgFrames += (transferTimes.Avg() + frameInterval).count() / frameInterval.count();
+        minFrames += (transferTimes.Min() + frameInterval).count() / frameInterval.count();
+        maxFrames += (transferTimes.Max() + frameInterval).count() / frameInterval.count();
     }
     else
     {
@@ -444,175 +1319,952 @@ static void PrintLatencyResults(const ProgramOptions& opts, const std::vector<st
                 "include frames that were actually received, and the times" << std::endl <<
                 "include only the first instance each frame was received." << std::endl);
     }
+    else if (corruptedFrames)
+    {
+        Log(WarningColor(ss.str()));
+        Warning("Frames were received with corrupted lines, so these times" << std::endl <<
+                "may not reflect complete frames being delivered." << std::endl);
+    }
     else
     {
         Log(SuccessColor(ss.str()));
     }
 
-    if (vsyncTimes.Avg() > (frameInterval * 1.5f))
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        if (stageTimes[i].Size())
+            AddMetrics(metrics, markers[i].metric, stageTimes[i]);
+    }
+    AddMetrics(metrics, "total", totalTimes);
+    AddMetrics(metrics, "producer", producerTimes);
+    AddMetrics(metrics, "consumer", consumerTimes);
+    AddMetrics(metrics, "application", estimatedAppTimes);
+    (*metrics)["latency.avg"] = avgFrames * frameInterval.count();
+    (*metrics)["latency.min"] = minFrames * frameInterval.count();
+    (*metrics)["latency.max"] = maxFrames * frameInterval.count();
+    (*metrics)["latency-frames.avg"] = avgFrames;
+    (*metrics)["latency-frames.min"] = minFrames;
+    (*metrics)["latency-frames.max"] = maxFrames;
+    (*metrics)["skipped"] = skippedFrames;
+    (*metrics)["repeated"] = duplicateReceives;
+    if (opts.consumerVerify)
+        (*metrics)["corrupted"] = corruptedFrames;
+
+    if (outputTimes.Avg() > (frameInterval * 1.5f))
     {
-        Warning("The average vsync interval (" << vsyncTimes.Avg().count() << ") exceeded the" << std::endl <<
+        Warning("The average vsync interval (" << outputTimes.Avg().count() << ") exceeded the" << std::endl <<
                 "the expected vsync interval (" << frameInterval.count() << ") by a large amount." << std::endl <<
                 "This could be due to the producer locking to a lower" << std::endl <<
                 "framerate that can't be controlled by the producer API." << std::endl <<
                 "Please check the actual vsync interval that was used and" << std::endl <<
                 "consider running the test using another format that uses" << std::endl <<
-                "the actual frame interval that was used (" << (1000000.0f / vsyncTimes.Avg().count()) << ").");
+                "the actual frame interval that was used (" << (1000000.0f / outputTimes.Avg().count()) << ").");
     }
 }
 
-static void WriteLatencyResults(std::ofstream& file, const std::vector<std::shared_ptr<Frame>>& frames)
+// Prints the arrival jitter, drops and capture stage times of the frames
+// captured from an external source (see CaptureAnalysis), which replace the
+// latency results since nothing was produced.
+static void PrintCaptureResults(const ProgramOptions& opts, const ExternalSource& source,
+                                const std::vector<std::shared_ptr<Frame>>& frames, Metrics* metrics)
 {
-    if (!file.is_open() || frames.size() == 0)
+    if (frames.size() == 0)
         return;
 
-    file << "Frame,Count,Frame Start Timestamp,Frame Interval,Process,Render,Copy To SYS,"
-         << "Write to HW,VSync,Wire,Read from HW,Copy to GPU" << std::endl;
+    Microseconds frameInterval(opts.format.frameRate.IntervalMicroseconds());
+    CaptureAnalysis analysis(frames, source.Captures(), frameInterval);
 
-    auto firstFrame = frames[0]->Number();
-    auto previousStartTime = frames[0]->ProcessingStart().time_since_epoch();
-    for (const auto& f : frames)
+    if (!source.DriverSequence())
     {
-        file << (f->Number() - firstFrame) << ","
-             << (f->DuplicateReceives() + 1) << ","
-             << std::chrono::duration_cast<Microseconds>(f->ProcessingStart().time_since_epoch()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->ProcessingStart().time_since_epoch() - previousStartTime).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->RenderStart() - f->ProcessingStart()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->RenderEnd() - f->RenderStart()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->CopiedFromGPU() - f->RenderEnd()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->WriteEnd() - f->CopiedFromGPU()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->ScanoutStart() - f->WriteEnd()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->FrameReceived() - f->ScanoutStart()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->ReadEnd() - f->FrameReceived()).count() << ","
-             << std::chrono::duration_cast<Microseconds>(f->CopiedToGPU() - f->ReadEnd()).count() << std::endl;
-        previousStartTime = f->ProcessingStart().time_since_epoch();
+        Warning("The consumer does not give the driver sequence numbers of the captured" << std::endl <<
+                "frames, so the frames dropped by the capture cannot be detected." << std::endl);
     }
+    else if (analysis.DroppedFrames())
+    {
+        Warning("Frames were dropped by the capture!" << std::endl <<
+                "Frames received: " << frames.size() << std::endl <<
+                "Frames dropped:  " << analysis.DroppedFrames() << std::endl <<
+                "Drop events:     " << analysis.DropEvents() << std::endl <<
+                "Longest drop:    " << analysis.LongestDrop() << " frames" << std::endl);
+    }
+
+    Log("Capture Arrivals (" << (analysis.DriverTimes() ? "Driver Timestamps" : "Receive Times") << ")" << std::endl <<
+        "=========================================================" << std::endl <<
+        "Interval:        " << analysis.Intervals().Summary() << std::endl <<
+        "  (Frames)       " << analysis.Intervals().SummaryInFrameIntervals(frameInterval) << std::endl <<
+        "Jitter:          " << analysis.Jitter().Summary() << std::endl);
+
+    if (source.DecodeIds())
+    {
+        if (!analysis.DecodedIds())
+        {
+            Warning("No embedded frame IDs were decoded, so the source may not be a" << std::endl <<
+                    "loopback-latency producer or may use a different format (see -f)." << std::endl);
+        }
+        else
+        {
+            std::ostringstream ss;
+            ss << "Embedded Frame IDs" << std::endl
+               << "=========================================================" << std::endl
+               << "Decoded:         " << analysis.DecodedIds() << " / " << frames.size() << std::endl
+               << "Source skipped:  " << analysis.SourceSkipped() << std::endl
+               << "Source repeated: " << analysis.SourceRepeated() << std::endl;
+            if (analysis.UndecodedIds() || analysis.SourceSkipped() || analysis.SourceRepeated())
+                Log(WarningColor(ss.str()));
+            else
+                Log(ss.str());
+        }
+        (*metrics)["capture.decoded"] = analysis.DecodedIds();
+        (*metrics)["capture.source-skipped"] = analysis.SourceSkipped();
+        (*metrics)["capture.source-repeated"] = analysis.SourceRepeated();
+    }
+
+    AddMetrics(metrics, "capture.interval", analysis.Intervals());
+    AddMetrics(metrics, "capture.jitter", analysis.Jitter());
+    (*metrics)["capture.dropped"] = analysis.DroppedFrames();
+    (*metrics)["capture.drop-events"] = analysis.DropEvents();
+    (*metrics)["capture.longest-drop"] = analysis.LongestDrop();
+
+    if constexpr (INSTRUMENTATION == INSTRUMENTATION_OFF)
+    {
+        Log("The stage times are not recorded with INSTRUMENTATION_LEVEL=off." << std::endl);
+        return;
+    }
+
+    // Only the consumer stages are recorded, and the time from the driver
+    // capture to the dequeue takes the place of the wire time.
+    const auto& markers = StageRegistry::Markers();
+    std::vector<DurationList> stageTimes(markers.size());
+    DurationList consumerTimes;
+    for (const auto& f : frames)
+    {
+        Microseconds consumerTime(0);
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (markers[i].side == STAGE_CONSUMER && f->StageMarkers(i, &start, &end))
+            {
+                stageTimes[i].Append(f->Elapsed(start, end));
+                consumerTime += f->Elapsed(start, end);
+            }
+        }
+        consumerTimes.Append(consumerTime);
+    }
+
+    Log("Capture Stages (Microseconds)" << std::endl <<
+        "=========================================================");
+    if (analysis.DequeueTimes().Size())
+    {
+        Log(ConsumerColor(std::left << std::setw(17) << "Dequeue:" << std::right << analysis.DequeueTimes().Summary()));
+        AddMetrics(metrics, "capture.dequeue", analysis.DequeueTimes());
+    }
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        if (stageTimes[i].Size())
+        {
+            Log(StageColor(markers[i].side) << std::left << std::setw(17) << (markers[i].label + ":")
+                << std::right << stageTimes[i].Summary() << ConsoleColors::Reset);
+            AddMetrics(metrics, markers[i].metric, stageTimes[i]);
+        }
+    }
+    Log("=========================================================");
+    Log("Consumer:        " << consumerTimes.Summary() << std::endl);
+    AddMetrics(metrics, "consumer", consumerTimes);
 }
 
-int main(int argc, char* argv[])
+static void AddThreadMetrics(Metrics* metrics, const std::string& name, const ThreadStatsList& stats)
 {
-    ProgramOptions opts;
-    ParseArguments(argc, argv, &opts);
+    if (stats.Size() > 0)
+    {
+        AddMetrics(metrics, "cpu." + name + ".on", stats.OnCpu());
+        AddMetrics(metrics, "cpu." + name + ".off", stats.OffCpu());
+        (*metrics)["cpu." + name + ".preempted"] = stats.PreemptedCount();
+    }
 
-    if (opts.producerType == PRODUCER_UNKNOWN &&
-        opts.consumerType == CONSUMER_UNKNOWN &&
-        opts.simulatedProcessing > 0)
+    const PerfStatsList& perf = stats.Perf();
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
     {
-        return RunSimulatedProcessing(opts.simulatedProcessing, opts.format);
+        PerfCounter counter = (PerfCounter)i;
+        if (perf.Has(counter))
+            (*metrics)["perf." + name + "." + PerfSample::Name(counter)] = perf.Avg(counter);
     }
+}
 
-    std::shared_ptr<Producer> producer;
+// Prints the number, rate and durations of the glitches recorded by a
+// resilient consumer (see Consumer::SetResilient).
+static void PrintGlitchResults(const std::vector<Glitch>& glitches,
+                               const std::vector<std::shared_ptr<Frame>>& frames, Metrics* metrics)
+{
+    size_t captures = 0;
+    size_t unrecovered = 0;
+    DurationList durations;
+    for (const auto& g : glitches)
+    {
+        captures += g.captures;
+        unrecovered += g.recovered ? 0 : 1;
+        durations.Append(g.start, g.end);
+    }
+
+    (*metrics)["glitch.count"] = glitches.size();
+    (*metrics)["glitch.captures"] = captures;
+    (*metrics)["glitch.unrecovered"] = unrecovered;
+    if (glitches.empty())
+    {
+        Log(SuccessColor("Glitches: none" << std::endl));
+        return;
+    }
+    AddMetrics(metrics, "glitch-duration", durations);
+
+    // The rate is given over the time that frames were received.
+    std::ostringstream rate;
+    if (frames.size() > 1)
+    {
+        auto elapsed = frames.back()->Time(MARKER_COPIED_TO_GPU) - frames.front()->Time(MARKER_COPIED_TO_GPU);
+        double hours = std::chrono::duration<double, std::ratio<3600>>(elapsed).count();
+        if (hours > 0)
+            rate << std::setprecision(3) << (glitches.size() / hours) << " per hour";
+    }
+
+    Log(WarningColor(
+        "Glitches (Unidentifiable Captures)" << std::endl <<
+        "=========================================================" << std::endl <<
+        "Glitches:        " << glitches.size() << " (" << captures << " captures, " <<
+                               unrecovered << " not recovered)" << std::endl <<
+        "Rate:            " << (rate.tellp() > 0 ? rate.str() : "unknown") << std::endl <<
+        "Duration:        " << durations.Summary() << std::endl));
+}
+
+// Prints the time spent on and off the CPU and the hardware counters of each
+// of the stages that start and end on the same thread, such that a slow stage
+// can be attributed to either the work itself (and whether that work is bound
+// by compute or memory) or to the thread being blocked or preempted.
+static void PrintThreadStats(const std::vector<std::shared_ptr<Frame>>& frames, Metrics* metrics)
+{
+    if (frames.size() == 0 || !(ThreadSample::Enabled() || PerfSample::Enabled()))
+        return;
+
+    // The transfer stages span the producer and consumer threads.
+    const auto& markers = StageRegistry::Markers();
+    std::vector<ThreadStatsList> stageStats(markers.size());
+    for (const auto& f : frames)
+    {
+        for (size_t i = 1; i < markers.size(); i++)
+        {
+            MarkerId start, end;
+            if (markers[i].side != STAGE_TRANSFER && f->StageMarkers(i, &start, &end))
+                stageStats[i].Append(f->Time(start), f->Thread(start), f->Time(end), f->Thread(end));
+        }
+    }
+
+    Log("Thread Statistics (Microseconds On and Off CPU)" << std::endl <<
+        "=========================================================");
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        if (markers[i].side == STAGE_TRANSFER)
+            continue;
+        Log(StageColor(markers[i].side) << markers[i].label << std::endl
+            << stageStats[i].Summary("   ") << ConsoleColors::Reset);
+        AddThreadMetrics(metrics, markers[i].metric, stageStats[i]);
+    }
+}
+
+// Returns the time from start to end, or a negative duration if end was never recorded.
+static Microseconds Elapsed(const TimePoint& start, const TimePoint& end)
+{
+    if (end == TimePoint())
+        return Microseconds(-1);
+    return std::chrono::duration_cast<Microseconds>(end - start);
+}
+
+static std::string FormatElapsed(const Microseconds& time)
+{
+    std::ostringstream ss;
+    if (time.count() < 0)
+        ss << std::setw(9) << "n/a";
+    else
+        ss << std::setw(9) << time.count();
+    return ss.str();
+}
+
+struct StartupTimes
+{
+    StartupTimes()
+        : producerInitialize(-1)
+        , producerStart(-1)
+        , producerFirstFrame(-1)
+        , consumerInitialize(-1)
+        , consumerStart(-1)
+        , consumerFirstFrame(-1)
+        , cudaInitialize(-1)
+        , setup(-1)
+    {}
+
+    TimePoint producerStreamStart;
+    Microseconds producerInitialize;
+    Microseconds producerStart;
+    Microseconds producerFirstFrame;
+
+    TimePoint consumerStreamStart;
+    Microseconds consumerInitialize;
+    Microseconds consumerStart;
+    Microseconds consumerFirstFrame;
+
+    Microseconds cudaInitialize;
+    Microseconds setup;
+};
+
+static void AddStartupMetric(Metrics* metrics, const std::string& name, const Microseconds& time)
+{
+    if (time.count() >= 0)
+        (*metrics)[name] = time.count();
+}
+
+static void PrintStartupResults(const StartupTimes& startup, const Producer& producer,
+                                const Consumer* consumer, Metrics* metrics)
+{
+    Log("Setup (Microseconds)" << std::endl <<
+        "=========================================================" << std::endl <<
+        "   CUDA context creation:     " << FormatElapsed(startup.cudaInitialize) << std::endl <<
+        "   Total (until streaming):   " << FormatElapsed(startup.setup) << std::endl);
+    AddStartupMetric(metrics, "startup.cuda", startup.cudaInitialize);
+    AddStartupMetric(metrics, "startup.total", startup.setup);
+
+    // Note that the startup phases include any work done when the producer
+    // and consumer are constructed, which is not included in Initialize().
+    Log(ProducerColor(
+        "Producer Startup (Microseconds)" << std::endl <<
+        "=========================================================" << std::endl <<
+        producer.StartupPhases().Summary("   ") <<
+        "   ---------------------------------------" << std::endl <<
+        "   Initialize():              " << FormatElapsed(startup.producerInitialize) << std::endl <<
+        "   StartStreaming():          " << FormatElapsed(startup.producerStart) << std::endl <<
+        "   Time to first frame:       " << FormatElapsed(startup.producerFirstFrame) << std::endl));
+    AddStartupMetric(metrics, "startup.producer.initialize", startup.producerInitialize);
+    AddStartupMetric(metrics, "startup.producer.start", startup.producerStart);
+    AddStartupMetric(metrics, "startup.producer.first-frame", startup.producerFirstFrame);
+
+    if (consumer)
+    {
+        Log(ConsumerColor(
+            "Consumer Startup (Microseconds)" << std::endl <<
+            "=========================================================" << std::endl <<
+            consumer->StartupPhases().Summary("   ") <<
+            "   ---------------------------------------" << std::endl <<
+            "   Initialize():              " << FormatElapsed(startup.consumerInitialize) << std::endl <<
+            "   StartStreaming():          " << FormatElapsed(startup.consumerStart) << std::endl <<
+            "   Time to first capture:     " << FormatElapsed(startup.consumerFirstFrame) << std::endl));
+        AddStartupMetric(metrics, "startup.consumer.initialize", startup.consumerInitialize);
+        AddStartupMetric(metrics, "startup.consumer.start", startup.consumerStart);
+        AddStartupMetric(metrics, "startup.consumer.first-frame", startup.consumerFirstFrame);
+    }
+}
+
+// Returns whether the producer and consumer can be initialized at the same time.
+// The following ordering constraints apply:
+//
+//   1. The producer is always initialized and started on the main thread, since
+//      GLFW and GTK windows must be created and managed by that thread.
+//   2. An AJA producer and consumer that share a device must be initialized in
+//      sequence since the producer clears all of the device routing.
+//   3. The consumer only starts streaming once the producer is streaming.
+//
+// Any other combination only shares the CUDA context, which is thread safe.
+static bool CanInitializeConcurrently(const ProgramOptions& opts)
+{
+    if (opts.producerType == PRODUCER_AJA && opts.consumerType == CONSUMER_AJA)
+    {
+        const std::string producerDevice(opts.producerDevice.empty() ? "0" : opts.producerDevice);
+        const std::string consumerDevice(opts.consumerDevice.empty() ? "0" : opts.consumerDevice);
+        return producerDevice != consumerDevice;
+    }
+    return true;
+}
+
+// Initializes and starts the producer, recording the startup times.
+static bool InitializeProducer(Producer* producer, StartupTimes* startup)
+{
+    TimePoint initializeStart = Clock::now();
+    if (!producer->Initialize())
+    {
+        Error("Failed to initialize producer.");
+        return false;
+    }
+
+    startup->producerStreamStart = Clock::now();
+    startup->producerInitialize = Elapsed(initializeStart, startup->producerStreamStart);
+    if (!producer->StartStreaming())
+    {
+        Error("Failed to start producer streaming.");
+        return false;
+    }
+    startup->producerStart = Elapsed(startup->producerStreamStart, Clock::now());
+
+    return true;
+}
+
+// Initializes the consumer, recording the startup time.
+static bool InitializeConsumer(Consumer* consumer, StartupTimes* startup)
+{
+    TimePoint initializeStart = Clock::now();
+    if (!consumer->Initialize())
+    {
+        Error("Failed to initialize consumer.");
+        return false;
+    }
+    startup->consumerInitialize = Elapsed(initializeStart, Clock::now());
+
+    return true;
+}
+
+struct RestartTimes
+{
+    DurationList stopTimes;
+    DurationList producerFirstFrames;
+    DurationList consumerFirstFrames;
+};
+
+// Waits for the producer to scan out its first frame since streaming was started.
+static TimePoint WaitForFirstFrame(const Producer* producer)
+{
+    const auto FIRST_FRAME_TIMEOUT = std::chrono::seconds(5);
+    TimePoint timeout = Clock::now() + FIRST_FRAME_TIMEOUT;
+    TimePoint firstFrame;
+    while ((firstFrame = producer->FirstFrameTime()) == TimePoint() && Clock::now() < timeout)
+    {
+        usleep(100);
+    }
+    return firstFrame;
+}
+
+// Repeatedly stops and restarts streaming in order to measure how long it takes
+// for the producer and consumer to recover (i.e. output and capture a frame).
+static bool MeasureRestarts(size_t count, Producer* producer, Consumer* consumer, RestartTimes* restarts)
+{
+    Log("Measuring " << count << " restarts...");
+    for (size_t i = 0; i < count; i++)
+    {
+        TimePoint stopStart = Clock::now();
+        if (consumer)
+            consumer->StopStreaming();
+        producer->StopStreaming();
+
+        TimePoint restartStart = Clock::now();
+        restarts->stopTimes.Append(stopStart, restartStart);
+
+        if (!producer->StartStreaming())
+        {
+            Error("Failed to restart producer streaming.");
+            return false;
+        }
+
+        if (consumer)
+        {
+            consumer->ResetFirstCapture();
+            if (!consumer->StartStreaming())
+            {
+                Error("Failed to restart consumer streaming.");
+                return false;
+            }
+            bool captured = consumer->CaptureFrames(1, 0);
+            AsyncLog::Flush();
+            if (!captured)
+            {
+                Error("Failure occurred during frame capture after restart.");
+                return false;
+            }
+            restarts->consumerFirstFrames.Append(restartStart, consumer->FirstCaptureTime());
+        }
+
+        TimePoint firstFrame = WaitForFirstFrame(producer);
+        if (firstFrame == TimePoint())
+        {
+            Error("The producer did not output a frame after restarting.");
+            return false;
+        }
+        restarts->producerFirstFrames.Append(restartStart, firstFrame);
+    }
+    Log("Done!" << std::endl);
+
+    return true;
+}
+
+static void PrintRestartResults(const RestartTimes& restarts, const Consumer* consumer, Metrics* metrics)
+{
+    std::ostringstream ss;
+    ss << "Restart Recovery (" << restarts.stopTimes.Size() << " restarts)" << std::endl
+       << "=========================================================" << std::endl
+       << "   Stop Streaming:        " << restarts.stopTimes.Summary() << std::endl
+       << "   Producer First Frame:  " << restarts.producerFirstFrames.Summary() << std::endl;
+    AddMetrics(metrics, "restart.stop", restarts.stopTimes);
+    AddMetrics(metrics, "restart.producer.first-frame", restarts.producerFirstFrames);
+    if (consumer)
+    {
+        ss << "   Consumer First Frame:  " << restarts.consumerFirstFrames.Summary() << std::endl;
+        AddMetrics(metrics, "restart.consumer.first-frame", restarts.consumerFirstFrames);
+    }
+    Log(ss.str());
+}
+
+static void WriteLatencyResults(std::ofstream& file, const ProgramOptions& opts, const SystemAudit& audit,
+                                const std::vector<std::shared_ptr<Frame>>& frames)
+{
+    if (!file.is_open() || frames.size() == 0)
+        return;
+
+    // Tag the results with the scenario and configuration that produced them,
+    // along with the system settings that they were measured with.
+    file << "# scenario=" << opts.scenario.Name()
+         << ",config=" << ConfigurationHash(opts) << std::endl;
+    for (const auto& entry : audit.Entries())
+        file << "# " << entry.first << "=" << entry.second << std::endl;
+
+    StageExport::WriteStageComment(file);
+
+    file << "Frame,Count,Frame Start Timestamp,Frame Interval";
+    StageExport::WriteStageLabels(file);
+    file << std::endl;
+
+    // Frames captured from an external source start when they are copied to
+    // the GPU, since that is the first marker that is always recorded for them.
+    MarkerId startMarker = frames[0]->Recorded(MARKER_PROCESSING_START) ? MARKER_PROCESSING_START : MARKER_COPIED_TO_GPU;
+    auto firstFrame = frames[0]->Number();
+    auto previousStartTime = frames[0]->Time(startMarker).time_since_epoch();
+    for (const auto& f : frames)
+    {
+        auto startTime = f->Time(startMarker).time_since_epoch();
+        file << (f->Number() - firstFrame) << ","
+             << (f->DuplicateReceives() + 1) << ","
+             << std::chrono::duration_cast<Microseconds>(startTime).count() << ","
+             << std::chrono::duration_cast<Microseconds>(startTime - previousStartTime).count();
+        StageExport::WriteStageTimes(file, *f);
+        file << std::endl;
+        previousStartTime = startTime;
+    }
+}
+
+// Creates the producer and consumer given by the options and applies the
+// options that must be set before they are initialized.
+static bool CreateBackends(const ProgramOptions& opts, int* argc, char*** argv,
+                           std::shared_ptr<Producer>* producer, std::shared_ptr<Consumer>* consumer)
+{
     switch (opts.producerType)
     {
         case PRODUCER_GL:
-            producer.reset(new GLProducer(opts.format, opts.simulatedProcessing));
+            producer->reset(new GLProducer(opts.format, opts.simulatedProcessing));
             break;
 #ifdef ENABLE_AJA
         case PRODUCER_AJA:
-            producer.reset(new AJAProducer(opts.format, opts.producerDevice, opts.producerChannel, opts.simulatedProcessing, opts.producerRDMA));
+            producer->reset(new AJAProducer(opts.format, opts.producerDevice, opts.producerChannel, opts.simulatedProcessing, opts.producerRDMA));
             break;
 #endif
         case PRODUCER_GSTREAMER:
-            producer.reset(new GStreamerProducer(&argc, &argv, opts.format, opts.simulatedProcessing, opts.producerRDMA));
+            producer->reset(new GStreamerProducer(argc, argv, opts.format, opts.simulatedProcessing, opts.producerRDMA));
+            break;
+        case PRODUCER_PLUGIN:
+            producer->reset(PluginRegistry::FindProducer(opts.producerPlugin)->create(MakePluginParams(opts, true)));
+            if (!*producer)
+            {
+                Error("Failed to create the " << opts.producerPlugin << " producer.");
+                return false;
+            }
+            break;
+        case PRODUCER_NONE:
+            producer->reset(new ExternalSource(opts.format, opts.producerDecodeIds));
             break;
         default:
             Usage();
             Error("Missing required producer (-p) argument.");
-            return 1;
+            return false;
     }
+    (*producer)->SetContent(opts.producerContent, opts.producerContentSeed, opts.producerContentTile);
+    if (!opts.loadSchedule.Empty())
+        (*producer)->SetLoadSchedule(opts.loadSchedule);
 
-    std::shared_ptr<Consumer> consumer;
     switch (opts.consumerType)
     {
         case CONSUMER_V4L2:
-            consumer.reset(new V4L2Consumer(producer, opts.consumerDevice));
+            consumer->reset(new V4L2Consumer(*producer, opts.consumerDevice));
             break;
 #ifdef ENABLE_AJA
         case CONSUMER_AJA:
-            consumer.reset(new AJAConsumer(producer, opts.consumerDevice, opts.consumerChannel, opts.consumerRDMA));
+            consumer->reset(new AJAConsumer(*producer, opts.consumerDevice, opts.consumerChannel, opts.consumerRDMA));
             break;
 #endif
         case CONSUMER_GSTREAMER:
-            consumer.reset(new GStreamerConsumer(producer, &argc, &argv, opts.consumerDevice));
+            consumer->reset(new GStreamerConsumer(*producer, argc, argv, opts.consumerDevice));
+            break;
+        case CONSUMER_PLUGIN:
+            consumer->reset(PluginRegistry::FindConsumer(opts.consumerPlugin)->create(*producer, MakePluginParams(opts, false)));
+            if (!*consumer)
+            {
+                Error("Failed to create the " << opts.consumerPlugin << " consumer.");
+                return false;
+            }
             break;
         case CONSUMER_NONE:
             break;
         default:
             Usage();
             Error("Missing required consumer (-c) argument.");
-            return 1;
+            return false;
     }
 
-    std::ofstream outputFile;
-    if (opts.outputFilename.size() > 0)
+    if (*consumer && opts.consumerConvert)
     {
-        outputFile.open(opts.outputFilename);
-        if (outputFile.fail())
+        if (IsYUVFormat(opts.format.pixelFormat))
         {
-            Error("Could not open file for output: " << opts.outputFilename);
-            return 1;
+            (*consumer)->SetConvertToRGBA(true);
+        }
+        else
+        {
+            Warning("The -c.convert option only applies to YUV formats and will be ignored.");
         }
     }
+    if (*consumer && opts.consumerVerify)
+    {
+        (*consumer)->SetVerifyFrames(true);
+    }
+    if (*consumer && opts.consumerResilient)
+    {
+        (*consumer)->SetResilient(true, opts.consumerSnapshots, std::chrono::seconds(opts.consumerMaxGlitch));
+    }
+    else if (opts.consumerSnapshots.size())
+    {
+        Warning("The -c.snapshots option only applies with -c.resilient 1 and will be ignored.");
+    }
 
-    Log("Format: " << opts.format << std::endl);
+    return true;
+}
 
-    Log(ProducerColor("Producer: " << *producer));
-    if (!producer->Initialize())
+// Initializes the producer and consumer and starts them streaming, recording
+// the startup times.
+static bool StartBackends(const ProgramOptions& opts, Producer* producer, Consumer* consumer,
+                          StartupTimes* startup)
+{
+    // Determine whether the consumer can be initialized alongside the producer.
+    bool concurrentInitialize = consumer && !opts.serialInitialize && CanInitializeConcurrently(opts);
+
+    // Note that the producer is always initialized on the main thread since both
+    // GLFW and GTK require their windows to be created and managed by that thread.
+    std::future<bool> consumerInitialized;
+    if (concurrentInitialize)
     {
-        Error("Failed to initialize producer.");
-        return 1;
+        consumerInitialized = std::async(std::launch::async, InitializeConsumer, consumer, startup);
     }
 
-    if (!producer->StartStreaming())
+    if (!InitializeProducer(producer, startup))
     {
-        Error("Failed to start producer streaming.");
-        return 1;
+        return false;
     }
 
     if (consumer)
     {
-        Log(ConsumerColor("Consumer: " << *consumer));
-        if (!consumer->Initialize())
+        bool initialized = concurrentInitialize ? consumerInitialized.get()
+                                                : InitializeConsumer(consumer, startup);
+        if (!initialized)
         {
-            Error("Failed to initialize consumer.");
-            return 1;
+            return false;
         }
 
+        // The consumer starts streaming only once the producer is streaming
+        // so that it captures the produced frames rather than a missing signal.
+        startup->consumerStreamStart = Clock::now();
         if (!consumer->StartStreaming())
         {
             Error("Failed to start consumer streaming.");
+            return false;
+        }
+        startup->consumerStart = Elapsed(startup->consumerStreamStart, Clock::now());
+    }
+
+    return true;
+}
+
+// Keeps the frames produced for the producer time (-p.time), without the
+// warmup frames (-w), and samples the CPU utilization over the same time.
+static std::vector<std::shared_ptr<Frame>> ProduceFrames(const ProgramOptions& opts, Producer* producer,
+                                                         CpuUtilization* cpu)
+{
+    ProcessSample start = ProcessSample::Now();
+    producer->SetKeepProducedFrames(true);
+    sleep(opts.producerTime);
+    producer->SetKeepProducedFrames(false);
+    *cpu = CpuUtilization(start, ProcessSample::Now());
+
+    auto frames = producer->ProducedFrames();
+    frames.erase(frames.begin(), frames.begin() + std::min(opts.warmupFrames, frames.size()));
+    return frames;
+}
+
+// Prints the results of a producer-only run, adding them to the metrics with
+// the given name (e.g. vsync-on.fps or vsync-on-render.avg).
+static void PrintProducerRun(const ProgramOptions& opts, const std::string& title, const std::string& name,
+                             const ThroughputAnalysis& throughput, const CpuUtilization& cpu, bool vsync,
+                             Metrics* metrics)
+{
+    double outputHz = opts.format.frameRate.Hz();
+    Log(title << std::endl << "=========================================================");
+    if (throughput.Frames() < 2)
+    {
+        Warning("Too few frames were produced to measure the frame rate." << std::endl);
+        return;
+    }
+
+    std::ostringstream rate;
+    rate << std::fixed << std::setprecision(2) << throughput.FrameRate() << " fps";
+    if (vsync)
+        rate << " of the " << opts.format.frameRate << " Hz output";
+    else
+        rate << ", " << std::setprecision(1) << throughput.FrameRate() / outputHz << "x the " <<
+            opts.format.frameRate << " Hz output";
+    Log("Frames:          " << throughput.Frames() << " in " << std::fixed << std::setprecision(2) <<
+        throughput.Duration().count() / 1000000.0 << " s");
+    Log("Frame rate:      " << rate.str());
+    Log("CPU:             " << std::setprecision(1) << cpu.Total() << "% (user " << cpu.user <<
+        "%, system " << cpu.system << "%), where 100% is one core" << std::defaultfloat);
+    (*metrics)[name + ".fps"] = std::llround(throughput.FrameRate());
+    (*metrics)[name + ".cpu"] = std::llround(cpu.Total());
+
+    if (vsync)
+    {
+        std::ostringstream missed;
+        missed << "Missed vsyncs:   " << throughput.MissedVsyncs() << " (" << throughput.LateFrames() << " late frames)";
+        if (throughput.MissedVsyncs())
+            Log(WarningColor(missed.str()));
+        else
+            Log(missed.str());
+        Log("Scanout:         " << throughput.ScanoutIntervals().Summary());
+        (*metrics)[name + ".missed"] = throughput.MissedVsyncs();
+        (*metrics)[name + ".late-frames"] = throughput.LateFrames();
+        AddMetrics(metrics, name + "-scanout", throughput.ScanoutIntervals());
+    }
+
+    const auto& markers = StageRegistry::Markers();
+    for (size_t i = 1; i < markers.size(); i++)
+    {
+        const DurationList& times = throughput.StageTimes()[i];
+        if (!times.Size())
+            continue;
+        Log(StageColor(markers[i].side) << std::left << std::setw(17) << (markers[i].label + ":")
+            << std::right << times.Summary() << ConsoleColors::Reset);
+        AddMetrics(metrics, name + "-" + markers[i].metric, times);
+    }
+    Log("");
+}
+
+// Measures the producer without a consumer, which must already be streaming.
+// The producer is first measured at the vsync of its output for the achieved
+// frame rate and missed vsyncs, then with the vsync disabled (if it can be)
+// for the sustained frame rate, which is the headroom of the output path
+// before it becomes the bottleneck. Each run lasts for the producer time.
+static bool MeasureProducer(const ProgramOptions& opts, Producer* producer, Metrics* metrics)
+{
+    Microseconds frameInterval(opts.format.frameRate.IntervalMicroseconds());
+
+    Log("Producing frames with the vsync enabled for " << opts.producerTime << " seconds...");
+    CpuUtilization vsyncCpu;
+    auto vsyncFrames = ProduceFrames(opts, producer, &vsyncCpu);
+    Log("Done!" << std::endl);
+
+    std::vector<std::shared_ptr<Frame>> freeFrames;
+    CpuUtilization freeCpu;
+    if (producer->CanDisableVsync())
+    {
+        Log("Producing frames with the vsync disabled for " << opts.producerTime << " seconds...");
+        producer->StopStreaming();
+        producer->SetVsync(false);
+        bool started = producer->StartStreaming();
+        if (started)
+        {
+            freeFrames = ProduceFrames(opts, producer, &freeCpu);
+            producer->StopStreaming();
+        }
+
+        // Leave the producer streaming at the vsync as it was.
+        producer->SetVsync(true);
+        if (!started || !producer->StartStreaming())
+        {
+            Error("Failed to restart the producer streaming.");
+            return false;
+        }
+        Log("Done!" << std::endl);
+    }
+
+    PrintProducerRun(opts, "Producer Output (Vsync Enabled, Microseconds)", "vsync-on",
+                     ThroughputAnalysis(vsyncFrames, frameInterval), vsyncCpu, true, metrics);
+    if (producer->CanDisableVsync())
+    {
+        PrintProducerRun(opts, "Producer Throughput (Vsync Disabled, Microseconds)", "vsync-off",
+                         ThroughputAnalysis(freeFrames, frameInterval), freeCpu, false, metrics);
+        PrintThreadStats(freeFrames, metrics);
+    }
+    else
+    {
+        Log("The producer is paced by its output, so it cannot be measured with the vsync disabled." << std::endl);
+        PrintThreadStats(vsyncFrames, metrics);
+    }
+    return true;
+}
+
+// Measures the latency of the producer and consumer, which must already be
+// streaming, then prints and writes the results. The consumer is stopped once
+// the frames have been captured. The startup times are only reported if given,
+// which is for the first run after the producer and consumer are initialized.
+static int MeasureRun(const ProgramOptions& opts, Producer* producer, Consumer* consumer,
+                      const SystemAudit& audit, StartupTimes* startup)
+{
+    std::ofstream outputFile;
+    if (opts.outputFilename.size() > 0)
+    {
+        outputFile.open(opts.outputFilename);
+        if (outputFile.fail())
+        {
+            Error("Could not open file for output: " << opts.outputFilename);
+            return 1;
+        }
+    }
+
+    FlightRecorder flightRecorder;
+    if (consumer && opts.flightRecorderFilename.size() > 0)
+    {
+        if (opts.flightThreshold == 0)
+        {
+            Error("The --flight-recorder option requires a --flight-threshold.");
+            return 1;
+        }
+        size_t capacity = std::ceil(opts.flightWindow * opts.format.frameRate.Hz());
+        if (!flightRecorder.Start(opts.flightRecorderFilename, capacity, Microseconds(opts.flightThreshold)))
+        {
             return 1;
         }
+        consumer->SetFlightRecorder(&flightRecorder);
+    }
 
-        if (opts.simulatedProcessing > 0)
+    Metrics metrics;
+    if (consumer)
+    {
+        if (!opts.loadSchedule.Empty())
+        {
+            Log("Simulating processing with the load schedule " << opts.loadSchedule << "." << std::endl);
+        }
+        else if (opts.simulatedProcessing > 0)
         {
             Log("Simulating processing with " << opts.simulatedProcessing << " CUDA loops per frame." << std::endl);
         }
         Log("Measuring " << opts.numFrames << " frames...");
-        if (!consumer->CaptureFrames(opts.numFrames, opts.warmupFrames))
+        if (auto source = dynamic_cast<ExternalSource*>(producer))
+            source->ResetCaptures();
+        bool captured = consumer->CaptureFrames(opts.numFrames, opts.warmupFrames);
+        AsyncLog::Flush();
+
+        // Only the measured frames are recorded, not those received during restarts.
+        consumer->SetFlightRecorder(nullptr);
+        flightRecorder.Stop();
+
+        if (!captured)
         {
             Error("Failure occurred during frame capture.");
+            consumer->StopStreaming();
             return 1;
         }
         Log("Done!" << std::endl);
+    }
+    else
+    {
+        // The producer is restarted to measure it without the vsync, which
+        // overwrites its first frame time, so that is read beforehand.
+        if (startup)
+        {
+            startup->producerFirstFrame = Elapsed(startup->producerStreamStart, WaitForFirstFrame(producer));
+        }
+        if (!MeasureProducer(opts, producer, &metrics))
+        {
+            return 1;
+        }
+    }
+
+    // Read the first frame times before any restarts overwrite them.
+    if (startup && consumer)
+    {
+        startup->producerFirstFrame = Elapsed(startup->producerStreamStart, producer->FirstFrameTime());
+        startup->consumerFirstFrame = Elapsed(startup->consumerStreamStart, consumer->FirstCaptureTime());
+    }
 
+    // Copy the received frames and glitches before any restarts add to them.
+    std::vector<std::shared_ptr<Frame>> frames;
+    std::vector<Glitch> glitches;
+    if (consumer)
+    {
+        frames = consumer->GetReceivedFrames();
+        glitches = consumer->Glitches();
+    }
+
+    RestartTimes restarts;
+    if (opts.restarts > 0 && !MeasureRestarts(opts.restarts, producer, consumer, &restarts))
+    {
+        if (consumer)
+            consumer->StopStreaming();
+        return 1;
+    }
+
+    if (consumer)
+    {
         consumer->StopStreaming();
-        consumer->Close();
 
-        auto frames = consumer->GetReceivedFrames();
-        PrintLatencyResults(opts, frames);
-        WriteLatencyResults(outputFile, frames);
+        // Frames captured from an external source have no producer stages, so
+        // their latency cannot be measured. Their drops are still loss events.
+        LossAnalysis loss(frames, Microseconds(opts.format.frameRate.IntervalMicroseconds()));
+        if (auto source = dynamic_cast<const ExternalSource*>(producer))
+            PrintCaptureResults(opts, *source, frames, &metrics);
+        else
+            PrintLatencyResults(opts, frames, loss, &metrics);
+        PrintThreadStats(frames, &metrics);
+        if (!opts.loadSchedule.Empty())
+            PrintLoadTransients(opts, frames, &metrics);
+        if (opts.consumerResilient)
+            PrintGlitchResults(glitches, frames, &metrics);
+        WriteLatencyResults(outputFile, opts, audit, frames);
+        if (opts.traceFilename.size() > 0 && StageExport::WriteTrace(opts.traceFilename, frames))
+        {
+            Log("Trace written to '" << opts.traceFilename << "'");
+        }
+        if (opts.lossEventsFilename.size() > 0)
+        {
+            std::ofstream lossFile(opts.lossEventsFilename);
+            if (lossFile.is_open())
+            {
+                loss.WriteEvents(lossFile);
+                Log("Loss events written to '" << opts.lossEventsFilename << "'");
+            }
+            else
+            {
+                Error("Could not open loss events file: " << opts.lossEventsFilename);
+            }
+        }
     }
-    else
+
+    if (startup)
     {
-        Log(ConsumerColor("Consumer: None" << std::endl));
-        Log("Producing frames for " << opts.producerTime << " seconds...");
-        sleep(opts.producerTime);
-        Log("Done!");
+        PrintStartupResults(*startup, *producer, consumer, &metrics);
+    }
+    if (opts.restarts > 0)
+    {
+        PrintRestartResults(restarts, consumer, &metrics);
     }
 
-    producer->StopStreaming();
-    producer->Close();
+    if (flightRecorder.Filename().size() > 0)
+    {
+        Log("Flight recorder: " << flightRecorder.Triggers() << " frames exceeded " <<
+            flightRecorder.Threshold().count() << " us, " << flightRecorder.Dumps() <<
+            " windows written to '" << flightRecorder.Filename() << "'");
+        metrics["flight.triggers"] = flightRecorder.Triggers();
+    }
+
+    bool thresholdsPassed = true;
+    if (opts.scenario.HasThresholds())
+    {
+        thresholdsPassed = opts.scenario.CheckThresholds(metrics);
+    }
 
     if (outputFile.is_open())
     {
@@ -620,5 +2272,467 @@ int main(int argc, char* argv[])
         outputFile.close();
     }
 
+    if (!thresholdsPassed)
+    {
+        Error("Scenario '" << opts.scenario.Name() << "' failed one or more thresholds.");
+        return 1;
+    }
+
+    return 0;
+}
+
+// Prints the fitted bandwidth model and the times that it predicts for the
+// --ramp-predict formats, and adds the fitted times to the metrics.
+static void PrintBandwidthModel(const ProgramOptions& opts, const BandwidthModel& model, Metrics* metrics)
+{
+    auto fits = model.Fit();
+    if (fits.empty())
+    {
+        Warning("The ramp needs at least two different frame sizes to fit the stage times.");
+        return;
+    }
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    for (const auto& fit : fits)
+    {
+        ss << "   " << std::left << std::setw(17) << (fit.label + ":") << std::right
+           << std::setw(9) << fit.fixed << " +/- " << std::setw(7);
+        if (fit.HasErrors())
+            ss << fit.fixedError;
+        else
+            ss << "n/a";
+        ss << std::setw(10) << fit.perByte * 1e6 << " +/- " << std::setw(8);
+        if (fit.HasErrors())
+            ss << fit.perByteError * 1e6;
+        else
+            ss << "n/a";
+        ss << std::setw(10);
+        if (fit.Bandwidth() > 0)
+            ss << fit.Bandwidth();
+        else
+            ss << "inf";
+        if (fit.HasErrors())
+        {
+            // The interval is unbounded above if the time may not grow with
+            // the frame size (see StageFit::BandwidthHigh).
+            ss << "  [" << std::setw(8);
+            if (fit.BandwidthLow() > 0)
+                ss << fit.BandwidthLow();
+            else
+                ss << "inf";
+            ss << ", " << std::setw(8) << fit.BandwidthHigh() << "]";
+        }
+        else
+        {
+            ss << std::setw(22) << "n/a";
+        }
+        ss << std::setw(9) << std::setprecision(4) << fit.r2 << std::setprecision(1) << std::endl;
+
+        (*metrics)["ramp." + fit.metric + ".fixed"] = std::llround(fit.fixed);
+        (*metrics)["ramp." + fit.metric + ".us-per-mb"] = std::llround(fit.perByte * 1e6);
+    }
+    Log("Bandwidth Model (time = fixed + bytes / bandwidth, 95% confidence intervals)" << std::endl <<
+        "=========================================================" << std::endl <<
+        "   Stage               Fixed (us)             us / MB          MB/s          95% interval      R^2" << std::endl <<
+        ss.str());
+    if (model.Steps() < 3)
+    {
+        Log("At least three frame sizes are needed for the confidence intervals." << std::endl);
+    }
+
+    for (const auto& format : opts.rampPredictFormats)
+    {
+        std::ostringstream prediction;
+        prediction << std::fixed << std::setprecision(1);
+        for (const auto& fit : fits)
+        {
+            prediction << "   " << std::left << std::setw(17) << (fit.label + ":") << std::right
+                       << std::setw(9) << fit.Predict(format.totalBytes);
+            if (fit.HasErrors())
+                prediction << " +/- " << fit.PredictError(format.totalBytes);
+            prediction << std::endl;
+        }
+        Log("Predicted Times (Microseconds): " << format << " (" << format.totalBytes << " bytes)" << std::endl <<
+            "=========================================================" << std::endl <<
+            prediction.str());
+    }
+}
+
+// Measures the same path at each of the ramp formats in turn, creating and
+// initializing the producer and consumer for each of them, then fits the time
+// of each stage to a fixed time plus the time to move the bytes of the frame
+// (see BandwidthModel).
+static int RunRamp(const ProgramOptions& opts, int* argc, char*** argv)
+{
+    if (opts.consumerType == CONSUMER_NONE)
+    {
+        Error("The --ramp option requires a consumer.");
+        return 1;
+    }
+    for (const auto& format : opts.rampFormats)
+    {
+        if (format.frameRate != opts.rampFormats[0].frameRate)
+        {
+            Warning("The ramp formats have different frame rates, so the stages that wait for a" << std::endl <<
+                    "vsync will vary with the frame rate as well as the frame size.");
+            break;
+        }
+    }
+
+    std::ofstream outputFile;
+    if (opts.rampOutputFilename.size() > 0)
+    {
+        outputFile.open(opts.rampOutputFilename);
+        if (outputFile.fail())
+        {
+            Error("Could not open file for output: " << opts.rampOutputFilename);
+            return 1;
+        }
+    }
+
+    if (!opts.scenario.Name().empty())
+    {
+        Log("Scenario: " << opts.scenario.Name() << " (" << opts.scenario.Filename() << ")");
+    }
+    Log("Configuration: " << ConfigurationHash(opts));
+    Log("Instrumentation: " << InstrumentationName(INSTRUMENTATION) << std::endl);
+    if constexpr (INSTRUMENTATION == INSTRUMENTATION_OFF)
+    {
+        Log("Only the total time is fitted with INSTRUMENTATION_LEVEL=off." << std::endl);
+    }
+
+    SystemAudit audit;
+    audit.Collect(AuditIrqDevices(opts));
+    Log("System Settings" << (opts.tune ? " (tuned)" : "") << std::endl <<
+        "=========================================================" << std::endl << audit);
+
+    BandwidthModel model;
+    for (size_t i = 0; i < opts.rampFormats.size(); i++)
+    {
+        ProgramOptions step(opts);
+        step.format = opts.rampFormats[i];
+        Log("Ramp step " << (i + 1) << " / " << opts.rampFormats.size() << ": " << step.format <<
+            " (" << step.format.totalBytes << " bytes)");
+
+        std::shared_ptr<Producer> producer;
+        std::shared_ptr<Consumer> consumer;
+        StartupTimes startup;
+        if (!CreateBackends(step, argc, argv, &producer, &consumer) ||
+            !StartBackends(step, producer.get(), consumer.get(), &startup))
+        {
+            return 1;
+        }
+
+        bool captured = consumer->CaptureFrames(step.numFrames, step.warmupFrames);
+        AsyncLog::Flush();
+        consumer->StopStreaming();
+        consumer->Close();
+        producer->StopStreaming();
+        producer->Close();
+        if (!captured)
+        {
+            Error("Failure occurred during frame capture.");
+            return 1;
+        }
+
+        const auto& frames = consumer->GetReceivedFrames();
+        model.AddStep(step.format, frames);
+        DurationList totalTimes;
+        for (const auto& f : frames)
+            totalTimes.Append(f->Elapsed(MARKER_PROCESSING_START, MARKER_COPIED_TO_GPU));
+        Log("Total:           " << totalTimes.Summary() << std::endl);
+    }
+
+    Metrics metrics;
+    PrintBandwidthModel(opts, model, &metrics);
+
+    if (outputFile.is_open())
+    {
+        model.Write(outputFile);
+        Log("Ramp results written to '" << opts.rampOutputFilename << "'");
+    }
+
+    if (opts.scenario.HasThresholds() && !opts.scenario.CheckThresholds(metrics))
+    {
+        Error("Scenario '" << opts.scenario.Name() << "' failed one or more thresholds.");
+        return 1;
+    }
+
     return 0;
 }
+
+// Returns the configuration of the producer and consumer that cannot change
+// between the runs of the daemon mode, which is the resolved configuration
+// without the options that only apply to a run.
+static std::string DeviceConfiguration(const ProgramOptions& opts)
+{
+    ProgramOptions device(opts);
+    device.numFrames = 0;
+    device.warmupFrames = 0;
+    device.restarts = 0;
+    device.producerTime = 0;
+    device.consumerResilient = false;
+    return ResolvedConfiguration(device);
+}
+
+// Runs the daemon mode, where the producer keeps streaming while runs are
+// requested over the control socket (see Daemon). Each request is parsed on
+// top of the daemon's own options, so it only needs to give the options of
+// the run (e.g. -n, -w, -o, --trace or --scenario). The consumer only streams
+// during a run so that it does not queue frames in between.
+static int RunDaemon(const ProgramOptions& opts, Producer* producer, Consumer* consumer,
+                     const SystemAudit& audit, StartupTimes startup)
+{
+    if (consumer)
+    {
+        consumer->StopStreaming();
+    }
+    startup.producerFirstFrame = Elapsed(startup.producerStreamStart, WaitForFirstFrame(producer));
+    Metrics metrics;
+    PrintStartupResults(startup, *producer, consumer, &metrics);
+
+    Daemon::Server server;
+    if (!server.Listen(opts.daemonSocket))
+    {
+        return 1;
+    }
+    Log("Daemon listening on " << opts.daemonSocket << " (configuration " << ConfigurationHash(opts) << ")");
+
+    const std::string deviceConfiguration(DeviceConfiguration(opts));
+    std::vector<std::string> arguments;
+    int connection;
+    size_t runs = 0;
+    while ((connection = server.Accept(&arguments)) >= 0)
+    {
+        if (arguments.size() == 1 && arguments[0] == "--shutdown")
+        {
+            Log("Daemon shutdown requested.");
+            server.Finish(connection, 0);
+            break;
+        }
+
+        int status = 1;
+        {
+            Daemon::OutputRedirect redirect(connection);
+
+            std::vector<char*> args(1, const_cast<char*>("loopback-latency"));
+            for (const auto& argument : arguments)
+                args.push_back(const_cast<char*>(argument.c_str()));
+            ProgramOptions run(opts);
+            run.help = false;
+            if (!ParseArguments(args.size(), args.data(), &run) || !ResolvePlugins(&run))
+            {
+                status = 1;
+            }
+            else if (run.help)
+            {
+                Usage();
+                status = 0;
+            }
+            else if (run.producerType == PRODUCER_NONE && !CheckExternalSource(run))
+            {
+                // The restarts and the flight recorder are not part of the
+                // device configuration, so a request could still enable them.
+                status = 1;
+            }
+            else if (DeviceConfiguration(run) != deviceConfiguration)
+            {
+                Error("The daemon was started with a different producer or consumer configuration." << std::endl <<
+                      "Only the options of a run (e.g. -n, -w, -o, --trace, --loss-events, --restarts," << std::endl <<
+                      "-p.time, -c.resilient, the flight recorder and scenario thresholds) can be given.");
+            }
+            else
+            {
+                if (!run.scenario.Name().empty())
+                {
+                    Log("Scenario: " << run.scenario.Name() << " (" << run.scenario.Filename() << ")");
+                }
+                Log("Configuration: " << ConfigurationHash(run));
+                Log("Run: " << ++runs << std::endl);
+
+                if (consumer)
+                {
+                    consumer->ResetReceivedFrames();
+                    consumer->SetResilient(run.consumerResilient, run.consumerSnapshots,
+                                           std::chrono::seconds(run.consumerMaxGlitch));
+                    if (!consumer->StartStreaming())
+                    {
+                        Error("Failed to start consumer streaming.");
+                    }
+                    else
+                    {
+                        status = MeasureRun(run, producer, consumer, audit, nullptr);
+                    }
+                }
+                else
+                {
+                    status = MeasureRun(run, producer, consumer, audit, nullptr);
+                }
+            }
+            AsyncLog::Flush();
+        }
+        server.Finish(connection, status);
+        Log("Run " << runs << " finished with status " << status << ".");
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // A client of the daemon mode forwards all of its other arguments.
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--connect"))
+        {
+            if (i + 1 == argc)
+            {
+                Error("Missing value for --connect (daemon socket) option.");
+                return 1;
+            }
+            std::vector<std::string> arguments(argv + 1, argv + i);
+            arguments.insert(arguments.end(), argv + i + 2, argv + argc);
+            return Daemon::RunClient(argv[i + 1], arguments);
+        }
+    }
+
+    ProgramOptions opts;
+    if (!ParseArguments(argc, argv, &opts))
+    {
+        return 1;
+    }
+
+    PluginRegistry::Load(PluginSearchPath(opts));
+    if (opts.help)
+    {
+        Usage();
+        return 0;
+    }
+    if (!ResolvePlugins(&opts))
+    {
+        return 1;
+    }
+
+    // Progress from the stream and capture threads is written by a separate
+    // thread so that a slow terminal does not stall them.
+    AsyncLog::Start();
+
+    // The settings are restored when this goes out of scope.
+    LatencyTuning tuning;
+    if (opts.tune && !tuning.Apply())
+    {
+        Warning("Not all of the latency tuning settings could be applied.");
+    }
+
+    if constexpr (INSTRUMENTATION < INSTRUMENTATION_COUNTERS)
+    {
+        if (opts.cpuStats || opts.perfCounters)
+        {
+            Warning("Thread statistics and performance counters require a build with" << std::endl <<
+                    "INSTRUMENTATION_LEVEL=counters or higher (this build: " <<
+                    InstrumentationName(INSTRUMENTATION) << ").");
+            opts.cpuStats = false;
+            opts.perfCounters = false;
+        }
+    }
+
+    ThreadSample::Enable(opts.cpuStats);
+    if (opts.perfCounters && !PerfSample::Enable(true))
+    {
+        Warning("Hardware performance counters are unavailable; check that the kernel" << std::endl <<
+                "supports perf events and the value of /proc/sys/kernel/perf_event_paranoid.");
+        PerfSample::Enable(false);
+    }
+
+    if (opts.producerType == PRODUCER_UNKNOWN &&
+        opts.consumerType == CONSUMER_UNKNOWN &&
+        opts.simulatedProcessing > 0)
+    {
+        return RunSimulatedProcessing(opts.simulatedProcessing, opts.format);
+    }
+
+    if (opts.producerType == PRODUCER_NONE && !CheckExternalSource(opts))
+    {
+        return 1;
+    }
+
+    if (!opts.loadSchedule.Empty() && !opts.daemonSocket.empty())
+    {
+        Error("The --load option cannot be used in the daemon mode.");
+        return 1;
+    }
+
+    if (!opts.rampFormats.empty())
+    {
+        if (!opts.daemonSocket.empty())
+        {
+            Error("The --ramp option cannot be used in the daemon mode.");
+            return 1;
+        }
+        return RunRamp(opts, &argc, &argv);
+    }
+
+    // Start creating the CUDA context in the background since it can take a
+    // significant amount of time, and would otherwise be done by the first
+    // CUDA call made while initializing the producer or consumer.
+    StartupTimes startup;
+    TimePoint setupStart = Clock::now();
+    auto cudaInitialized = std::async(std::launch::async, []()
+    {
+        TimePoint start = Clock::now();
+        CudaInitialize();
+        return Elapsed(start, Clock::now());
+    });
+
+    std::shared_ptr<Producer> producer;
+    std::shared_ptr<Consumer> consumer;
+    if (!CreateBackends(opts, &argc, &argv, &producer, &consumer))
+    {
+        return 1;
+    }
+
+    if (!opts.scenario.Name().empty())
+    {
+        Log("Scenario: " << opts.scenario.Name() << " (" << opts.scenario.Filename() << ")");
+    }
+    Log("Configuration: " << ConfigurationHash(opts));
+    Log("Format: " << opts.format);
+    Log("Instrumentation: " << InstrumentationName(INSTRUMENTATION) << std::endl);
+    if (PerfSample::Enabled())
+    {
+        Log("Performance Counters: " << PerfSample::AvailableCounters() << std::endl);
+    }
+
+    SystemAudit audit;
+    audit.Collect(AuditIrqDevices(opts));
+    Log("System Settings" << (opts.tune ? " (tuned)" : "") << std::endl <<
+        "=========================================================" << std::endl << audit);
+
+    Log(ProducerColor("Producer: " << *producer));
+    if (consumer)
+    {
+        Log(ConsumerColor("Consumer: " << *consumer));
+    }
+    else
+    {
+        Log(ConsumerColor("Consumer: None" << std::endl));
+    }
+
+    if (!StartBackends(opts, producer.get(), consumer.get(), &startup))
+    {
+        return 1;
+    }
+    startup.setup = Elapsed(setupStart, Clock::now());
+    startup.cudaInitialize = cudaInitialized.get();
+
+    int status = opts.daemonSocket.empty() ? MeasureRun(opts, producer.get(), consumer.get(), audit, &startup)
+                                           : RunDaemon(opts, producer.get(), consumer.get(), audit, startup);
+
+    if (consumer)
+        consumer->Close();
+    producer->StopStreaming();
+    producer->Close();
+
+    return status;
+}